@@ -39,7 +39,7 @@ const cy_stc_scb_i2c_config_t DFU_I2C_config =
 	.slaveAddressMask = 254,
 	.acceptAddrInFifo = false,
 	.ackGeneralAddr = false,
-	.enableWakeFromSleep = false,
+	.enableWakeFromSleep = true,
 	.enableDigitalFilter = false,
 	.lowPhaseDutyCycle = 0,
 	.highPhaseDutyCycle = 0,
@@ -48,7 +48,7 @@ const cy_stc_scb_i2c_config_t DFU_I2C_config =
 	const cyhal_resource_inst_t DFU_I2C_obj = 
 	{
 		.type = CYHAL_RSC_SCB,
-		.block_num = 3U,
+		.block_num = 8U,
 		.channel_num = 0U,
 	};
 #endif //defined (CY_USING_HAL)
@@ -58,7 +58,7 @@ void init_cycfg_peripherals(void)
 {
 	Cy_SysClk_PeriphAssignDivider(PCLK_CSD_CLOCK, CY_SYSCLK_DIV_8_BIT, 0U);
 
-	Cy_SysClk_PeriphAssignDivider(PCLK_SCB3_CLOCK, CY_SYSCLK_DIV_8_BIT, 1U);
+	Cy_SysClk_PeriphAssignDivider(PCLK_SCB8_CLOCK, CY_SYSCLK_DIV_8_BIT, 1U);
 #if defined (CY_USING_HAL)
 	cyhal_hwmgr_reserve(&DFU_I2C_obj);
 #endif //defined (CY_USING_HAL)
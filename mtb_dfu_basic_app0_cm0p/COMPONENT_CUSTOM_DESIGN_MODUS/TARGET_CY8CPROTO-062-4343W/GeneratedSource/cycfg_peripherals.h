@@ -76,8 +76,8 @@ extern "C" {
 #define CYBSP_CSD_HW CSD0
 #define CYBSP_CSD_IRQ csd_interrupt_IRQn
 #define DFU_I2C_ENABLED 1U
-#define DFU_I2C_HW SCB3
-#define DFU_I2C_IRQ scb_3_interrupt_IRQn
+#define DFU_I2C_HW SCB8
+#define DFU_I2C_IRQ scb_8_interrupt_IRQn
 
 extern cy_stc_csd_context_t cy_csd_0_context;
 extern const cy_stc_scb_i2c_config_t DFU_I2C_config;
@@ -37,8 +37,8 @@ void init_cycfg_routing(void);
 #define ioss_0_port_0_pin_0_ANALOG P0_0_SRSS_WCO_IN
 #define ioss_0_port_0_pin_1_ANALOG P0_1_SRSS_WCO_OUT
 #define ioss_0_port_1_pin_0_HSIOM HSIOM_SEL_AMUXA
-#define ioss_0_port_6_pin_0_HSIOM P6_0_SCB3_I2C_SCL
-#define ioss_0_port_6_pin_1_HSIOM P6_1_SCB3_I2C_SDA
+#define ioss_0_port_6_pin_0_HSIOM P6_0_SCB8_I2C_SCL
+#define ioss_0_port_6_pin_1_HSIOM P6_1_SCB8_I2C_SDA
 #define ioss_0_port_6_pin_4_HSIOM P6_4_CPUSS_SWJ_SWO_TDO
 #define ioss_0_port_6_pin_6_HSIOM P6_6_CPUSS_SWJ_SWDIO_TMS
 #define ioss_0_port_6_pin_7_HSIOM P6_7_CPUSS_SWJ_SWCLK_TCLK
@@ -4,8 +4,11 @@
 *
 * This file provides App0 Core0 example source.
 * App0 Core0 firmware does the following:
+* - On a cold boot switches to a valid application slot with minimal
+*   initialization.
 * - Starts App0 Core1 firmware.
-* - If required switches to App1.
+* - If required switches to App1, on a software reset or on a request of
+*   App0 Core1.
 *
 ********************************************************************************
 * \copyright
@@ -19,6 +22,7 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "cy_dfu.h"
+#include "dfu_boot.h"
 
 #if CY_DFU_OPT_CRYPTO_HW != 0
     /* Scenario: Configure Server and Client as follows:
@@ -77,6 +81,66 @@
     cy_stc_crypto_server_context_t  myCryptoServerContext;
 #endif
 
+#if (DFU_BOOT_FAST_PATH != 0) && (CY_DFU_OPT_CRYPTO_HW == 0)
+static void FastBoot(void);
+
+/*******************************************************************************
+* Function Name: FastBoot
+********************************************************************************
+*
+* Summary:
+*  Cold boot fast path. On a non-software reset validates the metadata,
+*  selects the application slot to start, and switches to it with only the
+*  system clocks initialized.
+*  The software reset requested by App1 to start an update is not handled
+*  here, neither is the metadata repair: App0 Core1 takes care of both.
+*
+*  CLK_PERI and CLK_SLOW are set to CLK_HF0 for the slot validation, this
+*  core computes the checksum. cybsp_init() restores the divider.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Only if no application slot can be started this way.
+*
+*******************************************************************************/
+static void FastBoot(void)
+{
+    cy_stc_dfu_params_t dfuParams;
+    cy_en_dfu_status_t status;
+    uint32_t app = 0u;
+
+    if (Cy_SysLib_GetResetReason() != CY_SYSLIB_RESET_SOFT)
+    {
+        init_cycfg_system();
+        Cy_SysClk_ClkPeriSetDivider(0u);
+
+        /* The validation does not use the buffers */
+        dfuParams.timeout      = 0u;
+        dfuParams.dataBuffer   = NULL;
+        dfuParams.packetBuffer = NULL;
+
+        status = Cy_DFU_ValidateMetadata((uint32_t)(&__cy_boot_metadata_addr), &dfuParams);
+        if (status == CY_DFU_SUCCESS)
+        {
+            app = DFU_BootSelectApp(&dfuParams);
+        }
+        if (app != 0u)
+        {
+            /* Same as App0 Core1 does before switching to the application */
+            do
+            {
+                Cy_SysLib_ClearResetReason();
+            }while(Cy_SysLib_GetResetReason() != 0);
+
+            /* Never returns */
+            DFU_BootSwitchToApp(app);
+        }
+    }
+}
+#endif /* (DFU_BOOT_FAST_PATH != 0) && (CY_DFU_OPT_CRYPTO_HW == 0) */
+
 /*******************************************************************************
 * Function Name: main
 ********************************************************************************
@@ -95,6 +159,14 @@ int main(void)
 {
     cy_rslt_t result;
 
+#if DFU_BOOT_TIMING != 0
+    DFU_BootTimingStart();
+#endif
+
+#if (DFU_BOOT_FAST_PATH != 0) && (CY_DFU_OPT_CRYPTO_HW == 0)
+    FastBoot();
+#endif
+
     /* Initialize the device and board peripherals */
     result = cybsp_init() ;
     if (result != CY_RSLT_SUCCESS)
@@ -121,7 +193,30 @@ int main(void)
 
     for (;;)
     {
-        /* empty */
+    #if DFU_BOOT_TIMING != 0
+        /* Keeps counting while App0 Core1 runs, until it switches to App1 */
+        DFU_BootTimingUpdate();
+    #endif
+
+    #if DFU_BOOT_DIRECT_HANDOFF != 0
+        uint32_t appId;
+
+        /* App0 Core1 requested to switch to an application, it is disabled now */
+        if (DFU_BootHandoffRequested(&appId) != 0u)
+        {
+        #if CY_DFU_OPT_CRYPTO_HW != 0
+            (void) Cy_Crypto_Server_Stop();
+        #endif
+            /* Never returns */
+            DFU_BootSwitchToApp(appId);
+        }
+    #endif /* DFU_BOOT_DIRECT_HANDOFF != 0 */
+
+    #if (DFU_BOOT_DEEPSLEEP != 0) && (DFU_BOOT_TIMING == 0)
+        /* Let the system enter DeepSleep while Core1 waits for the host,
+         * Core1 sends an event with the handoff request */
+        (void) Cy_SysPm_CpuEnterDeepSleep(CY_SYSPM_WAIT_FOR_EVENT);
+    #endif
     }
 }
 
@@ -0,0 +1,427 @@
+/***************************************************************************//**
+* \file dfu_cmd.c
+* \version 1.0
+*
+* This file provides the custom DFU commands of App0, see dfu_cmd.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_dfu.h"
+#include "dfu_boot.h"
+#include "dfu_cmd.h"
+#include "dfu_qspi.h"
+#include "dfu_profile.h"
+#include "dfu_settings.h"
+#include "dfu_trace.h"
+#include "dfu_wear.h"
+
+/* The DFU packet format */
+#define CMD_SOP                 (0x01u)
+#define CMD_EOP                 (0x17u)
+#define CMD_CMD_IDX             (1u)
+#define CMD_SIZE_IDX            (2u)
+#define CMD_DATA_IDX            (4u)
+#define CMD_OVERHEAD            (7u)    /* SOP, command, size, checksum and EOP */
+
+/* The Verify Application command of the DFU SDK */
+#define CMD_VERIFY_APP          (0x31u)
+
+/* The largest response, the transmit buffer of the I2C transport */
+#define CMD_RESPONSE_SIZE       (64u)
+
+/* The trace events per DFU_CMD_TRACE response, after its 8 byte header */
+#define CMD_TRACE_EVENTS        (6u)
+
+/* The cache entries per DFU_CMD_CACHE_LIST response, after its 4 byte header */
+#define CMD_CACHE_ENTRIES       ((CMD_RESPONSE_SIZE - CMD_OVERHEAD - 4u) / sizeof(dfu_qspi_cache_entry_t))
+
+#if (DFU_QSPI_STAGING != 0) && (CY_DFU_OPT_CRYPTO_HW == 0)
+    /* The slot being installed from the staging area is verified here */
+    #define CMD_VERIFY_STAGED(app)  ( ((app) != 0u) && ((app) == DFU_QspiInstallingApp()) )
+#else
+    #define CMD_VERIFY_STAGED(app)  (false)
+#endif
+
+#if CY_DFU_OPT_PACKET_CRC != 0
+    #define CMD_CRC_CCITT_POLY  (0x8408u)
+    #define CMD_CRC_CCITT_INIT  (0xFFFFu)
+#endif
+
+/* The DFU parameters of App0, the data buffer is used by the commands */
+static cy_stc_dfu_params_t *dfu_cmdParams = NULL;
+
+/* The DFU SDK state of App0 */
+static const uint32_t *dfu_cmdState = NULL;
+
+/* 1 when a command was answered since DFU_CmdAnswered() */
+static uint32_t dfu_cmdAnswered = 0u;
+
+static uint32_t PacketChecksum(const uint8_t buffer[], uint32_t size);
+static uint32_t IsBetweenRows(void);
+static uint32_t Execute(uint32_t cmd, uint8_t data[], uint32_t size, uint32_t *rspSize);
+
+
+/*******************************************************************************
+* Function Name: PacketChecksum
+****************************************************************************//**
+*
+* This internal function computes the packet checksum as the DFU SDK does:
+* CRC-16-CCITT with CY_DFU_OPT_PACKET_CRC, else the 2's complement of the sum.
+*
+*******************************************************************************/
+static uint32_t PacketChecksum(const uint8_t buffer[], uint32_t size)
+{
+#if CY_DFU_OPT_PACKET_CRC != 0
+    uint32_t crc = CMD_CRC_CCITT_INIT;
+    uint32_t idx;
+    uint32_t bit;
+
+    for (idx = 0u; idx < size; ++idx)
+    {
+        crc ^= buffer[idx];
+        for (bit = 0u; bit < 8u; ++bit)
+        {
+            crc = ((crc & 1u) != 0u) ? ((crc >> 1u) ^ CMD_CRC_CCITT_POLY) : (crc >> 1u);
+        }
+    }
+    return ((~crc) & 0xFFFFu);
+#else
+    uint32_t sum = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < size; ++idx)
+    {
+        sum += buffer[idx];
+    }
+    return ((1u + ~sum) & 0xFFFFu);
+#endif /* CY_DFU_OPT_PACKET_CRC != 0 */
+}
+
+
+/*******************************************************************************
+* Function Name: IsBetweenRows
+****************************************************************************//**
+*
+* This internal function returns 1 if a command may write the flash through
+* the data buffer: the host has entered the DFU session, so the product ID is
+* checked, and no row is being assembled with Send Data.
+*
+*******************************************************************************/
+static uint32_t IsBetweenRows(void)
+{
+    return ( (dfu_cmdState != NULL) && (*dfu_cmdState == CY_DFU_STATE_UPDATING)
+          && (dfu_cmdParams->dataOffset == 0u) ) ? 1u : 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: Execute
+****************************************************************************//**
+*
+* This internal function executes a custom command.
+*
+* \param cmd        The command.
+* \param data       The command data, replaced by the response data.
+* \param size       The size of the command data.
+* \param rspSize    The pointer to a variable where the size of the response
+*                   data is stored.
+*
+* \return The status code of the response.
+*
+*******************************************************************************/
+static uint32_t Execute(uint32_t cmd, uint8_t data[], uint32_t size, uint32_t *rspSize)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_CMD;
+
+    *rspSize = 0u;
+
+#if (DFU_QSPI_STAGING != 0) && (CY_DFU_OPT_CRYPTO_HW == 0)
+    if (cmd == CMD_VERIFY_APP)
+    {
+        /* The response data is 1 if the image is valid, as the DFU SDK sends it */
+        status = (size == 1u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            data[0]  = (DFU_QspiVerifyStaged(data[0]) == CY_DFU_SUCCESS) ? 1u : 0u;
+            *rspSize = 1u;
+        }
+    }
+    else
+#endif /* (DFU_QSPI_STAGING != 0) && (CY_DFU_OPT_CRYPTO_HW == 0) */
+#if DFU_QSPI_CACHE != 0
+    if (cmd == DFU_CMD_CACHE_LIST)
+    {
+        dfu_qspi_cache_entry_t entries[DFU_QSPI_CACHE_ENTRIES];
+        uint32_t first = (size == 1u) ? data[0] : 0u;
+        uint32_t total;
+        uint32_t count;
+
+        status = (size <= 1u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            /* The entries from the first one asked, as many as the response holds */
+            total = DFU_QspiCacheList(entries, DFU_QSPI_CACHE_ENTRIES);
+            count = 0u;
+            (void) memcpy(&data[0u], &total, sizeof(total));
+            if (first < total)
+            {
+                count = total - first;
+                count = (count < CMD_CACHE_ENTRIES) ? count : CMD_CACHE_ENTRIES;
+                (void) memcpy(&data[4u], &entries[first], count * sizeof(entries[0]));
+            }
+            *rspSize = 4u + (count * sizeof(entries[0]));
+        }
+    }
+    else if (cmd == DFU_CMD_CACHE_RESTORE)
+    {
+        uint32_t version;
+
+        status = (size == sizeof(version)) ? CY_DFU_SUCCESS : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            (void) memcpy(&version, data, sizeof(version));
+            status = DFU_QspiCacheRestore(version, dfu_cmdParams);
+        }
+    }
+    else
+#endif /* DFU_QSPI_CACHE != 0 */
+#if DFU_BOOT_XIP != 0
+    if (cmd == DFU_CMD_XIP_RATE)
+    {
+        dfu_qspi_xip_rate_t rate;
+
+        status = (size == 0u) ? DFU_QspiXipRate(&rate) : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            *rspSize = sizeof(rate);
+            (void) memcpy(data, &rate, sizeof(rate));
+        }
+    }
+    else
+#endif /* DFU_BOOT_XIP != 0 */
+#if DFU_BOOT_PROFILE != 0
+    if (cmd == DFU_CMD_PROFILE)
+    {
+        dfu_profile_stats_t stats;
+
+        status = ( (size == 1u) || (size == 2u) ) ? DFU_ProfileGet(data[0], &stats) : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            if ( (size == 2u) && (data[1] != 0u) )
+            {
+                DFU_ProfileClear(data[0]);
+            }
+            *rspSize = sizeof(stats);
+            (void) memcpy(data, &stats, sizeof(stats));
+        }
+    }
+    else
+#endif /* DFU_BOOT_PROFILE != 0 */
+#if DFU_BOOT_TRACE != 0
+    if (cmd == DFU_CMD_TRACE)
+    {
+        dfu_trace_event_t events[CMD_TRACE_EVENTS];
+        uint32_t first;
+        uint32_t next;
+        uint32_t count;
+
+        status = (size == sizeof(first)) ? CY_DFU_SUCCESS : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            (void) memcpy(&first, data, sizeof(first));
+            count = DFU_TraceRead(&first, events, CMD_TRACE_EVENTS, &next);
+            (void) memcpy(&data[0u], &next, sizeof(next));
+            (void) memcpy(&data[4u], &first, sizeof(first));
+            (void) memcpy(&data[8u], events, count * sizeof(events[0]));
+            *rspSize = 8u + (count * sizeof(events[0]));
+        }
+    }
+    else
+#endif /* DFU_BOOT_TRACE != 0 */
+#if DFU_BOOT_WEAR != 0
+    if (cmd == DFU_CMD_WEAR)
+    {
+        dfu_wear_counters_t counters;
+        uint32_t commits;
+
+        status = (size == 1u) ? DFU_WearGet(data[0], &counters, &commits) : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            (void) memcpy(&data[0u], &counters, sizeof(counters));
+            (void) memcpy(&data[sizeof(counters)], &commits, sizeof(commits));
+            *rspSize = sizeof(counters) + sizeof(commits);
+        }
+    }
+    else
+#endif /* DFU_BOOT_WEAR != 0 */
+    if (cmd == DFU_CMD_SETTINGS_GET)
+    {
+        dfu_setting_t settings[DFU_SETTINGS_COUNT];
+
+        status = (size == 0u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            *rspSize = DFU_SettingsList(settings, DFU_SETTINGS_COUNT) * sizeof(settings[0]);
+            (void) memcpy(data, settings, *rspSize);
+        }
+    }
+    else if (cmd == DFU_CMD_SETTINGS_SET)
+    {
+        dfu_setting_t settings[DFU_SETTINGS_COUNT];
+
+        status = ( (size != 0u) && ((size % sizeof(settings[0])) == 0u) && (size <= sizeof(settings)) )
+                 ? CY_DFU_SUCCESS : CY_DFU_ERROR_LENGTH;
+        if (status == CY_DFU_SUCCESS)
+        {
+            (void) memcpy(settings, data, size);
+            status = DFU_SettingsSet(settings, size / sizeof(settings[0]), dfu_cmdParams);
+        }
+    }
+    else
+    {
+        /* Not a custom command, or not enabled */
+        (void) cmd;
+        (void) data;
+        (void) size;
+    }
+
+    return ((uint32_t)status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_CmdInit
+****************************************************************************//**
+*
+* Enables the custom commands.
+*
+* \param params     The pointer to the DFU parameters structure of App0,
+*                   its dataBuffer is used by the commands.
+* \param state      The pointer to the DFU SDK state of App0.
+*
+*******************************************************************************/
+void DFU_CmdInit(cy_stc_dfu_params_t *params, const uint32_t *state)
+{
+    dfu_cmdParams = params;
+    dfu_cmdState  = state;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_CmdAnswered
+****************************************************************************//**
+*
+* Returns whether a custom command was answered since the previous call. The
+* DFU SDK does not see them, App0 restarts its session timeout with it.
+*
+* \return 1 if a command was answered, else 0.
+*
+*******************************************************************************/
+uint32_t DFU_CmdAnswered(void)
+{
+    uint32_t answered = dfu_cmdAnswered;
+
+    dfu_cmdAnswered = 0u;
+    return (answered);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_CmdHandle
+****************************************************************************//**
+*
+* Called by the transport with each packet received. Executes a custom
+* command, or the Verify Application command of the slot being installed
+* from the QSPI staging area, and sends the response in the same buffer.
+* With CY_DFU_OPT_CRYPTO_HW the install is finished before the DFU SDK
+* verifies the slot.
+*
+* \param packet     The packet, at least CY_DFU_SIZEOF_CMD_BUFFER bytes.
+* \param size       The number of bytes received.
+*
+* \return 1 - the packet is a custom command and is answered, else 0:
+*         the packet is for the DFU SDK.
+*
+*******************************************************************************/
+uint32_t DFU_CmdHandle(uint8_t packet[], uint32_t size)
+{
+    uint32_t handled = 0u;
+
+#if (DFU_QSPI_STAGING != 0) && (CY_DFU_OPT_CRYPTO_HW != 0)
+    /* The DFU SDK validates the signature of the slot in the internal flash */
+    if ( (size >= CMD_OVERHEAD) && (packet[0] == CMD_SOP) && (packet[CMD_CMD_IDX] == CMD_VERIFY_APP) )
+    {
+        (void) DFU_QspiInstall();
+    }
+#endif
+
+    if ( (dfu_cmdParams != NULL) && (size >= CMD_OVERHEAD) && (packet[0] == CMD_SOP)
+      && ( (packet[CMD_CMD_IDX] == DFU_CMD_CACHE_LIST) || (packet[CMD_CMD_IDX] == DFU_CMD_CACHE_RESTORE)
+        || (packet[CMD_CMD_IDX] == DFU_CMD_XIP_RATE) || (packet[CMD_CMD_IDX] == DFU_CMD_SETTINGS_GET)
+        || (packet[CMD_CMD_IDX] == DFU_CMD_SETTINGS_SET) || (packet[CMD_CMD_IDX] == DFU_CMD_PROFILE)
+        || (packet[CMD_CMD_IDX] == DFU_CMD_TRACE) || (packet[CMD_CMD_IDX] == DFU_CMD_WEAR)
+        || ( (packet[CMD_CMD_IDX] == CMD_VERIFY_APP) && CMD_VERIFY_STAGED(packet[CMD_DATA_IDX]) ) ) )
+    {
+        uint32_t dataSize = (uint32_t)packet[CMD_SIZE_IDX] | ((uint32_t)packet[CMD_SIZE_IDX + 1u] << 8u);
+        uint32_t rspSize = 0u;
+        uint32_t status;
+        uint32_t checksum;
+        uint32_t count;
+
+        if ( ((dataSize + CMD_OVERHEAD) > size) || (packet[dataSize + CMD_OVERHEAD - 1u] != CMD_EOP) )
+        {
+            status = (uint32_t)CY_DFU_ERROR_LENGTH;
+        }
+        else
+        {
+            checksum = (uint32_t)packet[CMD_DATA_IDX + dataSize]
+                     | ((uint32_t)packet[CMD_DATA_IDX + dataSize + 1u] << 8u);
+            if (checksum != PacketChecksum(packet, CMD_DATA_IDX + dataSize))
+            {
+                status = (uint32_t)CY_DFU_ERROR_CHECKSUM;
+            }
+            else if ( ( (packet[CMD_CMD_IDX] == DFU_CMD_SETTINGS_SET) || (packet[CMD_CMD_IDX] == DFU_CMD_CACHE_RESTORE) )
+                   && (IsBetweenRows() == 0u) )
+            {
+                /* They write the flash through the data buffer */
+                status = (uint32_t)CY_DFU_ERROR_CMD;
+            }
+            else
+            {
+                status = Execute(packet[CMD_CMD_IDX], &packet[CMD_DATA_IDX], dataSize, &rspSize);
+            }
+        }
+        if ((rspSize + CMD_OVERHEAD) > CMD_RESPONSE_SIZE)
+        {
+            /* Never sent, the transport can not hold it */
+            status  = (uint32_t)CY_DFU_ERROR_LENGTH;
+            rspSize = 0u;
+        }
+
+        /* The response has the packet format, the status is in place of the command.
+         * With DFU_BOOT_SINGLE_BUFFER the data buffer the command used overlaps the packet */
+        packet[0]                 = CMD_SOP;
+        packet[CMD_CMD_IDX]       = (uint8_t)status;
+        packet[CMD_SIZE_IDX]      = (uint8_t)rspSize;
+        packet[CMD_SIZE_IDX + 1u] = (uint8_t)(rspSize >> 8u);
+        checksum = PacketChecksum(packet, CMD_DATA_IDX + rspSize);
+        packet[CMD_DATA_IDX + rspSize]      = (uint8_t)checksum;
+        packet[CMD_DATA_IDX + rspSize + 1u] = (uint8_t)(checksum >> 8u);
+        packet[CMD_DATA_IDX + rspSize + 2u] = CMD_EOP;
+
+        (void) Cy_DFU_TransportWrite(packet, rspSize + CMD_OVERHEAD, &count, dfu_cmdParams->timeout);
+        dfu_cmdAnswered = 1u;
+        handled = 1u;
+    }
+    return (handled);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,105 @@
+/***************************************************************************//**
+* \file dfu_cmd.h
+* \version 1.0
+*
+* This file provides the API of the custom DFU commands of App0.
+*
+* The DFU SDK answers an unknown command with an error, so the custom
+* commands are taken out of the packet stream before it: the transport passes
+* each packet it receives to DFU_CmdHandle(). A custom command is answered
+* there, and the DFU SDK sees a read timeout instead. The packets have the
+* DFU SDK format and checksum, and may be sent in any DFU state, except
+* DFU_CMD_SETTINGS_SET and DFU_CMD_CACHE_RESTORE: they write the flash
+* through the DFU data buffer, so they need the session entered with the
+* Enter DFU command, and they are refused with CY_DFU_ERROR_CMD before, or
+* while a row is sent with Send Data. A response is 64 bytes at most, the
+* size of the transmit buffer of the transport.
+*
+* With DFU_QSPI_STAGING the Verify Application command of the slot being
+* installed from the staging area is answered here too, from the staged
+* image, so the host does not wait for the rows copied to the internal flash,
+* see DFU_QspiVerifyStaged().
+*
+* Commands:
+* - DFU_CMD_CACHE_LIST: no data, or 1 byte, the first entry to read. The
+*   response data is the number of cached images, 4 bytes, then up to 2
+*   dfu_qspi_cache_entry_t of the cache directory from the first entry.
+* - DFU_CMD_CACHE_RESTORE: 4 bytes, the cache version to restore. Restores
+*   the image to its slot, see DFU_QspiCacheRestore(). When the host then
+*   sends the Exit command, App0 makes the slot active and starts it, as for
+*   a download.
+* - DFU_CMD_XIP_RATE: no data. Measures the XIP read rates, the response data
+*   is a dfu_qspi_xip_rate_t, see DFU_QspiXipRate().
+* - DFU_CMD_SETTINGS_GET: no data. The response data is the settings set,
+*   one dfu_setting_t per key, see dfu_settings.h.
+* - DFU_CMD_SETTINGS_SET: one dfu_setting_t per setting to change. Stores the
+*   settings, they take effect at the next start.
+* - DFU_CMD_PROFILE: 1 byte, a phase of dfu_profile.h, then optionally 1 byte,
+*   non-zero to clear the figures of the phase once read. The response data
+*   is a dfu_profile_stats_t. Needs DFU_BOOT_PROFILE.
+* - DFU_CMD_TRACE: 4 bytes, the number of the first trace event to read. The
+*   response data is the number of the next event recorded and of the first
+*   event returned, 4 bytes each, then up to 6 dfu_trace_event_t from it,
+*   see dfu_trace.h. Needs DFU_BOOT_TRACE.
+* - DFU_CMD_WEAR: 1 byte, a region of dfu_wear.h. The response data is the
+*   dfu_wear_counters_t of the region, then the number of commits of the
+*   counters, 4 bytes. Needs DFU_BOOT_WEAR.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_CMD_H)
+#define DFU_CMD_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** Reads the firmware cache directory */
+#define DFU_CMD_CACHE_LIST          (0x50u)
+
+/** Restores an image from the firmware cache */
+#define DFU_CMD_CACHE_RESTORE       (0x51u)
+
+/** Measures the XIP read rates */
+#define DFU_CMD_XIP_RATE            (0x52u)
+
+/** Reads the bootloader settings */
+#define DFU_CMD_SETTINGS_GET        (0x53u)
+
+/** Changes the bootloader settings */
+#define DFU_CMD_SETTINGS_SET        (0x54u)
+
+/** Reads the DFU phase profile */
+#define DFU_CMD_PROFILE             (0x55u)
+
+/** Reads the DFU trace */
+#define DFU_CMD_TRACE               (0x56u)
+
+/** Reads the flash wear counters */
+#define DFU_CMD_WEAR                (0x57u)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_CmdInit(cy_stc_dfu_params_t *params, const uint32_t *state);
+uint32_t DFU_CmdAnswered(void);
+uint32_t DFU_CmdHandle(uint8_t packet[], uint32_t size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_CMD_H) */
+
+
+/* [] END OF FILE */
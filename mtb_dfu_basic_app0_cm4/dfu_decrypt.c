@@ -0,0 +1,345 @@
+/***************************************************************************//**
+* \file dfu_decrypt.c
+* \version 1.0
+*
+* This file provides the in place AES-128 CTR decryption of the Program Data
+* payloads, see dfu_decrypt.h for the counter block format.
+*
+* When CY_DFU_OPT_CRYPTO_HW is enabled the keystream is produced by the
+* Crypto block, through the Crypto server running on CM0+. Otherwise a small
+* table based software AES is used. Both produce the same result, so the host
+* side does not depend on the option.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "dfu_decrypt.h"
+
+#if CY_DFU_OPT_ENCRYPTED_DATA != 0
+
+#if CY_DFU_OPT_SET_EIVECTOR == 0
+    #error CY_DFU_OPT_ENCRYPTED_DATA requires CY_DFU_OPT_SET_EIVECTOR to receive the initial counter block.
+#endif
+
+#if CY_DFU_OPT_CRYPTO_HW != 0
+    #include "cy_crypto.h"
+#endif
+
+/* The number of AES-128 rounds */
+#define AES_ROUNDS              (10u)
+
+/* The size of the expanded AES-128 key, in bytes */
+#define AES_KEY_SCHEDULE_SIZE   (DFU_DECRYPT_BLOCK_SIZE * (AES_ROUNDS + 1u))
+
+/* The index of the first byte of the 32-bit counter in the counter block */
+#define CTR_COUNTER_IDX         (12u)
+
+/*
+* The AES-128 key shared with the host, DFU_DECRYPT_KEY, see dfu_decrypt.h.
+* There is no default key: a key known to anyone, e.g. the SP800-38A test key,
+* would only hide the images from the device.
+*/
+#if !defined(DFU_DECRYPT_KEY)
+    #error CY_DFU_OPT_ENCRYPTED_DATA requires DFU_DECRYPT_KEY, the 16 bytes of the AES-128 key shared with the host.
+#endif
+
+CY_ALIGN(4) static const uint8_t DFU_decryptKey[DFU_DECRYPT_BLOCK_SIZE] =
+{
+    DFU_DECRYPT_KEY
+};
+
+#if CY_DFU_OPT_CRYPTO_HW != 0
+
+/* The Crypto client AES context, initialized with the key on the first use */
+static cy_stc_crypto_context_aes_t DFU_aesContext;
+
+#else
+
+/* The AES forward S-box */
+static const uint8_t DFU_sbox[256] =
+{
+    0x63u, 0x7Cu, 0x77u, 0x7Bu, 0xF2u, 0x6Bu, 0x6Fu, 0xC5u, 0x30u, 0x01u, 0x67u, 0x2Bu, 0xFEu, 0xD7u, 0xABu, 0x76u,
+    0xCAu, 0x82u, 0xC9u, 0x7Du, 0xFAu, 0x59u, 0x47u, 0xF0u, 0xADu, 0xD4u, 0xA2u, 0xAFu, 0x9Cu, 0xA4u, 0x72u, 0xC0u,
+    0xB7u, 0xFDu, 0x93u, 0x26u, 0x36u, 0x3Fu, 0xF7u, 0xCCu, 0x34u, 0xA5u, 0xE5u, 0xF1u, 0x71u, 0xD8u, 0x31u, 0x15u,
+    0x04u, 0xC7u, 0x23u, 0xC3u, 0x18u, 0x96u, 0x05u, 0x9Au, 0x07u, 0x12u, 0x80u, 0xE2u, 0xEBu, 0x27u, 0xB2u, 0x75u,
+    0x09u, 0x83u, 0x2Cu, 0x1Au, 0x1Bu, 0x6Eu, 0x5Au, 0xA0u, 0x52u, 0x3Bu, 0xD6u, 0xB3u, 0x29u, 0xE3u, 0x2Fu, 0x84u,
+    0x53u, 0xD1u, 0x00u, 0xEDu, 0x20u, 0xFCu, 0xB1u, 0x5Bu, 0x6Au, 0xCBu, 0xBEu, 0x39u, 0x4Au, 0x4Cu, 0x58u, 0xCFu,
+    0xD0u, 0xEFu, 0xAAu, 0xFBu, 0x43u, 0x4Du, 0x33u, 0x85u, 0x45u, 0xF9u, 0x02u, 0x7Fu, 0x50u, 0x3Cu, 0x9Fu, 0xA8u,
+    0x51u, 0xA3u, 0x40u, 0x8Fu, 0x92u, 0x9Du, 0x38u, 0xF5u, 0xBCu, 0xB6u, 0xDAu, 0x21u, 0x10u, 0xFFu, 0xF3u, 0xD2u,
+    0xCDu, 0x0Cu, 0x13u, 0xECu, 0x5Fu, 0x97u, 0x44u, 0x17u, 0xC4u, 0xA7u, 0x7Eu, 0x3Du, 0x64u, 0x5Du, 0x19u, 0x73u,
+    0x60u, 0x81u, 0x4Fu, 0xDCu, 0x22u, 0x2Au, 0x90u, 0x88u, 0x46u, 0xEEu, 0xB8u, 0x14u, 0xDEu, 0x5Eu, 0x0Bu, 0xDBu,
+    0xE0u, 0x32u, 0x3Au, 0x0Au, 0x49u, 0x06u, 0x24u, 0x5Cu, 0xC2u, 0xD3u, 0xACu, 0x62u, 0x91u, 0x95u, 0xE4u, 0x79u,
+    0xE7u, 0xC8u, 0x37u, 0x6Du, 0x8Du, 0xD5u, 0x4Eu, 0xA9u, 0x6Cu, 0x56u, 0xF4u, 0xEAu, 0x65u, 0x7Au, 0xAEu, 0x08u,
+    0xBAu, 0x78u, 0x25u, 0x2Eu, 0x1Cu, 0xA6u, 0xB4u, 0xC6u, 0xE8u, 0xDDu, 0x74u, 0x1Fu, 0x4Bu, 0xBDu, 0x8Bu, 0x8Au,
+    0x70u, 0x3Eu, 0xB5u, 0x66u, 0x48u, 0x03u, 0xF6u, 0x0Eu, 0x61u, 0x35u, 0x57u, 0xB9u, 0x86u, 0xC1u, 0x1Du, 0x9Eu,
+    0xE1u, 0xF8u, 0x98u, 0x11u, 0x69u, 0xD9u, 0x8Eu, 0x94u, 0x9Bu, 0x1Eu, 0x87u, 0xE9u, 0xCEu, 0x55u, 0x28u, 0xDFu,
+    0x8Cu, 0xA1u, 0x89u, 0x0Du, 0xBFu, 0xE6u, 0x42u, 0x68u, 0x41u, 0x99u, 0x2Du, 0x0Fu, 0xB0u, 0x54u, 0xBBu, 0x16u
+};
+
+/* The expanded key, computed on the first use */
+static uint8_t DFU_roundKeys[AES_KEY_SCHEDULE_SIZE];
+
+#endif /* CY_DFU_OPT_CRYPTO_HW != 0 */
+
+/* Non-zero when the key has been loaded */
+static uint32_t DFU_keyReady = 0u;
+
+
+static void CounterAdd(uint8_t counter[], uint32_t value);
+#if CY_DFU_OPT_CRYPTO_HW == 0
+static uint8_t XTime(uint8_t value);
+static void AesExpandKey(const uint8_t key[]);
+static void AesEncryptBlock(const uint8_t in[], uint8_t out[]);
+#endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+
+
+/*******************************************************************************
+* Function Name: CounterAdd
+****************************************************************************//**
+*
+* Adds a value to the 32-bit big-endian counter of a counter block.
+* The nonce part of the block is not changed, the counter wraps around.
+*
+* \param counter    The 16-byte counter block.
+* \param value      The value to add.
+*
+*******************************************************************************/
+static void CounterAdd(uint8_t counter[], uint32_t value)
+{
+    uint32_t count = ((uint32_t)counter[CTR_COUNTER_IDX     ] << 24u)
+                   | ((uint32_t)counter[CTR_COUNTER_IDX + 1u] << 16u)
+                   | ((uint32_t)counter[CTR_COUNTER_IDX + 2u] <<  8u)
+                   |  (uint32_t)counter[CTR_COUNTER_IDX + 3u];
+
+    count += value;
+
+    counter[CTR_COUNTER_IDX     ] = (uint8_t)(count >> 24u);
+    counter[CTR_COUNTER_IDX + 1u] = (uint8_t)(count >> 16u);
+    counter[CTR_COUNTER_IDX + 2u] = (uint8_t)(count >>  8u);
+    counter[CTR_COUNTER_IDX + 3u] = (uint8_t)(count       );
+}
+
+
+#if CY_DFU_OPT_CRYPTO_HW == 0
+
+/*******************************************************************************
+* Function Name: XTime
+****************************************************************************//**
+*
+* Multiplies a value by x in GF(2^8).
+*
+*******************************************************************************/
+static uint8_t XTime(uint8_t value)
+{
+    return ((uint8_t)((uint32_t)value << 1u) ^ (((value & 0x80u) != 0u) ? 0x1Bu : 0x00u));
+}
+
+
+/*******************************************************************************
+* Function Name: AesExpandKey
+****************************************************************************//**
+*
+* Computes the AES-128 key schedule into DFU_roundKeys.
+*
+* \param key    The 16-byte cipher key.
+*
+*******************************************************************************/
+static void AesExpandKey(const uint8_t key[])
+{
+    uint32_t idx;
+    uint8_t rcon = 0x01u;
+
+    (void) memcpy(DFU_roundKeys, key, DFU_DECRYPT_BLOCK_SIZE);
+
+    for (idx = DFU_DECRYPT_BLOCK_SIZE; idx < AES_KEY_SCHEDULE_SIZE; idx += 4u)
+    {
+        uint8_t word[4];
+
+        word[0] = DFU_roundKeys[idx - 4u];
+        word[1] = DFU_roundKeys[idx - 3u];
+        word[2] = DFU_roundKeys[idx - 2u];
+        word[3] = DFU_roundKeys[idx - 1u];
+
+        if ((idx % DFU_DECRYPT_BLOCK_SIZE) == 0u)
+        {
+            /* RotWord, SubWord and Rcon */
+            uint8_t first = word[0];
+            word[0] = DFU_sbox[word[1]] ^ rcon;
+            word[1] = DFU_sbox[word[2]];
+            word[2] = DFU_sbox[word[3]];
+            word[3] = DFU_sbox[first];
+            rcon = XTime(rcon);
+        }
+
+        DFU_roundKeys[idx     ] = DFU_roundKeys[idx - DFU_DECRYPT_BLOCK_SIZE     ] ^ word[0];
+        DFU_roundKeys[idx + 1u] = DFU_roundKeys[idx - DFU_DECRYPT_BLOCK_SIZE + 1u] ^ word[1];
+        DFU_roundKeys[idx + 2u] = DFU_roundKeys[idx - DFU_DECRYPT_BLOCK_SIZE + 2u] ^ word[2];
+        DFU_roundKeys[idx + 3u] = DFU_roundKeys[idx - DFU_DECRYPT_BLOCK_SIZE + 3u] ^ word[3];
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: AesEncryptBlock
+****************************************************************************//**
+*
+* Encrypts one block with the expanded key. CTR mode only needs the forward
+* cipher, so there is no decryption counterpart.
+*
+* \param in     The 16-byte input block.
+* \param out    The 16-byte output block, may not overlap the input.
+*
+*******************************************************************************/
+static void AesEncryptBlock(const uint8_t in[], uint8_t out[])
+{
+    uint8_t state[DFU_DECRYPT_BLOCK_SIZE];
+    uint32_t round;
+    uint32_t idx;
+
+    for (idx = 0u; idx < DFU_DECRYPT_BLOCK_SIZE; ++idx)
+    {
+        state[idx] = in[idx] ^ DFU_roundKeys[idx];
+    }
+
+    for (round = 1u; round <= AES_ROUNDS; ++round)
+    {
+        const uint8_t *roundKey = &DFU_roundKeys[round * DFU_DECRYPT_BLOCK_SIZE];
+
+        /* SubBytes and ShiftRows, the state is stored column by column */
+        out[ 0] = DFU_sbox[state[ 0]]; out[ 4] = DFU_sbox[state[ 4]]; out[ 8] = DFU_sbox[state[ 8]]; out[12] = DFU_sbox[state[12]];
+        out[ 1] = DFU_sbox[state[ 5]]; out[ 5] = DFU_sbox[state[ 9]]; out[ 9] = DFU_sbox[state[13]]; out[13] = DFU_sbox[state[ 1]];
+        out[ 2] = DFU_sbox[state[10]]; out[ 6] = DFU_sbox[state[14]]; out[10] = DFU_sbox[state[ 2]]; out[14] = DFU_sbox[state[ 6]];
+        out[ 3] = DFU_sbox[state[15]]; out[ 7] = DFU_sbox[state[ 3]]; out[11] = DFU_sbox[state[ 7]]; out[15] = DFU_sbox[state[11]];
+
+        if (round != AES_ROUNDS)
+        {
+            /* MixColumns */
+            for (idx = 0u; idx < DFU_DECRYPT_BLOCK_SIZE; idx += 4u)
+            {
+                uint8_t a0 = out[idx];
+                uint8_t a1 = out[idx + 1u];
+                uint8_t a2 = out[idx + 2u];
+                uint8_t a3 = out[idx + 3u];
+                uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+
+                out[idx     ] = a0 ^ all ^ XTime(a0 ^ a1);
+                out[idx + 1u] = a1 ^ all ^ XTime(a1 ^ a2);
+                out[idx + 2u] = a2 ^ all ^ XTime(a2 ^ a3);
+                out[idx + 3u] = a3 ^ all ^ XTime(a3 ^ a0);
+            }
+        }
+
+        /* AddRoundKey */
+        for (idx = 0u; idx < DFU_DECRYPT_BLOCK_SIZE; ++idx)
+        {
+            state[idx] = out[idx] ^ roundKey[idx];
+        }
+    }
+
+    (void) memcpy(out, state, DFU_DECRYPT_BLOCK_SIZE);
+}
+
+#endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+
+
+/*******************************************************************************
+* Function Name: DFU_DecryptData
+****************************************************************************//**
+*
+* Decrypts a block of Program Data payload in place.
+*
+* \param address    The NVM address the data is going to be written to.
+*                   Must be a multiple of the AES block size.
+* \param data       The data to decrypt, replaced with the plain data.
+*                   Must be 4-byte aligned.
+* \param length     The data length, a multiple of the AES block size.
+* \param eiv        The initial counter block received with the
+*                   Set EI Vector command.
+*
+* \return
+* - CY_DFU_SUCCESS when the data is decrypted.
+* - CY_DFU_ERROR_LENGTH if the address or length are not block aligned.
+* - CY_DFU_ERROR_DATA if the Crypto block reports an error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_DecryptData(uint32_t address, uint8_t data[], uint32_t length, const uint8_t eiv[])
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    CY_ALIGN(4) uint8_t counter[DFU_DECRYPT_BLOCK_SIZE];
+
+    if ( ((address % DFU_DECRYPT_BLOCK_SIZE) != 0u) || ((length % DFU_DECRYPT_BLOCK_SIZE) != 0u) )
+    {
+        status = CY_DFU_ERROR_LENGTH;
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        (void) memcpy(counter, eiv, DFU_DECRYPT_BLOCK_SIZE);
+        CounterAdd(counter, address / DFU_DECRYPT_BLOCK_SIZE);
+
+#if CY_DFU_OPT_CRYPTO_HW != 0
+        {
+            CY_ALIGN(4) uint8_t streamBlock[DFU_DECRYPT_BLOCK_SIZE];
+            uint32_t srcOffset = 0u;
+            cy_en_crypto_status_t cryptoStatus = CY_CRYPTO_SUCCESS;
+
+            if (DFU_keyReady == 0u)
+            {
+                cryptoStatus = Cy_Crypto_Aes_Init((uint32_t *)DFU_decryptKey, CY_CRYPTO_KEY_AES_128, &DFU_aesContext);
+                if (cryptoStatus == CY_CRYPTO_SUCCESS)
+                {
+                    cryptoStatus = Cy_Crypto_Sync(CY_CRYPTO_SYNC_BLOCKING);
+                }
+                DFU_keyReady = (cryptoStatus == CY_CRYPTO_SUCCESS) ? 1u : 0u;
+            }
+
+            /* The Crypto block advances the counter as a big-endian value, one step per block */
+            if (cryptoStatus == CY_CRYPTO_SUCCESS)
+            {
+                cryptoStatus = Cy_Crypto_Aes_Ctr(length, &srcOffset, (uint32_t *)counter, (uint32_t *)streamBlock,
+                                                 (uint32_t *)data, (uint32_t *)data, &DFU_aesContext);
+            }
+            if (cryptoStatus == CY_CRYPTO_SUCCESS)
+            {
+                cryptoStatus = Cy_Crypto_Sync(CY_CRYPTO_SYNC_BLOCKING);
+            }
+            status = (cryptoStatus == CY_CRYPTO_SUCCESS) ? CY_DFU_SUCCESS : CY_DFU_ERROR_DATA;
+        }
+#else
+        {
+            uint8_t keyStream[DFU_DECRYPT_BLOCK_SIZE];
+            uint32_t offset;
+            uint32_t idx;
+
+            if (DFU_keyReady == 0u)
+            {
+                AesExpandKey(DFU_decryptKey);
+                DFU_keyReady = 1u;
+            }
+
+            for (offset = 0u; offset < length; offset += DFU_DECRYPT_BLOCK_SIZE)
+            {
+                AesEncryptBlock(counter, keyStream);
+                for (idx = 0u; idx < DFU_DECRYPT_BLOCK_SIZE; ++idx)
+                {
+                    data[offset + idx] ^= keyStream[idx];
+                }
+                CounterAdd(counter, 1u);
+            }
+        }
+#endif /* CY_DFU_OPT_CRYPTO_HW != 0 */
+    }
+
+    return (status);
+}
+
+#endif /* CY_DFU_OPT_ENCRYPTED_DATA != 0 */
+
+
+/* [] END OF FILE */
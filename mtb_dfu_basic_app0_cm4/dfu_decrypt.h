@@ -0,0 +1,62 @@
+/***************************************************************************//**
+* \file dfu_decrypt.h
+* \version 1.0
+*
+* This file provides the API to decrypt the Program Data payloads of an
+* encrypted DFU session in place, before they are written to NVM.
+*
+* The payloads are encrypted by the host with AES-128 in counter (CTR) mode.
+* The initial counter block is sent by the host with the Set EI Vector DFU
+* command: 12 bytes of nonce followed by a 32-bit big-endian counter.
+* Each row is encrypted with the counter advanced by (row address / 16), so
+* every row can be decrypted on its own, in any order:
+* \code
+*   counter(address) = EIV + (address >> 4)
+* \endcode
+*
+* The key is provisioned at build time with DFU_DECRYPT_KEY, its 16 bytes
+* separated by commas, e.g. in the App0 CM4 Makefile:
+* \code
+*   DEFINES+=DFU_DECRYPT_KEY=0x01u,0x23u,...,0xEFu
+* \endcode
+* The build fails without it. Production devices should rather keep the key
+* in a protected area than in the App0 image.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_DECRYPT_H)
+#define DFU_DECRYPT_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The AES block size, in bytes */
+#define DFU_DECRYPT_BLOCK_SIZE     (16u)
+
+/** The size of the Set EI Vector payload used as the initial counter block */
+#define DFU_DECRYPT_EIV_SIZE       (16u)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+cy_en_dfu_status_t DFU_DecryptData(uint32_t address, uint8_t data[], uint32_t length, const uint8_t eiv[]);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_DECRYPT_H) */
+
+
+/* [] END OF FILE */
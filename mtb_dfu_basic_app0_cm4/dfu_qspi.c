@@ -0,0 +1,1547 @@
+/***************************************************************************//**
+* \file dfu_qspi.c
+* \version 1.0
+*
+* This file provides the download staging area, the firmware cache and the
+* XIP slot in the external QSPI memory, see dfu_qspi.h.
+*
+* The SMIF sends the page data from its interrupt, and the memory programs
+* the page afterwards. Both run in the background: WaitReady() waits for them
+* before the next QSPI operation, the install only polls PollReady(). The
+* staged rows are read back through the memory mapped (XIP) window, so the
+* SMIF switches to the memory mode for reads and back to the normal mode for
+* program and erase.
+*
+* The staged image is validated with the DFU SDK checksum, CRC-32C. The
+* DFU SDK computes it in a single call, here it is computed row by row over
+* staged and internal rows, QSPI_CRC_ROWS per install step. The cached
+* images are validated the same way before they are restored.
+*
+* The XIP read rate is measured with the CM4 DWT cycle counter, so it
+* includes the read loop, a few CPU cycles per word.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_pdl.h"
+#include "cycfg_qspi_memslot.h"
+#include "dfu_qspi.h"
+#include "dfu_boot.h"
+#include "dfu_wear.h"
+
+#if (DFU_QSPI_STAGING != 0) || (DFU_QSPI_CACHE != 0) || (DFU_BOOT_XIP != 0)
+
+/* The QSPI memory, the first memslot */
+#define QSPI_MEM                ((cy_stc_smif_mem_config_t *)smifMemConfigs[0])
+
+/* The S25FL512S memslot uses 4-byte addresses */
+#define QSPI_ADDR_SIZE          (4u)
+
+/* The SMIF initialization timeout, in microseconds */
+#define QSPI_INIT_TIMEOUT_US    (1000u)
+
+/* The busy polling period, in microseconds */
+#define QSPI_POLL_US            (50u)
+
+/* The number of 32-bit words of the staged rows bitmap */
+#define QSPI_ROW_WORDS          ((DFU_QSPI_STAGING_ROWS + 31u) / 32u)
+
+/* The number of 32-bit words of the programmed XIP rows bitmap */
+#define QSPI_XIP_ROW_WORDS      ((DFU_QSPI_XIP_ROWS + 31u) / 32u)
+
+/* The QSPI memory offset of a cache entry */
+#define QSPI_CACHE_ENTRY(idx)   (DFU_QSPI_CACHE_OFFSET + ((idx) * DFU_QSPI_CACHE_ENTRY_SIZE))
+
+/* The install states of the staged image */
+#define QSPI_INSTALL_IDLE       (0u)    /* Nothing to install */
+#define QSPI_INSTALL_VALIDATE   (1u)    /* Adds the staged image to its CRC */
+#define QSPI_INSTALL_COPY       (2u)    /* Writes the changed rows, one per step */
+#define QSPI_INSTALL_ERASE      (3u)    /* Erases the staging area, one sector per step */
+
+/* The rows added to the CRC of the staged image per install step */
+#define QSPI_CRC_ROWS           (16u)
+
+/* The SMIF configuration */
+static const cy_stc_smif_config_t dfu_qspiConfig =
+{
+    /* .mode           */ CY_SMIF_NORMAL,
+    /* .deselectDelay  */ 1u,
+    /* .rxClockSel     */ CY_SMIF_SEL_INV_INTERNAL_CLK,
+    /* .blockEvent     */ CY_SMIF_BUS_ERROR
+};
+
+/* The SMIF interrupt, it feeds the page data to the SMIF */
+static const cy_stc_sysint_t dfu_qspiIntrConfig =
+{
+    .intrSrc      = smif_interrupt_IRQn,
+    .intrPriority = DFU_QSPI_INTR_PRIORITY
+};
+
+static cy_stc_smif_context_t dfu_qspiContext;
+
+#if DFU_BOOT_DEEPSLEEP != 0
+/* The Deep Sleep callback of the SMIF, it refuses Deep Sleep during a transfer */
+static cy_stc_syspm_callback_params_t dfu_qspiSleepParams;
+static cy_stc_syspm_callback_t dfu_qspiSleepCallback =
+{
+    .callback       = &Cy_SMIF_DeepSleepCallback,
+    .type           = CY_SYSPM_DEEPSLEEP,
+    .skipMode       = 0u,
+    .callbackParams = &dfu_qspiSleepParams,
+    .prevItm        = NULL,
+    .nextItm        = NULL,
+};
+#endif /* DFU_BOOT_DEEPSLEEP != 0 */
+
+/* The page being programmed, it must stay valid until WaitReady(). Also the
+ * row written by the install, no page is programmed meanwhile. */
+CY_ALIGN(4) static uint8_t dfu_qspiPage[CY_FLASH_SIZEOF_ROW];
+
+/* 1 when the QSPI memory is initialized */
+static uint32_t dfu_qspiReady = 0u;
+
+/* 1 while a program or an erase may be in progress */
+static uint32_t dfu_qspiBusy = 0u;
+
+#if DFU_QSPI_STAGING != 0
+/* 1 when the downloads are staged */
+static uint32_t dfu_qspiStaging = 0u;
+
+/* The slot staged, 0 if none */
+static uint32_t dfu_qspiApp = 0u;
+
+/* The rows of the slot staged, one bit per row */
+static uint32_t dfu_qspiRows[QSPI_ROW_WORDS];
+
+/* The install state, see InstallStep() */
+static uint32_t dfu_qspiInstallState = QSPI_INSTALL_IDLE;
+
+/* The next offset of the install: in the slot, or in the staging area for the erase */
+static uint32_t dfu_qspiInstallOffset = 0u;
+
+/* The CRC-32C of the staged image so far */
+static uint32_t dfu_qspiInstallCrc = 0u;
+
+/* The result of the last install */
+static cy_en_dfu_status_t dfu_qspiInstallStatus = CY_DFU_SUCCESS;
+#endif /* DFU_QSPI_STAGING != 0 */
+
+#if DFU_BOOT_XIP != 0
+/* The sectors of the XIP slot erased since App0 started, one bit per sector */
+static uint32_t dfu_qspiXipErased = 0u;
+
+/* The rows of the XIP slot programmed since their sector was erased */
+static uint32_t dfu_qspiXipRows[QSPI_XIP_ROW_WORDS];
+#endif /* DFU_BOOT_XIP != 0 */
+
+#if CY_DFU_OPT_CRYPTO_HW == 0
+/* The CRC-32C table, one entry per nibble */
+static const uint32_t dfu_qspiCrcTable[16u] =
+{
+    0x00000000u, 0x105EC76Fu, 0x20BD8EDEu, 0x30E349B1u, 0x417B1DBCu, 0x5125DAD3u, 0x61C69362u, 0x7198540Du,
+    0x82F63B78u, 0x92A8FC17u, 0xA24BB5A6u, 0xB21572C9u, 0xC38D26C4u, 0xD3D3E1ABu, 0xE330A81Au, 0xF36E6F75u
+};
+#endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+
+
+static void QspiIsr(void);
+static void GetSlot(uint32_t app, uint32_t *start, uint32_t *length);
+static void AddressToArray(uint32_t address, uint8_t array[]);
+static void SetMode(cy_en_smif_mode_t mode);
+static uint32_t PollReady(void);
+static cy_en_dfu_status_t WaitReady(void);
+static cy_en_dfu_status_t ProgramPage(uint32_t offset, const uint8_t data[]);
+static cy_en_dfu_status_t EraseSector(uint32_t offset);
+static cy_en_dfu_status_t WriteChangedRow(uint32_t address, const uint8_t source[], uint8_t buffer[]);
+#if DFU_QSPI_STAGING != 0
+static uint32_t IsStaged(uint32_t row);
+static const uint8_t * RowSource(uint32_t address);
+static cy_en_dfu_status_t EraseStaging(void);
+static void InstallStep(void);
+#endif /* DFU_QSPI_STAGING != 0 */
+#if DFU_BOOT_XIP != 0
+static cy_en_dfu_status_t XipEnable(void);
+static uint32_t ReadRate(const volatile uint32_t source[], uint32_t size);
+#endif /* DFU_BOOT_XIP != 0 */
+#if CY_DFU_OPT_CRYPTO_HW == 0
+static uint32_t Crc32cUpdate(uint32_t crc, const uint8_t data[], uint32_t length);
+#endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+
+
+/*******************************************************************************
+* Function Name: QspiIsr
+****************************************************************************//**
+*
+* This internal function is the SMIF interrupt handler.
+*
+*******************************************************************************/
+static void QspiIsr(void)
+{
+    Cy_SMIF_Interrupt(SMIF0, &dfu_qspiContext);
+}
+
+
+/*******************************************************************************
+* Function Name: GetSlot
+****************************************************************************//**
+*
+* This internal function returns the verified range of an application slot,
+* the signature follows it.
+*
+* \param app        The slot, DFU_BOOT_FIRST_APP to DFU_BOOT_LAST_APP.
+* \param start      The pointer to a variable where the start is stored.
+* \param length     The pointer to a variable where the length is stored.
+*
+*******************************************************************************/
+static void GetSlot(uint32_t app, uint32_t *start, uint32_t *length)
+{
+    if (app == DFU_BOOT_FIRST_APP)
+    {
+        *start  = CY_DFU_APP1_VERIFY_START;
+        *length = CY_DFU_APP1_VERIFY_LENGTH;
+    }
+    else if (app == DFU_BOOT_XIP_APP)
+    {
+        *start  = CY_DFU_APP3_VERIFY_START;
+        *length = CY_DFU_APP3_VERIFY_LENGTH;
+    }
+    else
+    {
+        *start  = CY_DFU_APP2_VERIFY_START;
+        *length = CY_DFU_APP2_VERIFY_LENGTH;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: AddressToArray
+****************************************************************************//**
+*
+* This internal function converts a QSPI memory address to the byte array
+* sent to the memory, most significant byte first.
+*
+*******************************************************************************/
+static void AddressToArray(uint32_t address, uint8_t array[])
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < QSPI_ADDR_SIZE; ++idx)
+    {
+        array[idx] = (uint8_t)(address >> (8u * (QSPI_ADDR_SIZE - 1u - idx)));
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SetMode
+****************************************************************************//**
+*
+* This internal function switches the SMIF mode. The cache is invalidated
+* when switching to the memory mode, the staging area may have changed.
+*
+*******************************************************************************/
+static void SetMode(cy_en_smif_mode_t mode)
+{
+    if (Cy_SMIF_GetMode(SMIF0) != mode)
+    {
+        Cy_SMIF_SetMode(SMIF0, mode);
+        if (mode == CY_SMIF_MEMORY)
+        {
+            (void) Cy_SMIF_CacheInvalidate(SMIF0, CY_SMIF_CACHE_BOTH);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: PollReady
+****************************************************************************//**
+*
+* This internal function checks once, without waiting, whether the program
+* or erase started last is done. Leaves the SMIF in the normal mode if one
+* was in progress.
+*
+* \return 1 - the memory is ready for the next operation, else 0.
+*
+*******************************************************************************/
+static uint32_t PollReady(void)
+{
+    /* The interrupt sends the rest of the page first */
+    if ( (dfu_qspiBusy != 0u)
+      && (Cy_SMIF_GetTransferStatus(SMIF0, &dfu_qspiContext) != CY_SMIF_SEND_BUSY) )
+    {
+        SetMode(CY_SMIF_NORMAL);
+        if (!Cy_SMIF_Memslot_IsBusy(SMIF0, QSPI_MEM, &dfu_qspiContext))
+        {
+            dfu_qspiBusy = 0u;
+        }
+    }
+    return ( (dfu_qspiBusy == 0u) ? 1u : 0u );
+}
+
+
+/*******************************************************************************
+* Function Name: WaitReady
+****************************************************************************//**
+*
+* This internal function waits for the program or erase started last. Leaves
+* the SMIF in the normal mode.
+*
+* \return
+* - CY_DFU_SUCCESS when the memory is ready.
+* - CY_DFU_ERROR_TIMEOUT if the memory is still busy after the erase time.
+*
+*******************************************************************************/
+static cy_en_dfu_status_t WaitReady(void)
+{
+    uint32_t count = (QSPI_MEM->deviceCfg->eraseTime * 1000u) / QSPI_POLL_US;
+
+    while ( (PollReady() == 0u) && (count > 0u) )
+    {
+        Cy_SysLib_DelayUs(QSPI_POLL_US);
+        --count;
+    }
+    SetMode(CY_SMIF_NORMAL);
+    return ( (dfu_qspiBusy == 0u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_TIMEOUT );
+}
+
+
+/*******************************************************************************
+* Function Name: ProgramPage
+****************************************************************************//**
+*
+* This internal function starts programming a row size page, after the
+* operation in progress. The program is not waited for.
+*
+* \param offset     The QSPI memory offset of the page.
+* \param data       The page data, copied.
+*
+* \return
+* - CY_DFU_SUCCESS when the program is started.
+* - Any other status code on error.
+*
+*******************************************************************************/
+static cy_en_dfu_status_t ProgramPage(uint32_t offset, const uint8_t data[])
+{
+    cy_en_dfu_status_t status = WaitReady();
+    uint8_t addr[QSPI_ADDR_SIZE];
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        (void) memcpy(dfu_qspiPage, data, CY_FLASH_SIZEOF_ROW);
+
+        AddressToArray(offset, addr);
+        if ( (Cy_SMIF_Memslot_CmdWriteEnable(SMIF0, QSPI_MEM, &dfu_qspiContext) == CY_SMIF_SUCCESS)
+          && (Cy_SMIF_Memslot_CmdProgram(SMIF0, QSPI_MEM, addr, dfu_qspiPage, CY_FLASH_SIZEOF_ROW,
+                                         NULL, &dfu_qspiContext) == CY_SMIF_SUCCESS) )
+        {
+            dfu_qspiBusy = 1u;
+        }
+        else
+        {
+            status = CY_DFU_ERROR_DATA;
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EraseSector
+****************************************************************************//**
+*
+* This internal function starts erasing a sector, after the operation in
+* progress. The erase is not waited for.
+*
+* \param offset     The QSPI memory offset of the sector.
+*
+* \return
+* - CY_DFU_SUCCESS when the erase is started.
+* - Any other status code on error.
+*
+*******************************************************************************/
+static cy_en_dfu_status_t EraseSector(uint32_t offset)
+{
+    cy_en_dfu_status_t status = WaitReady();
+    uint8_t addr[QSPI_ADDR_SIZE];
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        AddressToArray(offset, addr);
+        if ( (Cy_SMIF_Memslot_CmdWriteEnable(SMIF0, QSPI_MEM, &dfu_qspiContext) == CY_SMIF_SUCCESS)
+          && (Cy_SMIF_Memslot_CmdSectorErase(SMIF0, QSPI_MEM, addr, &dfu_qspiContext) == CY_SMIF_SUCCESS) )
+        {
+            dfu_qspiBusy = 1u;
+        }
+        else
+        {
+            status = CY_DFU_ERROR_DATA;
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: WriteChangedRow
+****************************************************************************//**
+*
+* This internal function is the copy engine: writes an internal flash row
+* only if it differs from the source, and verifies it.
+*
+* \param address    The row address.
+* \param source     The new row data, e.g. in the XIP window.
+* \param buffer     The RAM row the source is copied to for the write.
+*
+* \return
+* - CY_DFU_SUCCESS when the row holds the source data.
+* - CY_DFU_ERROR_DATA if the write failed.
+*
+*******************************************************************************/
+static cy_en_dfu_status_t WriteChangedRow(uint32_t address, const uint8_t source[], uint8_t buffer[])
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+
+    if (memcmp(source, (const void *)address, CY_FLASH_SIZEOF_ROW) != 0)
+    {
+        cy_en_flashdrv_status_t fstatus;
+        uint32_t start;
+
+        (void) memcpy(buffer, source, CY_FLASH_SIZEOF_ROW);
+        start = DFU_WEAR_BEGIN();
+        fstatus = Cy_Flash_WriteRow(address, (const uint32_t *)buffer);
+        status = ( (fstatus == CY_FLASH_DRV_SUCCESS)
+                && (memcmp(buffer, (const void *)address, CY_FLASH_SIZEOF_ROW) == 0) )
+                 ? CY_DFU_SUCCESS : CY_DFU_ERROR_DATA;
+        DFU_WEAR_ROW(address, 0u, (status != CY_DFU_SUCCESS) ? 1u : 0u, start);
+    }
+    else
+    {
+        DFU_WEAR_SKIP(address);
+    }
+    return (status);
+}
+
+
+#if DFU_QSPI_STAGING != 0
+/*******************************************************************************
+* Function Name: IsStaged
+****************************************************************************//**
+*
+* \return 1 - the row of the staged slot is in the staging area, else 0
+*
+*******************************************************************************/
+static uint32_t IsStaged(uint32_t row)
+{
+    return ( (row < DFU_QSPI_STAGING_ROWS) && ((dfu_qspiRows[row / 32u] & (1ul << (row % 32u))) != 0u) )
+           ? 1u : 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: RowSource
+****************************************************************************//**
+*
+* This internal function returns where the current data of an address is:
+* the staging area if its row is staged, else the internal flash.
+* The SMIF must be in the memory mode to read the staging area.
+*
+*******************************************************************************/
+static const uint8_t * RowSource(uint32_t address)
+{
+    const uint8_t *source = (const uint8_t *)address;
+    uint32_t app = DFU_BootAppOf(address);
+
+    if ( (app != 0u) && (app == dfu_qspiApp) )
+    {
+        uint32_t start;
+        uint32_t length;
+        uint32_t offset;
+
+        GetSlot(app, &start, &length);
+        offset = address - start;
+        if (IsStaged(offset / CY_FLASH_SIZEOF_ROW) != 0u)
+        {
+            source = (const uint8_t *)(QSPI_MEM->baseAddress + DFU_QSPI_STAGING_OFFSET + offset);
+        }
+    }
+    return (source);
+}
+
+
+/*******************************************************************************
+* Function Name: EraseStaging
+****************************************************************************//**
+*
+* This internal function drops the staged rows and the install in progress,
+* and erases the staging area. The erase of the last sector is not waited
+* for.
+*
+* \return
+* - CY_DFU_SUCCESS when the erase is started.
+* - Any other status code on error.
+*
+*******************************************************************************/
+static cy_en_dfu_status_t EraseStaging(void)
+{
+    const uint32_t eraseSize = QSPI_MEM->deviceCfg->eraseSize;
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    uint32_t offset;
+
+    dfu_qspiApp = 0u;
+    (void) memset(dfu_qspiRows, 0, sizeof(dfu_qspiRows));
+    dfu_qspiInstallState  = QSPI_INSTALL_IDLE;
+    dfu_qspiInstallStatus = CY_DFU_SUCCESS;
+
+    for (offset = 0u; (offset < DFU_QSPI_STAGING_SIZE) && (status == CY_DFU_SUCCESS); offset += eraseSize)
+    {
+        status = EraseSector(DFU_QSPI_STAGING_OFFSET + offset);
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: InstallStep
+****************************************************************************//**
+*
+* This internal function runs one step of the install, the memory must be
+* ready: adds QSPI_CRC_ROWS staged rows to the CRC, or writes one changed
+* row, or starts erasing one sector of the staging area. Once the image is
+* installed, or is not valid, or a row write failed, the staged rows are
+* dropped and the staging area is erased.
+*
+*******************************************************************************/
+static void InstallStep(void)
+{
+    uint32_t start;
+    uint32_t length;
+
+    if (dfu_qspiInstallState == QSPI_INSTALL_VALIDATE)
+    {
+    #if CY_DFU_OPT_CRYPTO_HW == 0
+        uint32_t end;
+
+        GetSlot(dfu_qspiApp, &start, &length);
+        end = dfu_qspiInstallOffset + (QSPI_CRC_ROWS * CY_FLASH_SIZEOF_ROW);
+        end = (end < length) ? end : length;
+        SetMode(CY_SMIF_MEMORY);
+        while (dfu_qspiInstallOffset < end)
+        {
+            uint32_t size = ((end - dfu_qspiInstallOffset) < CY_FLASH_SIZEOF_ROW)
+                            ? (end - dfu_qspiInstallOffset) : CY_FLASH_SIZEOF_ROW;
+
+            dfu_qspiInstallCrc = Crc32cUpdate(dfu_qspiInstallCrc, RowSource(start + dfu_qspiInstallOffset), size);
+            dfu_qspiInstallOffset += size;
+        }
+
+        if (dfu_qspiInstallOffset >= length)
+        {
+            uint32_t signature;
+
+            (void) memcpy(&signature, RowSource(start + length), sizeof(signature));
+            dfu_qspiInstallStatus = ((dfu_qspiInstallCrc ^ 0xFFFFFFFFu) == signature)
+                                    ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
+            dfu_qspiInstallState  = QSPI_INSTALL_COPY;
+            dfu_qspiInstallOffset = 0u;
+        }
+    #else
+        /* The signature is not a checksum, the caller validates the installed image */
+        dfu_qspiInstallState  = QSPI_INSTALL_COPY;
+        dfu_qspiInstallOffset = 0u;
+    #endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+    }
+    else if (dfu_qspiInstallState == QSPI_INSTALL_COPY)
+    {
+        const uint8_t *source = NULL;
+
+        GetSlot(dfu_qspiApp, &start, &length);
+        SetMode(CY_SMIF_MEMORY);
+
+        /* The copy engine: the next staged row, written if it changed */
+        while ( (source == NULL) && (dfu_qspiInstallOffset < (length + CY_DFU_SIGNATURE_SIZE))
+             && (dfu_qspiInstallStatus == CY_DFU_SUCCESS) )
+        {
+            uint32_t address = start + dfu_qspiInstallOffset;
+
+            source = RowSource(address);
+            if (source != (const uint8_t *)address)
+            {
+                dfu_qspiInstallStatus = WriteChangedRow(address, source, dfu_qspiPage);
+            }
+            else
+            {
+                source = NULL;
+            }
+            dfu_qspiInstallOffset += CY_FLASH_SIZEOF_ROW;
+        }
+
+        if (source == NULL)
+        {
+            /* Installed, or failed: drop the staged rows */
+            dfu_qspiApp = 0u;
+            (void) memset(dfu_qspiRows, 0, sizeof(dfu_qspiRows));
+            dfu_qspiInstallState  = QSPI_INSTALL_ERASE;
+            dfu_qspiInstallOffset = 0u;
+        }
+    }
+    else
+    {
+        /* Erasing */
+    }
+
+    if (dfu_qspiInstallState == QSPI_INSTALL_ERASE)
+    {
+        if (dfu_qspiInstallOffset >= DFU_QSPI_STAGING_SIZE)
+        {
+            dfu_qspiInstallState = QSPI_INSTALL_IDLE;
+        }
+        else if (PollReady() != 0u)
+        {
+            if (EraseSector(DFU_QSPI_STAGING_OFFSET + dfu_qspiInstallOffset) == CY_DFU_SUCCESS)
+            {
+                dfu_qspiInstallOffset += QSPI_MEM->deviceCfg->eraseSize;
+            }
+            else
+            {
+                /* The downloads go to the internal flash */
+                dfu_qspiStaging = 0u;
+                dfu_qspiInstallState = QSPI_INSTALL_IDLE;
+            }
+        }
+        else
+        {
+            /* The erase of the previous sector is in progress */
+        }
+    }
+}
+
+
+#endif /* DFU_QSPI_STAGING != 0 */
+
+
+#if CY_DFU_OPT_CRYPTO_HW == 0
+/*******************************************************************************
+* Function Name: Crc32cUpdate
+****************************************************************************//**
+*
+* This internal function adds data to a CRC-32C. Start with 0xFFFFFFFF and
+* invert the result, as Cy_DFU_DataChecksum() does.
+*
+*******************************************************************************/
+static uint32_t Crc32cUpdate(uint32_t crc, const uint8_t data[], uint32_t length)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < length; ++idx)
+    {
+        crc = (crc >> 4u) ^ dfu_qspiCrcTable[(crc ^ data[idx]) & 0x0Fu];
+        crc = (crc >> 4u) ^ dfu_qspiCrcTable[(crc ^ ((uint32_t)data[idx] >> 4u)) & 0x0Fu];
+    }
+    return (crc);
+}
+#endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiInit
+****************************************************************************//**
+*
+* Initializes the QSPI pins, the SMIF and the memory, and leaves the SMIF in
+* the memory mode with the cache enabled. Does nothing once the QSPI memory
+* is initialized. Called by App0 before the slots are validated with
+* DFU_BOOT_XIP, else before the DFU transport is started.
+* If it fails, the downloads are written to the internal flash, and the
+* cache and the XIP slot are not available.
+*
+* \return
+* - CY_DFU_SUCCESS when the QSPI memory can be used.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiInit(void)
+{
+    cy_en_dfu_status_t status = (dfu_qspiReady != 0u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_UNKNOWN;
+
+    if (dfu_qspiReady == 0u)
+    {
+        Cy_GPIO_Pin_FastInit(GPIO_PRT11, 2u, CY_GPIO_DM_STRONG_IN_OFF, 1u, P11_2_SMIF_SPI_SELECT0);
+        Cy_GPIO_Pin_FastInit(GPIO_PRT11, 3u, CY_GPIO_DM_STRONG,        1u, P11_3_SMIF_SPI_DATA3);
+        Cy_GPIO_Pin_FastInit(GPIO_PRT11, 4u, CY_GPIO_DM_STRONG,        1u, P11_4_SMIF_SPI_DATA2);
+        Cy_GPIO_Pin_FastInit(GPIO_PRT11, 5u, CY_GPIO_DM_STRONG,        1u, P11_5_SMIF_SPI_DATA1);
+        Cy_GPIO_Pin_FastInit(GPIO_PRT11, 6u, CY_GPIO_DM_STRONG,        1u, P11_6_SMIF_SPI_DATA0);
+        Cy_GPIO_Pin_FastInit(GPIO_PRT11, 7u, CY_GPIO_DM_STRONG_IN_OFF, 1u, P11_7_SMIF_SPI_CLK);
+
+        if (Cy_SMIF_Init(SMIF0, &dfu_qspiConfig, QSPI_INIT_TIMEOUT_US, &dfu_qspiContext) == CY_SMIF_SUCCESS)
+        {
+            (void) Cy_SysInt_Init(&dfu_qspiIntrConfig, &QspiIsr);
+            NVIC_EnableIRQ(smif_interrupt_IRQn);
+
+            Cy_SMIF_SetDataSelect(SMIF0, QSPI_MEM->slaveSelect, QSPI_MEM->dataSelect);
+            Cy_SMIF_Enable(SMIF0, &dfu_qspiContext);
+
+        #if DFU_BOOT_DEEPSLEEP != 0
+            dfu_qspiSleepParams.base    = SMIF0;
+            dfu_qspiSleepParams.context = &dfu_qspiContext;
+            (void) Cy_SysPm_RegisterCallback(&dfu_qspiSleepCallback);
+        #endif
+
+            /* The quad page program and the quad read need the Quad Enable bit of the memory */
+            if ( (Cy_SMIF_Memslot_Init(SMIF0, (cy_stc_smif_block_config_t *)&smifBlockConfig, &dfu_qspiContext) == CY_SMIF_SUCCESS)
+              && (Cy_SMIF_Memslot_QuadEnable(SMIF0, QSPI_MEM, &dfu_qspiContext) == CY_SMIF_SUCCESS) )
+            {
+                /* The XIP window is read through the cache, with prefetching */
+                (void) Cy_SMIF_CacheEnable(SMIF0, CY_SMIF_CACHE_BOTH);
+                (void) Cy_SMIF_CachePrefetchingEnable(SMIF0, CY_SMIF_CACHE_BOTH);
+                SetMode(CY_SMIF_MEMORY);
+                status = CY_DFU_SUCCESS;
+            }
+        }
+        dfu_qspiReady = (status == CY_DFU_SUCCESS) ? 1u : 0u;
+    }
+    return (status);
+}
+
+
+#if DFU_QSPI_STAGING != 0
+/*******************************************************************************
+* Function Name: DFU_QspiStagingStart
+****************************************************************************//**
+*
+* Starts erasing the staging area, which may hold rows staged before a reset,
+* and stages the downloads from now on. Called by App0 before the DFU
+* transport is started, after DFU_QspiInit().
+*
+* \return
+* - CY_DFU_SUCCESS when the staging area can be used.
+* - Any other status code on error, the downloads are written to the
+*   internal flash.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiStagingStart(void)
+{
+    cy_en_dfu_status_t status = (dfu_qspiReady != 0u) ? EraseStaging() : CY_DFU_ERROR_UNKNOWN;
+
+    dfu_qspiStaging = (status == CY_DFU_SUCCESS) ? 1u : 0u;
+    return (status);
+}
+#endif /* DFU_QSPI_STAGING != 0 */
+
+
+#if DFU_QSPI_STAGING != 0
+/*******************************************************************************
+* Function Name: DFU_QspiIsEnabled
+****************************************************************************//**
+*
+* \param address    The address of a row to write or read.
+*
+* \return 1 - the row belongs to an application slot in the internal flash
+*         and goes through the staging area, else 0.
+*
+*******************************************************************************/
+uint32_t DFU_QspiIsEnabled(uint32_t address)
+{
+    uint32_t app = DFU_BootAppOf(address);
+
+    return ( (dfu_qspiStaging != 0u) && (app != 0u) && (app != DFU_BOOT_XIP_APP) ) ? 1u : 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiWrite
+****************************************************************************//**
+*
+* Stages a row of an application slot with a quad page program. Returns when
+* the SMIF has started sending the page, the program is waited for by the
+* next QSPI operation. A row may be programmed once, so if the host writes a
+* row again, or writes the other slot, or writes while the staged image is
+* installed, the staging area is erased first. The erase started by the last
+* install is finished first.
+*
+* \param address    The row address, in the internal flash.
+* \param ctl        CY_DFU_IOCTL_ERASE to stage an erased row.
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer holds the row.
+*
+* \return
+* - CY_DFU_SUCCESS when the row is being programmed.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    uint32_t app = DFU_BootAppOf(address);
+    uint32_t start;
+    uint32_t length;
+    uint32_t row;
+
+    GetSlot(app, &start, &length);
+    row = (address - start) / CY_FLASH_SIZEOF_ROW;
+
+    if (row >= DFU_QSPI_STAGING_ROWS)
+    {
+        status = CY_DFU_ERROR_ADDRESS;
+    }
+    else if ( ((dfu_qspiApp != 0u) && (dfu_qspiApp != app)) || (IsStaged(row) != 0u)
+           || (DFU_QspiInstallingApp() != 0u) )
+    {
+        status = EraseStaging();
+    }
+    else
+    {
+        /* The row is erased, once the install has erased the staging area */
+        while ( (dfu_qspiInstallState == QSPI_INSTALL_ERASE) && (status == CY_DFU_SUCCESS) )
+        {
+            status = WaitReady();
+            if (status == CY_DFU_SUCCESS)
+            {
+                InstallStep();
+            }
+        }
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        /* The internal flash erased state is zero */
+        if ((ctl & CY_DFU_IOCTL_ERASE) != 0u)
+        {
+            (void) memset(params->dataBuffer, 0, CY_FLASH_SIZEOF_ROW);
+        }
+
+        status = ProgramPage(DFU_QSPI_STAGING_OFFSET + (row * CY_FLASH_SIZEOF_ROW), params->dataBuffer);
+        if (status == CY_DFU_SUCCESS)
+        {
+            dfu_qspiApp = app;
+            dfu_qspiRows[row / 32u] |= (1ul << (row % 32u));
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiRead
+****************************************************************************//**
+*
+* Reads or compares rows of an application slot, from the staging area for
+* the staged rows and from the internal flash for the others.
+*
+* \param address    The address of the first row.
+* \param length     The length, a multiple of the row size.
+* \param ctl        CY_DFU_IOCTL_COMPARE to compare with params->dataBuffer,
+*                   else the data is read into it.
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return
+* - CY_DFU_SUCCESS when the data is read or equal.
+* - CY_DFU_ERROR_VERIFY if the data differs.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    uint32_t offset;
+
+    /* With no row staged the staging area is not read, it may be being erased */
+    if (dfu_qspiApp != 0u)
+    {
+        status = WaitReady();
+        SetMode(CY_SMIF_MEMORY);
+    }
+    for (offset = 0u; (offset < length) && (status == CY_DFU_SUCCESS); offset += CY_FLASH_SIZEOF_ROW)
+    {
+        const uint8_t *source = RowSource(address + offset);
+
+        if ((ctl & CY_DFU_IOCTL_COMPARE) == 0u)
+        {
+            (void) memcpy(&params->dataBuffer[offset], source, CY_FLASH_SIZEOF_ROW);
+        }
+        else if (memcmp(&params->dataBuffer[offset], source, CY_FLASH_SIZEOF_ROW) != 0)
+        {
+            status = CY_DFU_ERROR_VERIFY;
+        }
+        else
+        {
+            /* Equal */
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiIsComplete
+****************************************************************************//**
+*
+* \return 1 - the row holding the signature of the staged slot is staged,
+*         the download is complete, else 0.
+*
+*******************************************************************************/
+uint32_t DFU_QspiIsComplete(void)
+{
+    uint32_t complete = 0u;
+
+    if (dfu_qspiApp != 0u)
+    {
+        uint32_t start;
+        uint32_t length;
+
+        GetSlot(dfu_qspiApp, &start, &length);
+        complete = IsStaged(length / CY_FLASH_SIZEOF_ROW);
+    }
+    return (complete);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiInstallStart
+****************************************************************************//**
+*
+* Starts the install of the staged image, once DFU_QspiIsComplete(). Returns
+* at once: DFU_QspiInstallTask() validates the staged image, then copies the
+* staged rows that differ from the internal flash. Does nothing if no row is
+* staged or the install runs already.
+*
+*******************************************************************************/
+void DFU_QspiInstallStart(void)
+{
+    if ( (dfu_qspiApp != 0u) && (dfu_qspiInstallState == QSPI_INSTALL_IDLE) )
+    {
+        dfu_qspiInstallState  = QSPI_INSTALL_VALIDATE;
+        dfu_qspiInstallOffset = 0u;
+        dfu_qspiInstallCrc    = 0xFFFFFFFFu;
+        dfu_qspiInstallStatus = CY_DFU_SUCCESS;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiInstallTask
+****************************************************************************//**
+*
+* Runs one step of the install, if the QSPI memory is ready, and never waits:
+* a step adds 16 staged rows to the CRC, or writes one row, or starts erasing
+* a sector of the staging area. Called by the App0 main loop between the DFU
+* commands. The staging area is erased once the image is installed, also on
+* error.
+*
+* \return 1 - the install or its erase is in progress, call again soon,
+*         else 0.
+*
+*******************************************************************************/
+uint32_t DFU_QspiInstallTask(void)
+{
+    if ( (dfu_qspiInstallState != QSPI_INSTALL_IDLE) && (PollReady() != 0u) )
+    {
+        InstallStep();
+    }
+    return ( (dfu_qspiInstallState != QSPI_INSTALL_IDLE) ? 1u : 0u );
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiInstallingApp
+****************************************************************************//**
+*
+* \return The slot whose staged image is being validated or copied to the
+*         internal flash, 0 if none.
+*
+*******************************************************************************/
+uint32_t DFU_QspiInstallingApp(void)
+{
+    return ( ( (dfu_qspiInstallState == QSPI_INSTALL_VALIDATE) || (dfu_qspiInstallState == QSPI_INSTALL_COPY) )
+             ? dfu_qspiApp : 0u );
+}
+
+
+#if CY_DFU_OPT_CRYPTO_HW == 0
+/*******************************************************************************
+* Function Name: DFU_QspiVerifyStaged
+****************************************************************************//**
+*
+* Validates the image being installed from the staging area, for the Verify
+* Application command: the internal flash slot is valid once the install is
+* done. Finishes the CRC of the staged image, which takes a few milliseconds,
+* not the copy.
+*
+* \param appId      The slot the host verifies.
+*
+* \return
+* - CY_DFU_SUCCESS if the slot is being installed and its staged image is
+*   valid.
+* - CY_DFU_ERROR_VERIFY else.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiVerifyStaged(uint32_t appId)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+
+    while ( (dfu_qspiInstallState == QSPI_INSTALL_VALIDATE) && (status == CY_DFU_SUCCESS) )
+    {
+        status = WaitReady();
+        if (status == CY_DFU_SUCCESS)
+        {
+            InstallStep();
+        }
+    }
+    return ( ( (status == CY_DFU_SUCCESS) && (appId != 0u) && (appId == DFU_QspiInstallingApp())
+            && (dfu_qspiInstallStatus == CY_DFU_SUCCESS) ) ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY );
+}
+#endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiInstall
+****************************************************************************//**
+*
+* Finishes the install of the staged image, or runs it all if it was not
+* started, e.g. the signature row was not staged. Called by App0 when the
+* download is finished, the host does not wait for a response then. The
+* erase of the staging area is started, it is not waited for.
+*
+* With CY_DFU_OPT_CRYPTO_HW the signature is not a checksum, the staged image
+* is not validated here: the caller validates the installed one.
+*
+* \return
+* - CY_DFU_SUCCESS when the image is installed, or no row was staged.
+* - CY_DFU_ERROR_VERIFY if the staged image is not valid.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiInstall(void)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+
+    DFU_QspiInstallStart();
+    while ( (DFU_QspiInstallingApp() != 0u) && (status == CY_DFU_SUCCESS) )
+    {
+        status = WaitReady();
+        if (status == CY_DFU_SUCCESS)
+        {
+            InstallStep();
+        }
+    }
+    return ( (status == CY_DFU_SUCCESS) ? dfu_qspiInstallStatus : status );
+}
+
+#endif /* DFU_QSPI_STAGING != 0 */
+
+
+#if DFU_QSPI_CACHE != 0
+/*******************************************************************************
+* Function Name: DFU_QspiCacheStore
+****************************************************************************//**
+*
+* Stores the image of a slot in the cache, unless it is cached already.
+* The entry with the lowest version is replaced if no entry is free. The
+* sector erase is waited for, the programs of the last page and of the
+* header are not. The XIP slot is not cached, its image is in the QSPI
+* memory already and its window is not readable while the SMIF programs.
+*
+* \param appId      The slot, its image must be valid.
+*
+* \return
+* - CY_DFU_SUCCESS when the image is cached.
+* - CY_DFU_ERROR_ADDRESS for the XIP slot.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiCacheStore(uint32_t appId)
+{
+    cy_en_dfu_status_t status = (dfu_qspiReady != 0u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_UNKNOWN;
+    dfu_qspi_cache_entry_t entry;
+    uint32_t start = 0u;
+    uint32_t length = 0u;
+    uint32_t victim = 0u;
+    uint32_t cached = 0u;
+    uint32_t idx;
+
+    if ( (status == CY_DFU_SUCCESS) && (appId == DFU_BOOT_XIP_APP) )
+    {
+        status = CY_DFU_ERROR_ADDRESS;
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        (void) Cy_DFU_GetAppMetadata(appId, &start, &length);
+        status = ((length + CY_DFU_SIGNATURE_SIZE) <= (DFU_QSPI_CACHE_ENTRY_SIZE - CY_FLASH_SIZEOF_ROW))
+                 ? WaitReady() : CY_DFU_ERROR_LENGTH;
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        entry.magic   = DFU_QSPI_CACHE_MAGIC;
+        entry.version = 1u;
+        entry.appId   = appId;
+        entry.length  = length;
+        (void) memcpy(&entry.digest, (const void *)(start + length), sizeof(entry.digest));
+
+        SetMode(CY_SMIF_MEMORY);
+        for (idx = 0u; idx < DFU_QSPI_CACHE_ENTRIES; ++idx)
+        {
+            const dfu_qspi_cache_entry_t *header =
+                (const dfu_qspi_cache_entry_t *)(QSPI_MEM->baseAddress + QSPI_CACHE_ENTRY(idx));
+            const dfu_qspi_cache_entry_t *oldest =
+                (const dfu_qspi_cache_entry_t *)(QSPI_MEM->baseAddress + QSPI_CACHE_ENTRY(victim));
+
+            if (header->magic != DFU_QSPI_CACHE_MAGIC)
+            {
+                /* A free entry is used first */
+                if (oldest->magic == DFU_QSPI_CACHE_MAGIC)
+                {
+                    victim = idx;
+                }
+            }
+            else
+            {
+                if ( (header->appId == entry.appId) && (header->length == entry.length)
+                  && (header->digest == entry.digest) )
+                {
+                    cached = 1u;
+                }
+                if (header->version >= entry.version)
+                {
+                    entry.version = header->version + 1u;
+                }
+                if ( (oldest->magic == DFU_QSPI_CACHE_MAGIC) && (header->version < oldest->version) )
+                {
+                    victim = idx;
+                }
+            }
+        }
+    }
+
+    if ( (status == CY_DFU_SUCCESS) && (cached == 0u) )
+    {
+        uint32_t offset;
+
+        status = EraseSector(QSPI_CACHE_ENTRY(victim));
+        for (offset = 0u; (offset < (length + CY_DFU_SIGNATURE_SIZE)) && (status == CY_DFU_SUCCESS);
+             offset += CY_FLASH_SIZEOF_ROW)
+        {
+            status = ProgramPage(QSPI_CACHE_ENTRY(victim) + CY_FLASH_SIZEOF_ROW + offset,
+                                 (const uint8_t *)(start + offset));
+        }
+
+        /* The header makes the entry valid */
+        if (status == CY_DFU_SUCCESS)
+        {
+            CY_ALIGN(4) uint8_t header[CY_FLASH_SIZEOF_ROW];
+
+            (void) memset(header, 0xFF, sizeof(header));
+            (void) memcpy(header, &entry, sizeof(entry));
+            status = ProgramPage(QSPI_CACHE_ENTRY(victim), header);
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiCacheList
+****************************************************************************//**
+*
+* Reads the cache directory, the headers of the entries holding an image.
+*
+* \param entries    The array to fill.
+* \param count      The number of elements of the array.
+*
+* \return The number of entries read.
+*
+*******************************************************************************/
+uint32_t DFU_QspiCacheList(dfu_qspi_cache_entry_t entries[], uint32_t count)
+{
+    uint32_t found = 0u;
+    uint32_t idx;
+
+    if ( (dfu_qspiReady != 0u) && (WaitReady() == CY_DFU_SUCCESS) )
+    {
+        SetMode(CY_SMIF_MEMORY);
+        for (idx = 0u; (idx < DFU_QSPI_CACHE_ENTRIES) && (found < count); ++idx)
+        {
+            const dfu_qspi_cache_entry_t *header =
+                (const dfu_qspi_cache_entry_t *)(QSPI_MEM->baseAddress + QSPI_CACHE_ENTRY(idx));
+
+            if (header->magic == DFU_QSPI_CACHE_MAGIC)
+            {
+                entries[found] = *header;
+                ++found;
+            }
+        }
+    }
+    return (found);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiCacheRestore
+****************************************************************************//**
+*
+* Restores a cached image to its slot: validates it, updates the slot
+* metadata if its length differs, writes the rows that differ from the
+* internal flash and validates the slot. The slot selected by App0 is
+* refused, see DFU_BootCheckWrite(); the slot is recorded as written, so it
+* is made active when the download finishes. The XIP slot is refused, it is
+* never cached. Rows of the slot staged so far are dropped.
+*
+* \param version    The cache version of the image.
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer is used to write the rows.
+*
+* \return
+* - CY_DFU_SUCCESS when the slot holds the image.
+* - CY_DFU_ERROR_DATA if no entry has this version.
+* - CY_DFU_ERROR_VERIFY if the cached image is not valid.
+* - CY_DFU_ERROR_ADDRESS for the XIP slot or the slot selected by App0.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiCacheRestore(uint32_t version, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_DATA;
+    dfu_qspi_cache_entry_t entry;
+    const uint8_t *image = NULL;
+    uint32_t start = 0u;
+    uint32_t length = 0u;
+    uint32_t idx;
+
+    (void) memset(&entry, 0, sizeof(entry));
+
+    if ( (dfu_qspiReady != 0u) && (WaitReady() == CY_DFU_SUCCESS) )
+    {
+        SetMode(CY_SMIF_MEMORY);
+        for (idx = 0u; idx < DFU_QSPI_CACHE_ENTRIES; ++idx)
+        {
+            const dfu_qspi_cache_entry_t *header =
+                (const dfu_qspi_cache_entry_t *)(QSPI_MEM->baseAddress + QSPI_CACHE_ENTRY(idx));
+
+            if ( (header->magic == DFU_QSPI_CACHE_MAGIC) && (header->version == version)
+              && (header->appId >= DFU_BOOT_FIRST_APP) && (header->appId <= DFU_BOOT_LAST_APP) )
+            {
+                entry  = *header;
+                image  = (const uint8_t *)(QSPI_MEM->baseAddress + QSPI_CACHE_ENTRY(idx) + CY_FLASH_SIZEOF_ROW);
+                status = CY_DFU_SUCCESS;
+                break;
+            }
+        }
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        GetSlot(entry.appId, &start, &length);
+        if (entry.appId == DFU_BOOT_XIP_APP)
+        {
+            /* Not cached, an entry found for it is not restored */
+            status = CY_DFU_ERROR_ADDRESS;
+        }
+        else
+        {
+            status = (entry.length <= length) ? DFU_BootCheckWrite(start) : CY_DFU_ERROR_LENGTH;
+        }
+    }
+
+#if CY_DFU_OPT_CRYPTO_HW == 0
+    if (status == CY_DFU_SUCCESS)
+    {
+        uint32_t signature;
+
+        (void) memcpy(&signature, &image[entry.length], sizeof(signature));
+        status = ( (signature == entry.digest)
+                && ((Crc32cUpdate(0xFFFFFFFFu, image, entry.length) ^ 0xFFFFFFFFu) == signature) )
+                 ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
+    }
+#endif /* CY_DFU_OPT_CRYPTO_HW == 0 */
+
+#if DFU_QSPI_STAGING != 0
+    /* The staged rows would be installed over the restored image */
+    if ( (status == CY_DFU_SUCCESS) && (dfu_qspiApp == entry.appId) )
+    {
+        status = EraseStaging();
+        if (status == CY_DFU_SUCCESS)
+        {
+            status = WaitReady();
+            SetMode(CY_SMIF_MEMORY);
+        }
+    }
+#endif /* DFU_QSPI_STAGING != 0 */
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        uint32_t verifyStart;
+        uint32_t verifyLength;
+
+        (void) Cy_DFU_GetAppMetadata(entry.appId, &verifyStart, &verifyLength);
+        if ( (verifyStart != start) || (verifyLength != entry.length) )
+        {
+            status = Cy_DFU_SetAppMetadata(entry.appId, start, entry.length, params);
+        }
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        uint32_t offset;
+
+        for (offset = 0u; (offset < (entry.length + CY_DFU_SIGNATURE_SIZE)) && (status == CY_DFU_SUCCESS);
+             offset += CY_FLASH_SIZEOF_ROW)
+        {
+            status = WriteChangedRow(start + offset, &image[offset], params->dataBuffer);
+        }
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        status = Cy_DFU_ValidateApp(entry.appId, params);
+    }
+    return (status);
+}
+#endif /* DFU_QSPI_CACHE != 0 */
+#if DFU_BOOT_XIP != 0
+/*******************************************************************************
+* Function Name: XipEnable
+****************************************************************************//**
+*
+* This internal function waits for the operation in progress and switches
+* the SMIF to the memory mode, so the XIP window can be read.
+*
+* \return
+* - CY_DFU_SUCCESS when the XIP window can be read.
+* - Any other status code on error.
+*
+*******************************************************************************/
+static cy_en_dfu_status_t XipEnable(void)
+{
+    cy_en_dfu_status_t status = (dfu_qspiReady != 0u) ? WaitReady() : CY_DFU_ERROR_UNKNOWN;
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        SetMode(CY_SMIF_MEMORY);
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: ReadRate
+****************************************************************************//**
+*
+* This internal function reads a block word by word and returns the read
+* rate in KB/s, from the DWT cycle counter and the CPU clock.
+*
+*******************************************************************************/
+static uint32_t ReadRate(const volatile uint32_t source[], uint32_t size)
+{
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t idx;
+
+    start = DWT->CYCCNT;
+    for (idx = 0u; idx < (size / sizeof(uint32_t)); ++idx)
+    {
+        (void) source[idx];
+    }
+    cycles = DWT->CYCCNT - start;
+
+    return ( (cycles != 0u) ? (uint32_t)(((uint64_t)size * SystemCoreClock) / ((uint64_t)cycles * 1024u)) : 0u );
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootSlotReadable
+****************************************************************************//**
+*
+* Overrides the function of dfu_boot.c: the XIP slot can be read once the
+* QSPI memory is initialized. Leaves the SMIF in the memory mode.
+*
+* \param appId      The slot.
+*
+* \return 1 - the slot may be read, e.g. validated, else 0.
+*
+*******************************************************************************/
+uint32_t DFU_BootSlotReadable(uint32_t appId)
+{
+    return ( (appId != DFU_BOOT_XIP_APP) || (XipEnable() == CY_DFU_SUCCESS) ) ? 1u : 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiXipWrite
+****************************************************************************//**
+*
+* Programs a row of the XIP slot with a quad page program. Each erase sector
+* of the slot is erased before the first of its rows is programmed, and
+* again when the host writes one of its rows a second time, e.g. when a
+* download restarts. The rows of a download are expected in ascending
+* order, as in a .cyacd2 file. The program is waited for, the SMIF is left
+* in the memory mode.
+*
+* \param address    The row address, in the XIP window.
+* \param ctl        CY_DFU_IOCTL_ERASE to program an erased row.
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer holds the row.
+*
+* \return
+* - CY_DFU_SUCCESS when the row is programmed.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiXipWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = (dfu_qspiReady != 0u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_UNKNOWN;
+    uint32_t start;
+    uint32_t length;
+    uint32_t row = 0u;
+    uint32_t sector = 0u;
+
+    GetSlot(DFU_BOOT_XIP_APP, &start, &length);
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        row    = (address - start) / CY_FLASH_SIZEOF_ROW;
+        sector = (address - start) / QSPI_MEM->deviceCfg->eraseSize;
+        status = ( (address >= start) && (row < DFU_QSPI_XIP_ROWS) && (sector < 32u) )
+                 ? CY_DFU_SUCCESS : CY_DFU_ERROR_ADDRESS;
+    }
+
+    if ( (status == CY_DFU_SUCCESS)
+      && ( ((dfu_qspiXipErased & (1ul << sector)) == 0u)
+        || ((dfu_qspiXipRows[row / 32u] & (1ul << (row % 32u))) != 0u) ) )
+    {
+        const uint32_t sectorRows = QSPI_MEM->deviceCfg->eraseSize / CY_FLASH_SIZEOF_ROW;
+        uint32_t idx;
+
+        status = EraseSector((start - QSPI_MEM->baseAddress) + (sector * QSPI_MEM->deviceCfg->eraseSize));
+        if (status == CY_DFU_SUCCESS)
+        {
+            for (idx = sector * sectorRows; (idx < ((sector + 1u) * sectorRows)) && (idx < DFU_QSPI_XIP_ROWS); ++idx)
+            {
+                dfu_qspiXipRows[idx / 32u] &= ~(1ul << (idx % 32u));
+            }
+            dfu_qspiXipErased |= (1ul << sector);
+        }
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        /* The erased rows read zero, as in the internal flash */
+        if ((ctl & CY_DFU_IOCTL_ERASE) != 0u)
+        {
+            (void) memset(params->dataBuffer, 0, CY_FLASH_SIZEOF_ROW);
+        }
+
+        status = ProgramPage(address - QSPI_MEM->baseAddress, params->dataBuffer);
+        if (status == CY_DFU_SUCCESS)
+        {
+            dfu_qspiXipRows[row / 32u] |= (1ul << (row % 32u));
+            status = XipEnable();
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiXipRead
+****************************************************************************//**
+*
+* Reads or compares rows of the XIP slot through the XIP window.
+*
+* \param address    The address of the first row, in the XIP window.
+* \param length     The length, a multiple of the row size.
+* \param ctl        CY_DFU_IOCTL_COMPARE to compare with params->dataBuffer,
+*                   else the data is read into it.
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return
+* - CY_DFU_SUCCESS when the data is read or equal.
+* - CY_DFU_ERROR_VERIFY if the data differs.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiXipRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    uint32_t start;
+    uint32_t slotLength;
+
+    GetSlot(DFU_BOOT_XIP_APP, &start, &slotLength);
+    if ( (address < start) || ((address + length) > (start + DFU_QSPI_XIP_SIZE)) )
+    {
+        status = CY_DFU_ERROR_ADDRESS;
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        status = XipEnable();
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        if ((ctl & CY_DFU_IOCTL_COMPARE) == 0u)
+        {
+            (void) memcpy(params->dataBuffer, (const void *)address, length);
+        }
+        else
+        {
+            status = ( memcmp(params->dataBuffer, (const void *)address, length) == 0 )
+                     ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_QspiXipRate
+****************************************************************************//**
+*
+* Measures the read rate of the XIP window: reads DFU_QSPI_XIP_RATE_SIZE
+* bytes at the start of the XIP slot with the SMIF cache disabled, then
+* with the cache enabled and invalidated, then the same block again from the
+* cache. The interrupts are disabled meanwhile. The cache is left enabled.
+*
+* \param rate       The pointer to the rates to fill.
+*
+* \return
+* - CY_DFU_SUCCESS when the rates are measured.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_QspiXipRate(dfu_qspi_xip_rate_t *rate)
+{
+    cy_en_dfu_status_t status = XipEnable();
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        const volatile uint32_t *source = (const volatile uint32_t *)CY_DFU_APP3_VERIFY_START;
+        uint32_t intrState;
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        intrState = Cy_SysLib_EnterCriticalSection();
+
+        (void) Cy_SMIF_CacheDisable(SMIF0, CY_SMIF_CACHE_BOTH);
+        rate->uncached = ReadRate(source, DFU_QSPI_XIP_RATE_SIZE);
+
+        (void) Cy_SMIF_CacheEnable(SMIF0, CY_SMIF_CACHE_BOTH);
+        (void) Cy_SMIF_CacheInvalidate(SMIF0, CY_SMIF_CACHE_BOTH);
+        rate->miss = ReadRate(source, DFU_QSPI_XIP_RATE_SIZE);
+        rate->hit  = ReadRate(source, DFU_QSPI_XIP_RATE_SIZE);
+
+        Cy_SysLib_ExitCriticalSection(intrState);
+    }
+    return (status);
+}
+#endif /* DFU_BOOT_XIP != 0 */
+#endif /* (DFU_QSPI_STAGING != 0) || (DFU_QSPI_CACHE != 0) || (DFU_BOOT_XIP != 0) */
+
+
+/* [] END OF FILE */
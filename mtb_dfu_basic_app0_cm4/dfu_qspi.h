@@ -0,0 +1,152 @@
+/***************************************************************************//**
+* \file dfu_qspi.h
+* \version 1.0
+*
+* This file provides the API of the download staging area, the firmware
+* cache and the XIP slot in the external QSPI memory, the S25FL512S of the
+* kit described in cycfg_qspi_memslot.c.
+*
+* With DFU_QSPI_STAGING, the rows of an application slot received by App0 are
+* written to the staging area with quad page program instead of the internal
+* flash. The page program runs while the next row is received, it is only
+* waited for before the next QSPI operation. Rows outside the application
+* slots, e.g. the metadata, are written to the internal flash as usual.
+*
+* The row holding the slot signature is the last one of a download. Once it
+* is staged, the install starts and its Program Data command is answered at
+* once. DFU_QspiInstallTask() runs it in steps from the App0 main loop,
+* between the DFU commands: the staged image is validated, the rows not
+* staged taken from the internal flash, then the copy engine writes the
+* staged rows that differ from the internal flash, one per step, so each
+* updated row is written once. Meanwhile the Verify Application command of
+* the slot is answered from the staged image, see DFU_QspiVerifyStaged(), and
+* the Exit command finishes the install, see DFU_QspiInstall().
+*
+* The staging area is one erase sector, it is erased in the background before
+* App0 starts the DFU transport and after each install.
+*
+* With DFU_QSPI_CACHE, the sectors after the staging area keep the last
+* DFU_QSPI_CACHE_ENTRIES images App0 has validated. Each sector holds one
+* image and, in its first row, the entry header: the slot, the verified
+* length, the digest (the slot signature) and the cache version, which
+* increments with each image cached. The header is programmed last, so an
+* interrupted store leaves no entry. An image already cached, same slot and
+* digest, is not stored again; a new one replaces the entry with the lowest
+* version. DFU_QspiCacheRestore() validates a cached image and writes the
+* rows of its slot that differ from it. The XIP slot is not cached.
+*
+* With DFU_BOOT_XIP in dfu_boot.h, the application slot DFU_BOOT_XIP_APP is
+* at 4 MB in the QSPI memory, at 0x18400000 in the XIP window, and holds an
+* image linked to run from there. Its rows are programmed directly, each
+* erase sector of the slot is erased before the first of its rows. The SMIF
+* is left in the memory mode after each row, with the cache and prefetching
+* enabled, so the DFU SDK and App0 validate the slot through the XIP window.
+* DFU_QspiXipRate() measures the XIP read rate with the cache disabled, and
+* enabled with misses and with hits.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_QSPI_H)
+#define DFU_QSPI_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** A non-zero value enables the download staging area in the QSPI memory */
+#define DFU_QSPI_STAGING            (0)
+
+/** The offset of the staging area in the QSPI memory, erase sector aligned */
+#define DFU_QSPI_STAGING_OFFSET     (0x00000000u)
+
+/** The size of the staging area, one erase sector. Must hold an application slot. */
+#define DFU_QSPI_STAGING_SIZE       (0x00040000u)
+
+/** The number of rows in the staging area */
+#define DFU_QSPI_STAGING_ROWS       (DFU_QSPI_STAGING_SIZE / CY_FLASH_SIZEOF_ROW)
+
+/** A non-zero value enables the firmware cache in the QSPI memory */
+#define DFU_QSPI_CACHE              (0)
+
+/** The number of cache entries, one erase sector each */
+#define DFU_QSPI_CACHE_ENTRIES      (4u)
+
+/** The offset of the cache in the QSPI memory, after the staging area */
+#define DFU_QSPI_CACHE_OFFSET       (DFU_QSPI_STAGING_OFFSET + DFU_QSPI_STAGING_SIZE)
+
+/** The size of a cache entry, one erase sector: the header row and a slot */
+#define DFU_QSPI_CACHE_ENTRY_SIZE   (0x00040000u)
+
+/** The cache entry header tag, the erased memory reads 0xFFFFFFFF */
+#define DFU_QSPI_CACHE_MAGIC        (0x43414348u)
+
+/** The size of the XIP slot, as in the linker scripts: xip_app3_core0 and xip_app3_core1 */
+#define DFU_QSPI_XIP_SIZE           (0x00080000u)
+
+/** The number of rows in the XIP slot */
+#define DFU_QSPI_XIP_ROWS           (DFU_QSPI_XIP_SIZE / CY_FLASH_SIZEOF_ROW)
+
+/** The size of the block read by DFU_QspiXipRate(), less than the SMIF cache */
+#define DFU_QSPI_XIP_RATE_SIZE      (0x00001000u)
+
+/** The SMIF interrupt priority */
+#define DFU_QSPI_INTR_PRIORITY      (3u)
+
+
+/** The header of a cache entry, also the entry in the cache directory */
+typedef struct
+{
+    uint32_t magic;     /**< DFU_QSPI_CACHE_MAGIC if the entry holds an image */
+    uint32_t version;   /**< The cache version, increments with each image cached */
+    uint32_t appId;     /**< The slot the image is built for */
+    uint32_t length;    /**< The verified length of the image, without the signature */
+    uint32_t digest;    /**< The image signature, the CRC-32C of the verified range */
+} dfu_qspi_cache_entry_t;
+
+/** The XIP read rates measured by DFU_QspiXipRate(), in KB/s */
+typedef struct
+{
+    uint32_t uncached;  /**< The SMIF cache disabled */
+    uint32_t miss;      /**< The SMIF cache enabled and invalidated, with prefetching */
+    uint32_t hit;       /**< The same block read again from the SMIF cache */
+} dfu_qspi_xip_rate_t;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+cy_en_dfu_status_t DFU_QspiInit(void);
+cy_en_dfu_status_t DFU_QspiStagingStart(void);
+uint32_t DFU_QspiIsEnabled(uint32_t address);
+cy_en_dfu_status_t DFU_QspiWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_QspiRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params);
+uint32_t DFU_QspiIsComplete(void);
+void DFU_QspiInstallStart(void);
+uint32_t DFU_QspiInstallTask(void);
+uint32_t DFU_QspiInstallingApp(void);
+cy_en_dfu_status_t DFU_QspiVerifyStaged(uint32_t appId);
+cy_en_dfu_status_t DFU_QspiInstall(void);
+cy_en_dfu_status_t DFU_QspiCacheStore(uint32_t appId);
+uint32_t DFU_QspiCacheList(dfu_qspi_cache_entry_t entries[], uint32_t count);
+cy_en_dfu_status_t DFU_QspiCacheRestore(uint32_t version, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_QspiXipWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_QspiXipRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_QspiXipRate(dfu_qspi_xip_rate_t *rate);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_QSPI_H) */
+
+
+/* [] END OF FILE */
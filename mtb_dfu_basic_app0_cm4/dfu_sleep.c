@@ -0,0 +1,196 @@
+/***************************************************************************//**
+* \file dfu_sleep.c
+* \version 1.0
+*
+* This file provides the App0 low-power wait for the host, see dfu_sleep.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include "cy_pdl.h"
+#include "dfu_boot.h"
+#include "dfu_sleep.h"
+
+#if DFU_BOOT_DEEPSLEEP != 0
+
+/* The MCWDT: counter 0 wakes the device, counter 2 is the timebase */
+#define SLEEP_MCWDT             MCWDT_STRUCT0
+#define SLEEP_MCWDT_IRQN        srss_interrupt_mcwdt_0_IRQn
+
+/* The time an MCWDT register update takes, 3 CLK_LF cycles */
+#define SLEEP_MCWDT_WAIT_US     (93u)
+
+/* The counter 0 period */
+#define SLEEP_COUNTER0_MASK     (0xFFFFu)
+
+/* Waits shorter than this, in MCWDT ticks, end without sleeping */
+#define SLEEP_MIN_TICKS         (4u)
+
+/* The interrupt priority, the same as the DFU transport */
+#define SLEEP_INTR_PRIORITY     (7u)
+
+/* A wake event occurred since the last wait */
+static volatile uint32_t dfu_sleepEvent = 0u;
+
+/* The FLL and PLL relock after DeepSleep */
+static cy_stc_syspm_callback_params_t dfu_sleepClkParams;
+static cy_stc_syspm_callback_t dfu_sleepClkCallback =
+{
+    .callback       = &Cy_SysClk_DeepSleepCallback,
+    .type           = CY_SYSPM_DEEPSLEEP,
+    .skipMode       = 0u,
+    .callbackParams = &dfu_sleepClkParams,
+    .prevItm        = NULL,
+    .nextItm        = NULL,
+};
+
+static void McwdtIsr(void);
+
+
+/*******************************************************************************
+* Function Name: McwdtIsr
+****************************************************************************//**
+*
+* This internal function handles the MCWDT interrupt, the end of a wait.
+*
+*******************************************************************************/
+static void McwdtIsr(void)
+{
+    Cy_MCWDT_ClearInterrupt(SLEEP_MCWDT, CY_MCWDT_CTR0);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SleepInit
+****************************************************************************//**
+*
+* Starts the MCWDT counters. Called by App0 before it starts the DFU
+* transport.
+*
+*******************************************************************************/
+void DFU_SleepInit(void)
+{
+    static const cy_stc_mcwdt_config_t mcwdtConfig =
+    {
+        .c0Match        = 0u,
+        .c1Match        = 0u,
+        .c0Mode         = CY_MCWDT_MODE_INT,
+        .c1Mode         = CY_MCWDT_MODE_NONE,
+        .c2ToggleBit    = 0u,
+        .c2Mode         = CY_MCWDT_MODE_NONE,
+        .c0ClearOnMatch = false,
+        .c1ClearOnMatch = false,
+        .c0c1Cascade    = false,
+        .c1c2Cascade    = false,
+    };
+    static const cy_stc_sysint_t mcwdtIntrConfig =
+    {
+        .intrSrc      = SLEEP_MCWDT_IRQN,
+        .intrPriority = SLEEP_INTR_PRIORITY
+    };
+
+    /* Counter 0 interrupts only during a wait */
+    (void) Cy_MCWDT_Init(SLEEP_MCWDT, &mcwdtConfig);
+    Cy_MCWDT_SetInterruptMask(SLEEP_MCWDT, 0u);
+    Cy_MCWDT_Enable(SLEEP_MCWDT, CY_MCWDT_CTR0 | CY_MCWDT_CTR2, SLEEP_MCWDT_WAIT_US);
+    (void) Cy_SysInt_Init(&mcwdtIntrConfig, &McwdtIsr);
+    NVIC_EnableIRQ(SLEEP_MCWDT_IRQN);
+
+    (void) Cy_SysPm_RegisterCallback(&dfu_sleepClkCallback);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SleepTicks
+****************************************************************************//**
+*
+* Returns the timebase, it counts DFU_SLEEP_TICK_HZ in all power modes and
+* wraps around after about 36 hours.
+*
+* \return The MCWDT counter 2.
+*
+*******************************************************************************/
+uint32_t DFU_SleepTicks(void)
+{
+    return (Cy_MCWDT_GetCount(SLEEP_MCWDT, CY_MCWDT_COUNTER2));
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SleepWake
+****************************************************************************//**
+*
+* Records a wake event, it ends the current wait or the next one. Called from
+* the interrupts that need the main loop, e.g. the button.
+*
+*******************************************************************************/
+void DFU_SleepWake(void)
+{
+    dfu_sleepEvent = 1u;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SleepWait
+****************************************************************************//**
+*
+* Sleeps until an interrupt, at most until the timeout or DFU_SLEEP_MAX_WAIT.
+* The caller disables the interrupts and checks the condition it waits for
+* first: an interrupt that comes after the check ends the sleep at once, and
+* is served when the caller enables the interrupts again.
+*
+* \param start      The DFU_SleepTicks() value at the start of the wait.
+* \param timeout    The timeout from the start, in milliseconds.
+* \param deepSleep  Non-zero to sleep in DeepSleep, the wake up sources must
+*                   be DeepSleep capable. Sleep is used if a DeepSleep
+*                   callback is not ready.
+*
+* \return 1 - the wait continues, else 0: the timeout passed or a wake
+*         event occurred, the event is cleared.
+*
+*******************************************************************************/
+uint32_t DFU_SleepWait(uint32_t start, uint32_t timeout, uint32_t deepSleep)
+{
+    const uint32_t elapsed = DFU_SleepTicks() - start;
+    uint32_t remaining = (elapsed < DFU_SLEEP_TICKS(timeout)) ? (DFU_SLEEP_TICKS(timeout) - elapsed) : 0u;
+    uint32_t waiting = ( (remaining != 0u) && (dfu_sleepEvent == 0u) ) ? 1u : 0u;
+
+    if (waiting == 0u)
+    {
+        dfu_sleepEvent = 0u;
+    }
+    else if (remaining >= SLEEP_MIN_TICKS)
+    {
+        if (remaining > DFU_SLEEP_TICKS(DFU_SLEEP_MAX_WAIT))
+        {
+            remaining = DFU_SLEEP_TICKS(DFU_SLEEP_MAX_WAIT);
+        }
+
+        Cy_MCWDT_SetMatch(SLEEP_MCWDT, CY_MCWDT_COUNTER0,
+                          (Cy_MCWDT_GetCount(SLEEP_MCWDT, CY_MCWDT_COUNTER0) + remaining) & SLEEP_COUNTER0_MASK,
+                          SLEEP_MCWDT_WAIT_US);
+        Cy_MCWDT_ClearInterrupt(SLEEP_MCWDT, CY_MCWDT_CTR0);
+        Cy_MCWDT_SetInterruptMask(SLEEP_MCWDT, CY_MCWDT_CTR0);
+
+        if ( (deepSleep == 0u) || (Cy_SysPm_CpuEnterDeepSleep(CY_SYSPM_WAIT_FOR_INTERRUPT) != CY_SYSPM_SUCCESS) )
+        {
+            (void) Cy_SysPm_CpuEnterSleep(CY_SYSPM_WAIT_FOR_INTERRUPT);
+        }
+
+        Cy_MCWDT_SetInterruptMask(SLEEP_MCWDT, 0u);
+    }
+    else
+    {
+        /* Too short to sleep, the caller checks again */
+    }
+    return (waiting);
+}
+#endif /* DFU_BOOT_DEEPSLEEP != 0 */
+
+
+/* [] END OF FILE */
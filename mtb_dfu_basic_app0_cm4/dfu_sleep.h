@@ -0,0 +1,64 @@
+/***************************************************************************//**
+* \file dfu_sleep.h
+* \version 1.0
+*
+* This file provides the API of the App0 low-power wait for the host, used
+* with DFU_BOOT_DEEPSLEEP in dfu_boot.h.
+*
+* The transport waits for a packet in DeepSleep instead of polling: the I2C
+* address match wakes the device and the SCB stretches the clock until it
+* runs again. The MCWDT counts the WCO in DeepSleep, its counter 2 is the
+* timebase and its counter 0 wakes the device at the end of a wait. An edge
+* of the button, see dfu_button.h, is a wake event: it ends the wait for the
+* host.
+*
+* A DeepSleep callback that is not ready, e.g. the I2C with a transfer in
+* progress, makes the wait use Sleep instead.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_SLEEP_H)
+#define DFU_SLEEP_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The MCWDT clock, the WCO through CLK_LF, in Hz */
+#define DFU_SLEEP_TICK_HZ           (32768u)
+
+/** The longest wait, in milliseconds, within the 2 s period of counter 0 */
+#define DFU_SLEEP_MAX_WAIT          (1000u)
+
+/** The timeout of Cy_DFU_Continue() while no download is in progress, in milliseconds */
+#define DFU_SLEEP_IDLE_TIMEOUT      (1000u)
+
+/** The number of MCWDT ticks in a time in milliseconds */
+#define DFU_SLEEP_TICKS(ms)         ((uint32_t)(((uint64_t)(ms) * DFU_SLEEP_TICK_HZ) / 1000u))
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_SleepInit(void);
+uint32_t DFU_SleepTicks(void);
+void DFU_SleepWake(void);
+uint32_t DFU_SleepWait(uint32_t start, uint32_t timeout, uint32_t deepSleep);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_SLEEP_H) */
+
+
+/* [] END OF FILE */
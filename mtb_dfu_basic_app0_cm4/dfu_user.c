@@ -5,7 +5,24 @@
 * This file provides the custom API for a firmware application with 
 * DFU SDK.
 * - Cy_DFU_ReadData (address, length, ctl, params) - to read  the NVM block
-* - Cy_Bootalod_WriteData(address, length, ctl, params) - to write the NVM block
+* - Cy_Bootalod_WriteData(address, length, ctl, params) - to write the NVM block,
+*   decrypting the Program Data first when CY_DFU_OPT_ENCRYPTED_DATA is enabled
+* - DFU_UserSessionStart() - to check the protected ranges again at the next
+*   row write, see BuildRanges()
+*
+* The memory the host may access is a constant table of regions, built from
+* the linker script symbols: the flash after App0, the Emulated EEPROM, the
+* SFlash user rows and, with DFU_BOOT_XIP, the XIP slot. Each region has its
+* row size, access rights and erase/program and read backends, so a read or
+* write takes one compare per region to dispatch.
+*
+* With DFU_BOOT_EEPROM the Emulated EEPROM window is the logical EEPROM of
+* dfu_eeprom.h: the rows written there are committed by App0 at the end of
+* the download, and dropped if the download does not finish.
+*
+* With DFU_QSPI_STAGING the rows of the application slots are written to and
+* read from the QSPI staging area, see dfu_qspi.h. With DFU_BOOT_XIP the rows
+* of the XIP slot are written to and read from the QSPI memory.
 *
 ********************************************************************************
 * \copyright
@@ -19,6 +36,12 @@
 #include "cy_syslib.h"
 #include "cy_flash.h"
 #include "cy_dfu.h"
+#include "dfu_decrypt.h"
+#include "dfu_boot.h"
+#include "dfu_qspi.h"
+#include "dfu_eeprom.h"
+#include "dfu_profile.h"
+#include "dfu_wear.h"
 
 
 /*
@@ -31,12 +54,109 @@ static const uint32_t cy_dfu_metadata[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)] =
 {
     CY_DFU_APP0_VERIFY_START, CY_DFU_APP0_VERIFY_LENGTH, /* The App0 base address and length */
     CY_DFU_APP1_VERIFY_START, CY_DFU_APP1_VERIFY_LENGTH, /* The App1 base address and length */
+    CY_DFU_APP2_VERIFY_START, CY_DFU_APP2_VERIFY_LENGTH, /* The App2 base address and length */
+    CY_DFU_APP3_VERIFY_START, CY_DFU_APP3_VERIFY_LENGTH, /* The XIP slot base address and length */
     0u                                                             /* The rest does not matter     */
 };
 
 
+/* The memory regions, defined in the linker scripts */
+extern uint8_t __cy_dfu_flash_start;
+extern uint8_t __cy_dfu_flash_length;
+extern uint8_t __cy_memory_0_row_size;
+extern uint8_t __cy_memory_1_start;
+extern uint8_t __cy_memory_1_length;
+extern uint8_t __cy_memory_1_row_size;
+extern uint8_t __cy_dfu_sflash_start;
+extern uint8_t __cy_dfu_sflash_length;
+extern uint8_t __cy_memory_2_row_size;
+#if DFU_BOOT_XIP != 0
+extern uint8_t __cy_dfu_xip_start;
+extern uint8_t __cy_dfu_xip_length;
+extern uint8_t __cy_memory_3_row_size;
+#endif /* DFU_BOOT_XIP != 0 */
+
+/* The region access rights */
+#define USER_ACCESS_READ    (0x01u)
+#define USER_ACCESS_WRITE   (0x02u)
+
+/* Programs or erases a row of a region, the address is checked */
+typedef cy_en_dfu_status_t (*dfu_user_write_t)(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params);
+
+/* Reads or compares rows of a region, the address and length are checked */
+typedef cy_en_dfu_status_t (*dfu_user_read_t)(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params);
+
+/* A memory region the downloads may access */
+typedef struct
+{
+    uint32_t startAddress;      /* The first address of the region */
+    uint32_t length;            /* The size of the region */
+    uint32_t rowSize;           /* The size of a row write */
+    uint32_t access;            /* USER_ACCESS_READ and USER_ACCESS_WRITE */
+    dfu_user_write_t write;     /* The erase and program backend */
+    dfu_user_read_t read;       /* The read and compare backend */
+} dfu_user_region_t;
+
+static cy_en_dfu_status_t FlashWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params);
+static cy_en_dfu_status_t FlashRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params);
+#if DFU_BOOT_EEPROM != 0
+static cy_en_dfu_status_t EepromWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params);
+static cy_en_dfu_status_t EepromRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params);
+#endif /* DFU_BOOT_EEPROM != 0 */
+
+/*
+* The regions, from the linker script symbols. App0 itself, the rest of the
+* SFlash and the eFuses are not accessible.
+*/
+static const dfu_user_region_t dfu_userRegions[] =
+{
+    /* The flash after App0, the application slots are staged with DFU_QSPI_STAGING */
+    { (uint32_t)&__cy_dfu_flash_start, (uint32_t)&__cy_dfu_flash_length, (uint32_t)&__cy_memory_0_row_size,
+      USER_ACCESS_READ | USER_ACCESS_WRITE, &FlashWrite, &FlashRead },
+#if DFU_BOOT_EEPROM != 0
+    /* The logical EEPROM, journaled to the Emulated EEPROM flash */
+    { (uint32_t)&__cy_memory_1_start, DFU_EEPROM_SIZE, (uint32_t)&__cy_memory_1_row_size,
+      USER_ACCESS_READ | USER_ACCESS_WRITE, &EepromWrite, &EepromRead },
+#else
+    /* The Emulated EEPROM flash */
+    { (uint32_t)&__cy_memory_1_start, (uint32_t)&__cy_memory_1_length, (uint32_t)&__cy_memory_1_row_size,
+      USER_ACCESS_READ | USER_ACCESS_WRITE, &FlashWrite, &FlashRead },
+#endif /* DFU_BOOT_EEPROM != 0 */
+    /* The SFlash user data rows */
+    { (uint32_t)&__cy_dfu_sflash_start, (uint32_t)&__cy_dfu_sflash_length, (uint32_t)&__cy_memory_2_row_size,
+      USER_ACCESS_READ | USER_ACCESS_WRITE, &FlashWrite, &FlashRead },
+#if DFU_BOOT_XIP != 0
+    /* The XIP slot in the QSPI memory */
+    { (uint32_t)&__cy_dfu_xip_start, (uint32_t)&__cy_dfu_xip_length, (uint32_t)&__cy_memory_3_row_size,
+      USER_ACCESS_READ | USER_ACCESS_WRITE, &DFU_QspiXipWrite, &DFU_QspiXipRead },
+#endif /* DFU_BOOT_XIP != 0 */
+};
+
+/* A range of rows the downloads must not write */
+typedef struct
+{
+    uint32_t startAddress;  /* The first address of the range */
+    uint32_t endAddress;    /* The address after the range */
+} dfu_user_range_t;
+
+/*
+* The protected ranges: the running application and the valid golden images.
+* Built from the metadata at the first row write of a session, so a row
+* check takes a few compares instead of a metadata read and, with
+* CY_DFU_OPT_GOLDEN_IMAGE, an image validation.
+*/
+static dfu_user_range_t dfu_userRanges[1u + CY_DFU_MAX_APPS];
+static uint32_t dfu_userRangeCount = 0u;
+
+/* The protected ranges match the metadata */
+static uint32_t dfu_userRangesValid = 0u;
+
+
 static uint32_t IsMultipleOf(uint32_t value, uint32_t multiple);
 static void GetStartEndAddress(uint32_t appId, uint32_t *startAddress, uint32_t *endAddress);
+static void BuildRanges(cy_stc_dfu_params_t *params);
+static uint32_t IsProtected(uint32_t address);
+static const dfu_user_region_t *GetRegion(uint32_t address, uint32_t length, uint32_t access);
 
 
 /*******************************************************************************
@@ -89,140 +209,368 @@ static void GetStartEndAddress(uint32_t appId, uint32_t *startAddress, uint32_t
 
 
 /*******************************************************************************
-* Function Name: Cy_DFU_WriteData
+* Function Name: BuildRanges
 ****************************************************************************//**
 *
-* This function documentation is part of the DFU SDK API, see the
-* cy_dfu.h file or DFU SDK API Reference Manual for details.
+* This internal function fills the protected ranges from the metadata.
+* With CY_DFU_OPT_GOLDEN_IMAGE a golden image is protected if it is valid.
+*
+* \param params     The pointer to a DFU parameters structure.
 *
 *******************************************************************************/
-cy_en_dfu_status_t Cy_DFU_WriteData (uint32_t address, uint32_t length, uint32_t ctl, 
-                                               cy_stc_dfu_params_t *params)
+static void BuildRanges(cy_stc_dfu_params_t *params)
 {
-    /* application flash limits */
-    /* Note that App0 is out of range */
-    const uint32_t minUFlashAddress = CY_FLASH_BASE + CY_DFU_APP0_VERIFY_LENGTH;
-    const uint32_t maxUFlashAddress = CY_FLASH_BASE + CY_FLASH_SIZE;
-    /* EM_EEPROM Limits*/
-    const uint32_t minEmEepromAddress = CY_EM_EEPROM_BASE;
-    const uint32_t maxEmEepromAddress = CY_EM_EEPROM_BASE + CY_EM_EEPROM_SIZE;
-    
-    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    dfu_user_range_t *range = &dfu_userRanges[0];
 
-    uint32_t app = Cy_DFU_GetRunningApp();
-    uint32_t startAddress;
-    uint32_t endAddress;
-    
-    GetStartEndAddress(app, &startAddress, &endAddress);
+    /* It is forbidden to overwrite the currently running application */
+    GetStartEndAddress(Cy_DFU_GetRunningApp(), &range->startAddress, &range->endAddress);
+    dfu_userRangeCount = 1u;
 
-    /* Check if the address  and length are valid 
-     * Note Length = 0 is valid for erase command */
-    if ( (IsMultipleOf(address, CY_FLASH_SIZEOF_ROW) == 0u) || 
-         ( (length != CY_FLASH_SIZEOF_ROW) && ( (ctl & CY_DFU_IOCTL_ERASE) == 0u) ) )
-    {
-        status = CY_DFU_ERROR_LENGTH;   
-    }
-
-    /* Refuse to write to a row within a range of the current application */ 
-    if ( (startAddress <= address) && (address < endAddress) )
-    {   /* It is forbidden to overwrite the currently running application */
-        status = CY_DFU_ERROR_ADDRESS;
-    }
 #if CY_DFU_OPT_GOLDEN_IMAGE
-    if (status == CY_DFU_SUCCESS)
     {
         uint8_t goldenImages[] = { CY_DFU_GOLDEN_IMAGE_IDS() };
         uint32_t count = sizeof(goldenImages) / sizeof(goldenImages[0]);
         uint32_t idx;
-        for (idx = 0u; idx < count; ++idx)
+        for (idx = 0u; (idx < count) && (dfu_userRangeCount < (1u + CY_DFU_MAX_APPS)); ++idx)
         {
-            app = goldenImages[idx];
-            GetStartEndAddress(app, &startAddress, &endAddress);
+            if (Cy_DFU_ValidateApp(goldenImages[idx], params) == CY_DFU_SUCCESS)
+            {
+                range = &dfu_userRanges[dfu_userRangeCount];
+                GetStartEndAddress(goldenImages[idx], &range->startAddress, &range->endAddress);
+                dfu_userRangeCount++;
+            }
+        }
+    }
+#else
+    (void) params;
+#endif /* CY_DFU_OPT_GOLDEN_IMAGE != 0 */
+
+    dfu_userRangesValid = 1u;
+}
+
+
+/*******************************************************************************
+* Function Name: IsProtected
+****************************************************************************//**
+*
+* This internal function checks an address against the protected ranges.
+*
+* \param address    The address to check.
+*
+* \return 1 - the address is in a protected range, else 0.
+*
+*******************************************************************************/
+static uint32_t IsProtected(uint32_t address)
+{
+    uint32_t protect = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; (idx < dfu_userRangeCount) && (protect == 0u); ++idx)
+    {
+        protect = ( (dfu_userRanges[idx].startAddress <= address) && (address < dfu_userRanges[idx].endAddress) ) ? 1u : 0u;
+    }
+    return (protect);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_UserSessionStart
+****************************************************************************//**
+*
+* Makes the next row write build the protected ranges again. Called by App0
+* while no download is in progress, a golden image written by a download is
+* protected from the next download on. With DFU_BOOT_EEPROM the rows of the
+* logical EEPROM written by a download that did not finish are dropped.
+*
+*******************************************************************************/
+void DFU_UserSessionStart(void)
+{
+    dfu_userRangesValid = 0u;
+#if DFU_BOOT_EEPROM != 0
+    DFU_EepromDiscard();
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: GetRegion
+****************************************************************************//**
+*
+* This internal function finds the region of an access.
+*
+* \param address    The first address of the access.
+* \param length     The size of the access.
+* \param access     USER_ACCESS_READ or USER_ACCESS_WRITE.
+*
+* \return The region, or NULL if no region holds the whole access with the
+*         access right.
+*
+*******************************************************************************/
+static const dfu_user_region_t *GetRegion(uint32_t address, uint32_t length, uint32_t access)
+{
+    const dfu_user_region_t *region = NULL;
+    uint32_t idx;
 
-            if ( (startAddress <= address) && (address < endAddress) )
+    for (idx = 0u; idx < (sizeof(dfu_userRegions) / sizeof(dfu_userRegions[0])); ++idx)
+    {
+        const uint32_t offset = address - dfu_userRegions[idx].startAddress;
+
+        if (offset < dfu_userRegions[idx].length)
+        {
+            if ( ((dfu_userRegions[idx].access & access) != 0u) && (length <= (dfu_userRegions[idx].length - offset)) )
             {
-                status = Cy_DFU_ValidateApp(app, params);
-                status = (status == CY_DFU_SUCCESS) ? CY_DFU_ERROR_ADDRESS : CY_DFU_SUCCESS;
-                break;
+                region = &dfu_userRegions[idx];
             }
+            break;
         }
-    } 
-#endif /* #if CY_DFU_OPT_GOLDEN_IMAGE != 0 */
-    
-    /* Check if the address is inside the valid range */
-    if ( ( (minUFlashAddress <= address) && (address < maxUFlashAddress) ) 
-      || ( (minEmEepromAddress <= address) && (address < maxEmEepromAddress) )  )
-    {   /* Do nothing, this is an allowed memory range to update to */
     }
-    else
+    return (region);
+}
+
+
+/*******************************************************************************
+* Function Name: FlashWrite
+****************************************************************************//**
+*
+* This internal function erases or programs a row of the internal flash,
+* or stages it in the QSPI memory with DFU_QSPI_STAGING.
+*
+* \param address    The row address.
+* \param ctl        The write control, see Cy_DFU_WriteData().
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return See Cy_DFU_WriteData().
+*
+*******************************************************************************/
+static cy_en_dfu_status_t FlashWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status;
+
+#if DFU_QSPI_STAGING != 0
+    /* Stage the application rows, the main loop installs the image after its last row */
+    if (DFU_QspiIsEnabled(address) != 0u)
     {
-        status = CY_DFU_ERROR_ADDRESS;   
+        status = DFU_QspiWrite(address, ctl, params);
+        if ( (status == CY_DFU_SUCCESS) && (DFU_QspiIsComplete() != 0u) )
+        {
+            DFU_QspiInstallStart();
+        }
     }
-    
-    if (status == CY_DFU_SUCCESS)
+    else
+#endif /* DFU_QSPI_STAGING != 0 */
     {
         if ((ctl & CY_DFU_IOCTL_ERASE) != 0u)
         {
             (void) memset(params->dataBuffer, 0, CY_FLASH_SIZEOF_ROW);
         }
+        const uint32_t start = DFU_PROFILE_BEGIN();
+        const uint32_t wearStart = DFU_WEAR_BEGIN();
         cy_en_flashdrv_status_t fstatus =  Cy_Flash_WriteRow(address, (uint32_t*)params->dataBuffer);
+
+        DFU_PROFILE_END(DFU_PROFILE_FLASH, start);
         status = (fstatus == CY_FLASH_DRV_SUCCESS) ? CY_DFU_SUCCESS : CY_DFU_ERROR_DATA;
+        DFU_WEAR_ROW(address, ctl & CY_DFU_IOCTL_ERASE, (status != CY_DFU_SUCCESS) ? 1u : 0u, wearStart);
     }
     return (status);
 }
 
 
 /*******************************************************************************
-* Function Name: Cy_DFU_ReadData
+* Function Name: FlashRead
+****************************************************************************//**
+*
+* This internal function reads or compares rows of the memory mapped flash,
+* or of the QSPI staging area with DFU_QSPI_STAGING.
+*
+* \param address    The first address.
+* \param length     The size, in bytes.
+* \param ctl        The read control, see Cy_DFU_ReadData().
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return See Cy_DFU_ReadData().
+*
+*******************************************************************************/
+static cy_en_dfu_status_t FlashRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status;
+
+#if DFU_QSPI_STAGING != 0
+    /* The application rows may be staged */
+    if (DFU_QspiIsEnabled(address) != 0u)
+    {
+        status = DFU_QspiRead(address, length, ctl, params);
+    }
+    else
+#endif /* DFU_QSPI_STAGING != 0 */
+    if ((ctl & CY_DFU_IOCTL_COMPARE) == 0u)
+    {
+        (void) memcpy(params->dataBuffer, (const void *)address, length);
+        status = CY_DFU_SUCCESS;
+    }
+    else
+    {
+        status = ( memcmp(params->dataBuffer, (const void *)address, length) == 0 )
+                 ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
+    }
+    return (status);
+}
+
+
+#if DFU_BOOT_EEPROM != 0
+/*******************************************************************************
+* Function Name: EepromWrite
+****************************************************************************//**
+*
+* This internal function erases or writes a row of the logical EEPROM, the
+* change is committed at the end of the download.
+*
+* \param address    The row address.
+* \param ctl        The write control, see Cy_DFU_WriteData().
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return See Cy_DFU_WriteData().
+*
+*******************************************************************************/
+static cy_en_dfu_status_t EepromWrite(uint32_t address, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    if ((ctl & CY_DFU_IOCTL_ERASE) != 0u)
+    {
+        (void) memset(params->dataBuffer, 0, CY_FLASH_SIZEOF_ROW);
+    }
+    return (DFU_EepromWrite(address - (uint32_t)&__cy_memory_1_start, params->dataBuffer, CY_FLASH_SIZEOF_ROW));
+}
+
+
+/*******************************************************************************
+* Function Name: EepromRead
+****************************************************************************//**
+*
+* This internal function reads or compares rows of the logical EEPROM, with
+* the rows written by the download in progress.
+*
+* \param address    The first address.
+* \param length     The size, in bytes.
+* \param ctl        The read control, see Cy_DFU_ReadData().
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return See Cy_DFU_ReadData().
+*
+*******************************************************************************/
+static cy_en_dfu_status_t EepromRead(uint32_t address, uint32_t length, uint32_t ctl, cy_stc_dfu_params_t *params)
+{
+    const uint32_t offset = address - (uint32_t)&__cy_memory_1_start;
+
+    return ( ((ctl & CY_DFU_IOCTL_COMPARE) == 0u) ? DFU_EepromRead(offset, params->dataBuffer, length)
+                                                  : DFU_EepromCompare(offset, params->dataBuffer, length) );
+}
+#endif /* DFU_BOOT_EEPROM != 0 */
+
+
+/*******************************************************************************
+* Function Name: Cy_DFU_WriteData
 ****************************************************************************//**
 *
 * This function documentation is part of the DFU SDK API, see the
 * cy_dfu.h file or DFU SDK API Reference Manual for details.
 *
 *******************************************************************************/
-cy_en_dfu_status_t Cy_DFU_ReadData (uint32_t address, uint32_t length, uint32_t ctl, 
-                                              cy_stc_dfu_params_t *params)
+cy_en_dfu_status_t Cy_DFU_WriteData (uint32_t address, uint32_t length, uint32_t ctl, 
+                                               cy_stc_dfu_params_t *params)
 {
-    /* application flash limits */
-    /* Note that App0 is out of range */
-    const uint32_t minUFlashAddress = CY_FLASH_BASE + CY_DFU_APP0_VERIFY_LENGTH;
-    const uint32_t maxUFlashAddress = CY_FLASH_BASE + CY_FLASH_SIZE;
-    /* EM_EEPROM Limits*/
-    const uint32_t minEmEepromAddress = CY_EM_EEPROM_BASE;
-    const uint32_t maxEmEepromAddress = CY_EM_EEPROM_BASE + CY_EM_EEPROM_SIZE;
+    const uint32_t start = DFU_PROFILE_BEGIN();
+
+    /* The metadata row, its copies are logged by App0 elsewhere */
+    const uint32_t metadataAddress = (uint32_t)&__cy_boot_metadata_addr;
     
-    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    /* Check if the address is inside a writable region */
+    const dfu_user_region_t *region = GetRegion(address, 1u, USER_ACCESS_WRITE);
 
-    /* Check if the length is valid */
-    if (IsMultipleOf(length, CY_FLASH_SIZEOF_ROW) == 0u) 
+    cy_en_dfu_status_t status = (region != NULL) ? CY_DFU_SUCCESS : CY_DFU_ERROR_ADDRESS;
+
+    if (dfu_userRangesValid == 0u)
+    {
+        BuildRanges(params);
+    }
+
+    /* Check if the address  and length are valid 
+     * Note Length = 0 is valid for erase command */
+    if ( (status == CY_DFU_SUCCESS) && 
+         ( (IsMultipleOf(address, region->rowSize) == 0u) || 
+           ( (length != region->rowSize) && ( (ctl & CY_DFU_IOCTL_ERASE) == 0u) ) ) )
     {
         status = CY_DFU_ERROR_LENGTH;   
     }
 
-    /* Check if the address is inside the valid range */
-    if ( ( (minUFlashAddress <= address) && (address < maxUFlashAddress) ) 
-      || ( (minEmEepromAddress <= address) && (address < maxEmEepromAddress) )  )
-    {   /* Do nothing, this is an allowed memory range to update to */
+    /* Refuse to write to a row within a range of the current application,
+     * or of a valid golden image */ 
+    if (IsProtected(address) != 0u)
+    {
+        status = CY_DFU_ERROR_ADDRESS;
     }
-    else
+
+    /* Refuse to write the boot control rows and the application slot App0 starts */
+    if (status == CY_DFU_SUCCESS)
     {
-        status = CY_DFU_ERROR_ADDRESS;   
+        status = DFU_BootCheckWrite(address);
+    }
+    
+#if CY_DFU_OPT_ENCRYPTED_DATA != 0
+    /* Decrypt the Program Data payload in place. Erase requests and the
+     * metadata row written by the DFU SDK and App0 itself is plain. */
+    if ( (status == CY_DFU_SUCCESS) && ((ctl & CY_DFU_IOCTL_ERASE) == 0u) 
+      && ( (address < metadataAddress) || (address >= (metadataAddress + CY_FLASH_SIZEOF_ROW)) ) )
+    {
+        status = DFU_DecryptData(address, params->dataBuffer, length, params->encryptionVector);
+    }
+#endif /* CY_DFU_OPT_ENCRYPTED_DATA != 0 */
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        status = region->write(address, ctl, params);
+    }
+
+    /* Set App Metadata writes the metadata, the ranges change */
+    if ( (address >= metadataAddress) && (address < (metadataAddress + CY_FLASH_SIZEOF_ROW)) )
+    {
+        dfu_userRangesValid = 0u;
+    }
+
+    DFU_PROFILE_END(DFU_PROFILE_WRITE_DATA, start);
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: Cy_DFU_ReadData
+****************************************************************************//**
+*
+* This function documentation is part of the DFU SDK API, see the
+* cy_dfu.h file or DFU SDK API Reference Manual for details.
+*
+*******************************************************************************/
+cy_en_dfu_status_t Cy_DFU_ReadData (uint32_t address, uint32_t length, uint32_t ctl, 
+                                              cy_stc_dfu_params_t *params)
+{
+    const uint32_t start = DFU_PROFILE_BEGIN();
+
+    /* Check if the rows are inside a readable region */
+    const dfu_user_region_t *region = GetRegion(address, length, USER_ACCESS_READ);
+
+    cy_en_dfu_status_t status = (region != NULL) ? CY_DFU_SUCCESS : CY_DFU_ERROR_ADDRESS;
+
+    /* Check if the length is valid */
+    if ( (status == CY_DFU_SUCCESS) && (IsMultipleOf(length, region->rowSize) == 0u) )
+    {
+        status = CY_DFU_ERROR_LENGTH;   
     }
 
     /* Read or Compare */
     if (status == CY_DFU_SUCCESS)
     {
-        if ((ctl & CY_DFU_IOCTL_COMPARE) == 0u)
-        {
-            (void) memcpy(params->dataBuffer, (const void *)address, length);
-            status = CY_DFU_SUCCESS;
-        }
-        else
-        {
-            status = ( memcmp(params->dataBuffer, (const void *)address, length) == 0 )
-                     ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
-        }
+        status = region->read(address, length, ctl, params);
     }
+
+    DFU_PROFILE_END(DFU_PROFILE_READ_DATA, start);
     return (status);
 }
 
@@ -4,10 +4,14 @@
 *
 * This file provides App0 Core1 example source.
 * App0 Core1 firmware does the following:
-* - Downloads App1 firmware image if Host sends it
+* - Downloads App1 firmware image if Host sends it, to a slot in the internal
+*   flash or to the XIP slot in the QSPI memory
 * - Switches to App1 if App1 image has successfully downloaded and is valid
-* - Switches to existing App1 if button is pressed
+* - Restores an image of the firmware cache if Host requests it
+* - Switches to existing App1 if button is pressed, or a CapSense button
+*   with DFU_BOOT_TOUCH
 * - Blinks a LED
+* - Waits for Host in DeepSleep, with DFU_BOOT_DEEPSLEEP
 * - Halts on timeout
 *
 ********************************************************************************
@@ -22,22 +26,51 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "cy_dfu.h"
+#include "dfu_decrypt.h"
+#include "dfu_boot.h"
+#include "dfu_qspi.h"
+#include "dfu_cmd.h"
+#include "dfu_sleep.h"
+#include "dfu_timer.h"
+#include "dfu_button.h"
+#include "dfu_touch.h"
+#include "flash_log.h"
+#include "dfu_eeprom.h"
+#include "dfu_settings.h"
+#include "dfu_profile.h"
+#include "dfu_trace.h"
+#include "dfu_wear.h"
 #include <string.h>
 
-/*
-* For usage with Cy_GPIO_Read(PIN_SW2) and Cy_GPIO_Write(PIN_SW2, value)
-* instead of Cy_GPII_Read(GPIO_PTR0, 4u) and Cy_GPIO_Write(GPIO_PTR0, 4u, value)
-*
-* Pin for user button SW2.
-*/
-#define PIN_SW2     GPIO_PRT0, 4u
-
 /*
 * For usage with Cy_GPIO_Inv(PIN_LED) instead of Cy_GPIO_Inv(GPIO_PRT0, 3u).
 * Defines a red LED pin's "port" and "pin number".
 */
 #define PIN_LED     GPIO_PRT13, 7u
 
+/* Timeouts of the DFU timers, in milliseconds, the defaults of the settings */
+#define SESSION_TIMEOUT     (5000u)     /* No command during a download restarts DFU */
+#define IDLE_TIMEOUT        (300000u)   /* No image received switches to the selected slot */
+#define BLINK_PERIOD        (1000u)     /* LED toggle period */
+
+#if DFU_BOOT_SINGLE_BUFFER != 0
+/*
+* The offset of the packet in the single buffer: after the row data assembled,
+* aligned, and a gap the data of the packet can not fill, so the DFU SDK copies
+* it down without an overlap and writes the response after the row data.
+*/
+#define PACKET_OFFSET(dataOffset)   ( ( ((((dataOffset) < CY_DFU_SIZEOF_DATA_BUFFER) ? \
+                                          (dataOffset) : CY_DFU_SIZEOF_DATA_BUFFER) + 3u) & ~3u ) \
+                                      + DFU_BOOT_PACKET_SIZE )
+#endif /* DFU_BOOT_SINGLE_BUFFER != 0 */
+
+/* The size of a metadata copy: 8 bytes per application and the metadata CRC */
+#define MD_COPY_SIZE        ((CY_DFU_MAX_APPS * 8u) + 4u)
+
+/* The log of the metadata copies, see HandleMetadata() */
+extern uint8_t __cy_boot_md_log_addr;
+extern uint8_t __cy_boot_md_log_length;
+
 #if CY_DFU_OPT_CRYPTO_HW != 0
     /* Scenario: Configure Server and Client as follows:
      * Server:
@@ -96,48 +129,6 @@
 #endif /* CY_DFU_OPT_CRYPTO_HW != 0 */
 
 
-/*******************************************************************************
-* Function Name: CopyRow
-********************************************************************************
-* Copies data from a "src" address to a flash row with the address "dest".
-* If "src" data is the same as "dest" data then no copy is needed.
-*
-* Parameters:
-*  dest     Destination address. Has to be an address of the start of flash row.
-*  src      Source address. Has to be properly aligned.
-*  rowSize  Size of flash row.
-*
-* Returns:
-*  CY_DFU_SUCCESS if operation is successful.
-*  Error code in a case of failure.
-*******************************************************************************/
-cy_en_dfu_status_t CopyRow(uint32_t dest, uint32_t src, uint32_t rowSize, cy_stc_dfu_params_t * params)
-{
-    cy_en_dfu_status_t status;
-    
-    /* Save params->dataBuffer value */
-    uint8_t *buffer = params->dataBuffer;
-
-    /* Compare "dest" and "src" content */
-    params->dataBuffer = (uint8_t *)src;
-    status = Cy_DFU_ReadData(dest, rowSize, CY_DFU_IOCTL_COMPARE, params);
-    
-    /* Restore params->dataBuffer */
-    params->dataBuffer = buffer;
-
-    /* If "dest" differs from "src" then copy "src" to "dest" */
-    if (status != CY_DFU_SUCCESS)
-    {
-        (void) memcpy((void *) params->dataBuffer, (const void*)src, rowSize);
-        status = Cy_DFU_WriteData(dest, rowSize, CY_DFU_IOCTL_WRITE, params);
-    }
-    /* Restore params->dataBuffer */
-    params->dataBuffer = buffer;
-    
-    return (status);
-}
-
-
 /*******************************************************************************
 * Function Name: HandleMetadata
 ********************************************************************************
@@ -145,21 +136,25 @@ cy_en_dfu_status_t CopyRow(uint32_t dest, uint32_t src, uint32_t rowSize, cy_stc
 * The following algorithm is used (in C-like pseudocode):
 * ---
 * if (isValid(MD) == true)
-* {   if (MDC != MD)
-*         MDC = MD;
+* {   if (latest(LOG) != MD)
+*         append(LOG, MD);
 * } else
-* {   if(isValid(MDC) )
-*         MD = MDC;
+* {   if (exists(latest(LOG)) )
+*         MD = latest(LOG);
 *     else
 *         MD = INITIAL_VALUE;
 * }
 * ---
-* Here MD is metadata flash row, MDC is flash row with metadata copy,
+* Here MD is metadata flash row, LOG is the log of the metadata copies,
 * INITIAL_VALUE is known initial value.
 *
-* In this code example MDC is placed in the next flash row after the MD, and
-* INITIAL_VALUE is MD with only CRC, App0 start and size initialized,
-* all the other fields are not touched.
+* The DFU SDK reads MD from its fixed row, so only the copies are logged. LOG
+* is a flash_log.h ring over the flash_boot_md_log rows: each copy goes to the
+* row after the latest one with a sequence number and a checksum, so the
+* copies wear the rows in turn, and a copy interrupted by a reset leaves the
+* previous one in place. A copy holds the metadata part of MD, the
+* applications and the metadata CRC. INITIAL_VALUE is MD with only CRC,
+* App0 start and size initialized, all the other fields are not touched.
 *
 * Parameters:
 *  params   A pointer to a DFU SDK parameters structure.
@@ -172,23 +167,38 @@ cy_en_dfu_status_t HandleMetadata(cy_stc_dfu_params_t *params)
 {
     const uint32_t MD     = (uint32_t)(&__cy_boot_metadata_addr   ); /* MD address  */
     const uint32_t mdSize = (uint32_t)(&__cy_boot_metadata_length ); /* MD size, assumed to be one flash row */
-    const uint32_t MDC    = MD + mdSize;                             /* MDC address */
+    const flash_log_t log =
+    {
+        .address = (uint32_t)(&__cy_boot_md_log_addr),
+        .rows    = (uint32_t)(&__cy_boot_md_log_length) / CY_FLASH_SIZEOF_ROW
+    };
+    uint32_t copy[MD_COPY_SIZE / sizeof(uint32_t)];
 
     cy_en_dfu_status_t status = CY_DFU_SUCCESS;
     
     status = Cy_DFU_ValidateMetadata(MD, params);
     if (status == CY_DFU_SUCCESS)
     {
-        /* Checks if MDC equals to DC, if no then copies MD to MDC */
-        status = CopyRow(MDC, MD, mdSize, params);
+        /* Appends MD to the log if the latest copy differs */
+        if ( (FlashLog_Read(&log, copy, MD_COPY_SIZE, NULL, params) != CY_DFU_SUCCESS)
+          || (memcmp(copy, (const void *)MD, MD_COPY_SIZE) != 0) )
+        {
+            status = FlashLog_Append(&log, (const void *)MD, MD_COPY_SIZE, params);
+        }
     }
     else
     {
-        status = Cy_DFU_ValidateMetadata(MDC, params);
+        status = FlashLog_Read(&log, copy, MD_COPY_SIZE, NULL, params);
+        if (status == CY_DFU_SUCCESS)
+        {
+            /* Copy the latest copy to MD, the rest of the row is not used */
+            (void) memset(params->dataBuffer, 0, mdSize);
+            (void) memcpy(params->dataBuffer, copy, MD_COPY_SIZE);
+            status = Cy_DFU_WriteData(MD, mdSize, CY_DFU_IOCTL_WRITE, params);
+        }
         if (status == CY_DFU_SUCCESS)
         {
-            /* Copy MDC to MD */
-            status = CopyRow(MD, MDC, mdSize, params);
+            status = Cy_DFU_ValidateMetadata(MD, params);
         }
         if (status != CY_DFU_SUCCESS)
         {
@@ -202,58 +212,25 @@ cy_en_dfu_status_t HandleMetadata(cy_stc_dfu_params_t *params)
 }
 
 
-/*******************************************************************************
-* Function Name: counterTimeoutSeconds
-********************************************************************************
-* Returns number of counts that correspond to number of seconds passed as
-* a parameter.
-* E.g. comparing counter with 300 seconds is like this.
-* ---
-* uint32_t counter = 0u;
-* for (;;)
-* {
-*     Cy_SysLib_Delay(UART_TIMEOUT);
-*     ++count;
-*     if (count >= counterTimeoutSeconds(seconds: 300u, timeout: UART_TIMEOUT))
-*     {
-*         count = 0u;
-*         DoSomething();
-*     }
-* }
-* ---
-*
-* Both parameters are required to be compile time constants,
-* so this function gets optimized out to single constant value.
-*
-* Parameters:
-*  seconds    Number of seconds to pass. Must be less that 4_294_967 seconds.
-*  timeout    Timeout for Cy_DFU_Continue() function, in milliseconds.
-*             Must be greater than zero.
-*             It is recommended to be a value that produces no reminder
-*             for this function to be precise.
-* Return:
-*  See description.
-*******************************************************************************/
-static uint32_t counterTimeoutSeconds(uint32_t seconds, uint32_t timeout);
-static uint32_t counterTimeoutSeconds(uint32_t seconds, uint32_t timeout)
-{
-    return (seconds * 1000ul) / timeout;
-}
-
-
 /*******************************************************************************
 * Function Name: main
 ********************************************************************************
 *
 * Summary:
 *  Main function of the firmware application.
-*  1. If application started from Non-Software reset it validates app #1
-*  1.1. If app#1 is valid it switches to app#1, else goto #2.
-*  2. Start DFU communication.
+*  1. Selects the application slot to start, the active one if it is valid,
+*     else the previous one.
+*  1.1. If application started from Non-Software reset and there is a valid
+*       slot it switches to it, else goto #2.
+*  2. Start DFU communication, the selected slot can not be overwritten.
 *  3. If updated application has been received it validates this app.
-*  4. If app#1 is valid it switches to it, else wait for new application.
+*  4. If it is valid it makes its slot active and switches to it, else wait
+*     for new application.
 *  5. If 300 seconds has passed and no new application has been received
-*     then validate app#1, if it is valid then switch to it, else freeze.
+*     then switch to the selected slot if there is one, else freeze.
+*  The timeouts and the LED blink are timed by the timers of dfu_timer.h,
+*  whatever time a loop turn takes.
+*  With DFU_BOOT_DEEPSLEEP it waits for the Host in DeepSleep.
 *
 * Parameters:
 *  seconds    Number of seconds to pass
@@ -265,8 +242,12 @@ static uint32_t counterTimeoutSeconds(uint32_t seconds, uint32_t timeout)
 *******************************************************************************/
 int main(void)
 {
-    /* timeout for Cy_DFU_Continue(), in milliseconds */
-    const uint32_t paramsTimeout = 20u;
+    /* timeout for Cy_DFU_Continue(), in milliseconds, see dfu_settings.h */
+    uint32_t paramsTimeout = 20u;
+
+    /* The timeouts of the DFU timers, from the settings */
+    uint32_t sessionTimeout;
+    uint32_t idleTimeout;
     
     /* DFU params, used to configure DFU */
     cy_stc_dfu_params_t dfuParams;
@@ -283,37 +264,71 @@ int main(void)
     */
     uint32_t state;
 
-    /*
-    * Used to count seconds, to convert counts to seconds use
-    * counterTimeoutSeconds(SECONDS, paramsTimeout)
-    */
-    uint32_t count = 0;
+    /* No command received in sessionTimeout during a download */
+    static dfu_timer_t sessionTimer;
+
+    /* No image received in idleTimeout */
+    static dfu_timer_t idleTimer;
+
+    /* Toggles the LED */
+    static dfu_timer_t blinkTimer;
+
+    /* The application slot to start, 0 if none is valid */
+    uint32_t app;
+
+    /* The button or a CapSense button was clicked */
+    uint32_t clicked;
+
+    /* The start of Cy_DFU_Continue(), with DFU_BOOT_PROFILE */
+    uint32_t start;
+
+#if DFU_BOOT_TRACE != 0
+    /* The state traced last, see dfu_trace.h */
+    uint32_t traced = CY_DFU_STATE_NONE;
+#endif
     
 #if CY_DFU_OPT_CRYPTO_HW != 0
     cy_en_crypto_status_t cryptoStatus;
 #endif
 
+#if DFU_BOOT_SINGLE_BUFFER != 0
+    /* Buffer to store DFU commands, then the gap and the packet, see PACKET_OFFSET() */
+    CY_ALIGN(4) static uint8_t buffer[CY_DFU_SIZEOF_DATA_BUFFER + (2u * DFU_BOOT_PACKET_SIZE)];
+#else
     /* Buffer to store DFU commands */
     CY_ALIGN(4) static uint8_t buffer[CY_DFU_SIZEOF_DATA_BUFFER];
 
     /* Buffer for DFU packets for Transport API */
     CY_ALIGN(4) static uint8_t packet[CY_DFU_SIZEOF_CMD_BUFFER ];    
+#endif
+
+#if CY_DFU_OPT_SET_EIVECTOR != 0
+    /* Buffer for the initial counter block received with Set EI Vector */
+    CY_ALIGN(4) static uint8_t encryptionVector[DFU_DECRYPT_EIV_SIZE];
+#endif
     
     /* Enable global interrupts */
     __enable_irq();
     
+#if DFU_BOOT_TRACE != 0
+    /* Record the start in the trace kept over the resets */
+    DFU_TraceInit(0u);
+#endif
+
 #if CY_DFU_OPT_CRYPTO_HW != 0
     /* Initialize the Crypto Client code */
     cryptoStatus = Cy_Crypto_Init(&myCryptoConfig, &myCryptoContext);
     if (cryptoStatus != CY_CRYPTO_SUCCESS)
     {
         /* Crypto not initialized, debug what is the problem */
+        DFU_TRACE(DFU_TRACE_HALT, CY_DFU_STATE_NONE, cryptoStatus);
         Cy_SysLib_Halt(0x00u);
     }
     cryptoStatus = Cy_Crypto_Enable();
     if (cryptoStatus != CY_CRYPTO_SUCCESS)
     {
         /* Crypto not initialized, debug what is the problem */
+        DFU_TRACE(DFU_TRACE_HALT, CY_DFU_STATE_NONE, cryptoStatus);
         Cy_SysLib_Halt(0x00u);
     }
 #endif /* CY_DFU_OPT_CRYPTO_HW != 0 */
@@ -321,59 +336,227 @@ int main(void)
     /* Initialize dfuParams structure and DFU SDK state */
     dfuParams.timeout          = paramsTimeout;
     dfuParams.dataBuffer       = &buffer[0];
+#if DFU_BOOT_SINGLE_BUFFER != 0
+    dfuParams.packetBuffer     = &buffer[PACKET_OFFSET(0u)];
+#else
     dfuParams.packetBuffer     = &packet[0];
+#endif
+#if CY_DFU_OPT_SET_EIVECTOR != 0
+    dfuParams.encryptionVector = &encryptionVector[0];
+#endif
 
     status = Cy_DFU_Init(&state, &dfuParams);
 
+#if DFU_BOOT_WEAR != 0
+    /* Count the row writes from the metadata on, see dfu_wear.h */
+    DFU_WearInit(&dfuParams);
+#endif
+
     /* Ensure DFU Metadata is valid */
     status = HandleMetadata(&dfuParams);
     if (status != CY_DFU_SUCCESS)
     {
+        DFU_TRACE(DFU_TRACE_HALT, state, status);
         Cy_SysLib_Halt(0x00u);
     }
+
+    /* Apply the settings, the transport reads the I2C address when started */
+    DFU_SettingsInit(&dfuParams);
+    paramsTimeout     = DFU_SettingsGet(DFU_SETTING_PACKET_TIMEOUT, paramsTimeout);
+    sessionTimeout    = DFU_SettingsGet(DFU_SETTING_SESSION_TIMEOUT, SESSION_TIMEOUT);
+    idleTimeout       = DFU_SettingsGet(DFU_SETTING_IDLE_TIMEOUT, IDLE_TIMEOUT);
+    dfuParams.timeout = paramsTimeout;
     
+#if DFU_BOOT_XIP != 0
+    /* The XIP slot is validated through the XIP window */
+    (void) DFU_QspiInit();
+#endif
+
+    /* Select the application slot to start, it is kept from being overwritten */
+    app = DFU_BootSelectApp(&dfuParams);
+
     /*
     * In the case of non-software reset check if there is a valid app image.
     * If these is - switch to it.
     */
     if (Cy_SysLib_GetResetReason() != CY_SYSLIB_RESET_SOFT)
     {
-        status = Cy_DFU_ValidateApp(1u, &dfuParams);
-        if (status == CY_DFU_SUCCESS)
+        if (app != 0u)
         {
             /*
             * Clear the reset reason because Cy_DFU_ExecuteApp() performs a 
             * software reset. Without clearing it, two reset reasons would be 
-            * present.
+            * present. With the direct handoff there is no reset, App1 sees 
+            * no reset reason either way.
             */
             do
             {
                 Cy_SysLib_ClearResetReason();
             }while(Cy_SysLib_GetResetReason() != 0);
 
+        #if DFU_BOOT_WEAR != 0
+            (void) DFU_WearCommit(&dfuParams);
+        #endif
+
             /* Never returns */
-            Cy_DFU_ExecuteApp(1u);
+            DFU_BootExecuteApp(app);
         }
     }
     
+#if (DFU_QSPI_STAGING != 0) || (DFU_QSPI_CACHE != 0) || (DFU_BOOT_XIP != 0)
+    /* Stage the downloads, cache the images and program the XIP slot in the
+     * QSPI memory, if it fails the downloads go to the internal flash */
+    (void) DFU_QspiInit();
+#endif
+#if DFU_QSPI_STAGING != 0
+    (void) DFU_QspiStagingStart();
+#endif
+#if DFU_QSPI_CACHE != 0
+    /* Cache the selected image, e.g. programmed with a debugger */
+    if (app != 0u)
+    {
+        (void) DFU_QspiCacheStore(app);
+    }
+#endif
+
+#if DFU_BOOT_EEPROM != 0
+    /* Replay the journal of the logical EEPROM, see dfu_eeprom.h */
+    DFU_EepromInit(&dfuParams);
+#endif
+
+    /* Answer the custom commands, see dfu_cmd.h */
+    DFU_CmdInit(&dfuParams, &state);
+
+#if DFU_BOOT_PROFILE != 0
+    /* Profile the DFU phases, see dfu_profile.h */
+    DFU_ProfileInit();
+#endif
+
+#if DFU_BOOT_DEEPSLEEP != 0
+    /* Keep the time and wake on the button in DeepSleep */
+    DFU_SleepInit();
+#endif
+    DFU_TimerInit();
+    DFU_TimerStart(&idleTimer, idleTimeout, 0u);
+    DFU_TimerStart(&blinkTimer, BLINK_PERIOD, BLINK_PERIOD);
+
+    /* Debounce the button without waiting, see dfu_button.h */
+    DFU_ButtonInit();
+#if DFU_BOOT_TOUCH != 0
+    /* Scan the CapSense buttons in the background, see dfu_touch.h */
+    (void) DFU_TouchStart();
+#endif
+
     /* Initialize DFU communication */
     Cy_DFU_TransportStart();
     
     for(;;)
     {
+        /* Wait for a packet at most until the next timer expires */
+    #if DFU_BOOT_DEEPSLEEP != 0
+        /* The Host and the button interrupt end the wait */
+        dfuParams.timeout = DFU_TimerNext(DFU_SLEEP_IDLE_TIMEOUT);
+    #else
+        /* The button interrupt does not end the wait, it is checked between them */
+        dfuParams.timeout = DFU_TimerNext(paramsTimeout);
+    #endif
+    #if DFU_QSPI_STAGING != 0
+        /* Install the staged image a row per turn, the host is served meanwhile */
+        if (DFU_QspiInstallTask() != 0u)
+        {
+            dfuParams.timeout = 1u;
+        }
+    #endif
+    #if DFU_BOOT_SINGLE_BUFFER != 0
+        /* Receive the packet after the row data assembled so far */
+        dfuParams.packetBuffer = &buffer[PACKET_OFFSET(dfuParams.dataOffset)];
+    #endif
+        start = DFU_PROFILE_BEGIN_PARSE();
         status = Cy_DFU_Continue(&state, &dfuParams);
-        ++count;
+        DFU_PROFILE_END(DFU_PROFILE_PARSE, start);
+        DFU_TimerPoll();
+
+    #if DFU_BOOT_TRACE != 0
+        if (state != traced)
+        {
+            DFU_TRACE(DFU_TRACE_STATE, state, status);
+            traced = state;
+        }
+    #endif
+
+        if (state == CY_DFU_STATE_NONE)
+        {
+            /* The next download checks the metadata and golden images again */
+            DFU_UserSessionStart();
+        #if (DFU_BOOT_WEAR != 0) && (DFU_BOOT_SINGLE_BUFFER == 0)
+            /* Commit the rows written by the last download, if any. The single
+            * buffer receives the next packet, so there the commit waits for
+            * the application start. */
+            (void) DFU_WearCommit(&dfuParams);
+        #endif
+        }
 
         if (state == CY_DFU_STATE_FINISHED)
         {
             /* Finished downloading the application image */
             
-            /* Validate downloaded application, if it is valid then switch to it */
-            status = Cy_DFU_ValidateApp(1u, &dfuParams);
+            /*
+            * Validate downloaded application, if it is valid then make its
+            * slot active and switch to it. A download of other data only
+            * switches to the selected slot. With DFU_BOOT_EEPROM the rows of
+            * the logical EEPROM are committed first, as one update.
+            */
+            status = CY_DFU_SUCCESS;
+        #if DFU_BOOT_EEPROM != 0
+            status = DFU_EepromCommit(&dfuParams);
+        #endif
+            if (status != CY_DFU_SUCCESS)
+            {
+                /* Restarts DFU below, the host sends the update again */
+                status = CY_DFU_ERROR_VERIFY;
+            }
+            else if (DFU_BootWrittenApp() != 0u)
+            {
+                app = DFU_BootWrittenApp();
+            #if DFU_QSPI_STAGING != 0
+                /* Finish the install started with its last row */
+                status = DFU_QspiInstall();
+                if (status == CY_DFU_SUCCESS)
+                {
+                    status = (DFU_BootSlotReadable(app) != 0u) ? Cy_DFU_ValidateApp(app, &dfuParams)
+                                                               : CY_DFU_ERROR_VERIFY;
+                }
+            #else
+                status = (DFU_BootSlotReadable(app) != 0u) ? Cy_DFU_ValidateApp(app, &dfuParams)
+                                                           : CY_DFU_ERROR_VERIFY;
+            #endif /* DFU_QSPI_STAGING != 0 */
+                if (status == CY_DFU_SUCCESS)
+                {
+                    status = DFU_BootActivate(app, &dfuParams);
+                }
+            #if DFU_QSPI_CACHE != 0
+                if (status == CY_DFU_SUCCESS)
+                {
+                    /* Keep the image for a later restore */
+                    (void) DFU_QspiCacheStore(app);
+                }
+            #endif
+            }
+            else
+            {
+                app = DFU_BootSelectApp(&dfuParams);
+                status = (app != 0u) ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
+            }
             if (status == CY_DFU_SUCCESS)
             {
                 Cy_DFU_TransportStop();
-                Cy_DFU_ExecuteApp(1u);
+            #if DFU_BOOT_TOUCH != 0
+                DFU_TouchStop();
+            #endif
+            #if DFU_BOOT_WEAR != 0
+                (void) DFU_WearCommit(&dfuParams);
+            #endif
+                DFU_BootExecuteApp(app);
             }
             else if (status == CY_DFU_ERROR_VERIFY)
             {
@@ -382,6 +565,7 @@ int main(void)
                 * or switch to the other app if it is valid.
                 * Error code may be handled here, i.e. print to debug UART.
                 */
+                DFU_TRACE(DFU_TRACE_RESTART, state, status);
                 status = Cy_DFU_Init(&state, &dfuParams);
                 Cy_DFU_TransportReset();
             }
@@ -392,32 +576,43 @@ int main(void)
             /* Handle it here */
             
             /* In this Code Example just restart DFU process */
+            DFU_TRACE(DFU_TRACE_RESTART, state, status);
             status = Cy_DFU_Init(&state, &dfuParams);
             Cy_DFU_TransportReset();
         }
         else if (state == CY_DFU_STATE_UPDATING)
         {
-            uint32_t passed5seconds = (count >= counterTimeoutSeconds(5u, paramsTimeout) ) ? 1u : 0u;
             /*
             * if no command has been received during 5 seconds when DFU
             * has started then restart DFU.
             */
             if (status == CY_DFU_SUCCESS)
             {
-                count = 0u;
+                DFU_TimerStart(&sessionTimer, sessionTimeout, 0u);
+                DFU_TimerStart(&idleTimer, idleTimeout, 0u);
             }
             else if (status == CY_DFU_ERROR_TIMEOUT)
             {
-                if (passed5seconds != 0u)
+                if (DFU_CmdAnswered() != 0u)
+                {
+                    /* A custom command, the DFU SDK sees a timeout */
+                    DFU_TimerStart(&sessionTimer, sessionTimeout, 0u);
+                    DFU_TimerStart(&idleTimer, idleTimeout, 0u);
+                }
+                else if (DFU_TimerFired(&sessionTimer) != 0u)
                 {
-                    count = 0u;
+                    DFU_TRACE(DFU_TRACE_TIMEOUT, DFU_TRACE_SESSION, 0u);
+                    DFU_TRACE(DFU_TRACE_RESTART, state, status);
+                    DFU_TimerStart(&idleTimer, idleTimeout, 0u);
                     Cy_DFU_Init(&state, &dfuParams);
                     Cy_DFU_TransportReset();
                 }
             }
             else
             {
-                count = 0u;
+                DFU_TRACE(DFU_TRACE_RESTART, state, status);
+                DFU_TimerStop(&sessionTimer);
+                DFU_TimerStart(&idleTimer, idleTimeout, 0u);
                 /* Delay because Transport still may be sending error response to a host */
                 Cy_SysLib_Delay(paramsTimeout);
                 Cy_DFU_Init(&state, &dfuParams);
@@ -426,47 +621,55 @@ int main(void)
         }
 
         /* No image has been received in 300 seconds, try to load existing image, or sleep */
-        if( (count >= counterTimeoutSeconds(300u, paramsTimeout) ) && (state == CY_DFU_STATE_NONE) )
+        if( (state == CY_DFU_STATE_NONE) && (DFU_TimerFired(&idleTimer) != 0u) )
         {
+            DFU_TRACE(DFU_TRACE_TIMEOUT, DFU_TRACE_IDLE, 0u);
+
             /* Stop DFU communication */
             Cy_DFU_TransportStop();
+        #if DFU_BOOT_TOUCH != 0
+            DFU_TouchStop();
+        #endif
             /* Check if app is valid, if it is then switch to it */
-            status = Cy_DFU_ValidateApp(1u, &dfuParams);
-            if (status == CY_DFU_SUCCESS)
+            app = DFU_BootSelectApp(&dfuParams);
+            if (app != 0u)
             {
-                Cy_DFU_ExecuteApp(1u);
+            #if DFU_BOOT_WEAR != 0
+                (void) DFU_WearCommit(&dfuParams);
+            #endif
+                DFU_BootExecuteApp(app);
             }
             /* 300 seconds has passed and App is invalid. Handle that */
+            DFU_TRACE(DFU_TRACE_HALT, state, CY_DFU_ERROR_VERIFY);
             Cy_SysLib_Halt(0x00u);
         }
         
         /* Blink once per two seconds */
-        if ( ( count % counterTimeoutSeconds(1u, paramsTimeout) ) == 0u) 
+        if (DFU_TimerFired(&blinkTimer) != 0u)
         {
             Cy_GPIO_Inv(PIN_LED);
         }
 
         /* If Button clicked - Switch to App1 if it is valid */
-        if (Cy_GPIO_Read(PIN_SW2) == 0u)
+        clicked = DFU_ButtonClicked();
+    #if DFU_BOOT_TOUCH != 0
+        clicked |= DFU_TouchClicked();
+    #endif
+        if (clicked != 0u)
         {
-            /* 50 ms delay for button debounce on button press */
-            Cy_SysLib_Delay(50u);
+            /* Validate and switch to the selected slot */
+            app = DFU_BootSelectApp(&dfuParams);
             
-            if (Cy_GPIO_Read(PIN_SW2) == 0u)
+            if (app != 0u)
             {
-                while (Cy_GPIO_Read(PIN_SW2) == 0u)
-                {   /* 50 ms delay for button debounce on button release */
-                    Cy_SysLib_Delay(50u);
-                }
-                
-                /* Validate and switch to App1 */
-                status = Cy_DFU_ValidateApp(1u, &dfuParams);
-                
-                if (status == CY_DFU_SUCCESS)
-                {
-                    Cy_DFU_TransportStop();
-                    Cy_DFU_ExecuteApp(1u);
-                }
+                Cy_DFU_TransportStop();
+            #if DFU_BOOT_TOUCH != 0
+                DFU_TouchStop();
+            #endif
+            #if DFU_BOOT_WEAR != 0
+                (void) DFU_WearCommit(&dfuParams);
+            #endif
+                DFU_BootExecuteApp(app);
             }
         }
     }
@@ -22,6 +22,12 @@
 *******************************************************************************/
 
 #include "transport_i2c.h"
+#include "dfu_boot.h"
+#include "dfu_cmd.h"
+#include "dfu_profile.h"
+#include "dfu_settings.h"
+#include "dfu_sleep.h"
+#include "dfu_trace.h"
 #include "cy_scb_i2c.h"
 #include "cy_sysint.h"
 #include <string.h>
@@ -40,6 +46,9 @@
     #define I2C_API(fn)             JOIN_LEVEL1(CY_DFU_I2C_INSTANCE, fn)
     #define CY_DFU_I2C_CONTEXT      JOIN_LEVEL1(CY_DFU_I2C_INSTANCE, _context)
 
+    /* USER CONFIGURABLE: 1u if the component wakes the device from Deep Sleep */
+    #define CY_DFU_I2C_WAKE         (0u)
+
 #else /* ModusToolbox is used for the DFU transport configuration */
 
 /* Includes driver configuration */
@@ -64,6 +73,9 @@
     /* USER CONFIGURABLE: Interrupt configuration for the I2C block. */
     #define I2C_INTR_SOURCE         DFU_I2C_IRQ
 
+    /* The address match wakes the device from Deep Sleep, as configured */
+    #define CY_DFU_I2C_WAKE         ((DFU_I2C_config.enableWakeFromSleep) ? 1u : 0u)
+
 #endif /* !defined DFU_I2C_HW */
 
 /** The instance-specific context structure.
@@ -104,20 +116,55 @@ bool I2C_initVar = false;
 
 /* Size of Read/Write buffers for I2C DFU  */
 #define I2C_BTLDR_SIZEOF_TX_BUFFER   (64u)
-#define I2C_BTLDR_SIZEOF_RX_BUFFER   (64u)
+#if DFU_BOOT_SINGLE_BUFFER != 0
+    #define I2C_BTLDR_SIZEOF_RX_BUFFER   (DFU_BOOT_PACKET_SIZE)
+#else
+    #define I2C_BTLDR_SIZEOF_RX_BUFFER   (64u)
+#endif
 
 /* Writes to this buffer */
 static uint8_t I2C_slaveTxBuf[I2C_BTLDR_SIZEOF_TX_BUFFER];
 
+#if DFU_BOOT_SINGLE_BUFFER != 0
+/* Reads into the DFU packet buffer: the one of the last read request when the
+ * host starts writing, so the host can write before the next request */
+static uint8_t *I2C_slaveRxBuf = NULL;
+
+/* The DFU packet buffer of the last read request */
+static uint8_t * volatile I2C_slaveRxNext = NULL;
+#else
 /* Reads from this buffer */
 static uint8_t I2C_slaveRxBuf[I2C_BTLDR_SIZEOF_RX_BUFFER];
+#endif /* DFU_BOOT_SINGLE_BUFFER != 0 */
 
 /* Flag to release buffer to be read */
 static uint32_t I2C_applyBuffer;
 
+/* The size of the receive buffer, none before the first read request */
+#if DFU_BOOT_SINGLE_BUFFER != 0
+    #define I2C_RX_BUFFER_SIZE      ((I2C_slaveRxBuf != NULL) ? I2C_BTLDR_SIZEOF_RX_BUFFER : 0u)
+#else
+    #define I2C_RX_BUFFER_SIZE      (I2C_BTLDR_SIZEOF_RX_BUFFER)
+#endif
+
 /* Callback to insert the response on a read request */
 static void I2C_I2CResposeInsert(uint32_t event);
 
+#if DFU_BOOT_SLEEP_WAIT != 0
+/* The Deep Sleep callback of the SCB: refuses Deep Sleep during a transfer,
+ * and enables the address match wake up */
+static cy_stc_syspm_callback_params_t I2C_sleepParams;
+static cy_stc_syspm_callback_t I2C_sleepCallback =
+{
+    .callback       = &Cy_SCB_I2C_DeepSleepCallback,
+    .type           = CY_SYSPM_DEEPSLEEP,
+    .skipMode       = 0u,
+    .callbackParams = &I2C_sleepParams,
+    .prevItm        = NULL,
+    .nextItm        = NULL,
+};
+#endif /* DFU_BOOT_SLEEP_WAIT != 0 */
+
 /* Return number of bytes to copy into DFU buffer */
 #define I2C_BYTES_TO_COPY(actBufSize, bufSize) \
                             ( ((uint32_t) (actBufSize) < (uint32_t) (bufSize)) ? \
@@ -169,6 +216,10 @@ static void I2C_Start(void)
         CY_ASSERT(CY_SCB_I2C_SUCCESS == status);
         (void) status;
 
+        /* The slave address setting replaces the configured one */
+        Cy_SCB_I2C_SlaveSetAddress(CY_DFU_I2C_HW, (uint8_t)DFU_SettingsGet(DFU_SETTING_I2C_ADDRESS,
+                                   (uint32_t)Cy_SCB_I2C_SlaveGetAddress(CY_DFU_I2C_HW)));
+
         (void) Cy_SysInt_Init(&I2C_SCB_IRQ_cfg, &I2C_Interrupt);
         NVIC_EnableIRQ((IRQn_Type) I2C_SCB_IRQ_cfg.intrSrc);
         
@@ -203,9 +254,15 @@ void I2C_I2cCyBtldrCommStart(void)
     #endif /* CY_PSOC_CREATOR_USED */
        
     Cy_SCB_I2C_SlaveConfigReadBuf(CY_DFU_I2C_HW, I2C_slaveTxBuf, 0u, &CY_DFU_I2C_CONTEXT);
-    Cy_SCB_I2C_SlaveConfigWriteBuf(CY_DFU_I2C_HW, I2C_slaveRxBuf, I2C_BTLDR_SIZEOF_RX_BUFFER, &CY_DFU_I2C_CONTEXT);
+    Cy_SCB_I2C_SlaveConfigWriteBuf(CY_DFU_I2C_HW, I2C_slaveRxBuf, I2C_RX_BUFFER_SIZE, &CY_DFU_I2C_CONTEXT);
     Cy_SCB_I2C_RegisterEventCallback(CY_DFU_I2C_HW, &I2C_I2CResposeInsert, &CY_DFU_I2C_CONTEXT);
     I2C_applyBuffer = 0u;
+
+#if DFU_BOOT_SLEEP_WAIT != 0
+    I2C_sleepParams.base    = CY_DFU_I2C_HW;
+    I2C_sleepParams.context = &CY_DFU_I2C_CONTEXT;
+    (void) Cy_SysPm_RegisterCallback(&I2C_sleepCallback);
+#endif
 }
 
 
@@ -218,6 +275,9 @@ void I2C_I2cCyBtldrCommStart(void)
 *******************************************************************************/
 void I2C_I2cCyBtldrCommStop(void)
 {
+#if DFU_BOOT_SLEEP_WAIT != 0
+    (void) Cy_SysPm_UnregisterCallback(&I2C_sleepCallback);
+#endif
     Cy_SCB_I2C_Disable(CY_DFU_I2C_HW, &CY_DFU_I2C_CONTEXT);
     Cy_SCB_I2C_DeInit(CY_DFU_I2C_HW);
 }
@@ -236,7 +296,7 @@ void I2C_I2cCyBtldrCommReset(void)
     Cy_SCB_ClearRxFifo(CY_DFU_I2C_HW);
     
     Cy_SCB_I2C_SlaveConfigReadBuf(CY_DFU_I2C_HW, I2C_slaveTxBuf, 0u, &CY_DFU_I2C_CONTEXT);
-    Cy_SCB_I2C_SlaveConfigWriteBuf(CY_DFU_I2C_HW, I2C_slaveRxBuf, I2C_BTLDR_SIZEOF_RX_BUFFER, &CY_DFU_I2C_CONTEXT);
+    Cy_SCB_I2C_SlaveConfigWriteBuf(CY_DFU_I2C_HW, I2C_slaveRxBuf, I2C_RX_BUFFER_SIZE, &CY_DFU_I2C_CONTEXT);
     
     (void)Cy_SCB_I2C_SlaveClearReadStatus(CY_DFU_I2C_HW, &CY_DFU_I2C_CONTEXT);
     (void)Cy_SCB_I2C_SlaveClearWriteStatus(CY_DFU_I2C_HW, &CY_DFU_I2C_CONTEXT);
@@ -252,6 +312,10 @@ void I2C_I2cCyBtldrCommReset(void)
 *  Allows the caller to read data from the DFU host (the host writes the
 *  data). The function handles polling to allow a block of data to be completely
 *  received from the host device.
+*  With DFU_BOOT_DEEPSLEEP in App0, sleeps until the host writes instead of
+*  polling, see dfu_sleep.h. A wake event, e.g. the button, ends the wait.
+*  With DFU_BOOT_SINGLE_BUFFER, the host writes into pData directly, or into
+*  the buffer of the previous request if it wrote before this one.
 *
 *  \param pData: Pointer to storage for the block of data to be read from the
 *   DFU host
@@ -274,7 +338,18 @@ cy_en_dfu_status_t I2C_I2cCyBtldrCommRead(uint8_t pData[], uint32_t size, uint32
 
     if ((pData != NULL) && (size > 0u))
     {
+    #if DFU_BOOT_SLEEP_WAIT != 0
+        const uint32_t start = DFU_SleepTicks();
+        uint32_t waiting = 1u;
+        uint32_t intrState;
+    #endif
+
         status = CY_DFU_ERROR_TIMEOUT;
+
+    #if DFU_BOOT_SINGLE_BUFFER != 0
+        /* The next host write goes to pData */
+        I2C_slaveRxNext = pData;
+    #endif
  
         while (0u != timeout)
         {
@@ -287,17 +362,40 @@ cy_en_dfu_status_t I2C_I2cCyBtldrCommRead(uint8_t pData[], uint32_t size, uint32
                 /* Clear slave status */
                 (void)Cy_SCB_I2C_SlaveClearWriteStatus(CY_DFU_I2C_HW, &CY_DFU_I2C_CONTEXT);
 
+            #if DFU_BOOT_SINGLE_BUFFER != 0
+                /* Received in place, or in the buffer of the previous request */
+                if (I2C_slaveRxBuf != pData)
+                {
+                    (void) memmove((void *) pData, (const void *) I2C_slaveRxBuf, *count);
+                }
+            #else
                 /* Copy command into DFU buffer */
                 (void) memcpy((void *) pData, (const void *) I2C_slaveRxBuf, *count);
+            #endif /* DFU_BOOT_SINGLE_BUFFER != 0 */
                 
                 /* Prepare the slave buffer for next reception */
-                Cy_SCB_I2C_SlaveConfigWriteBuf(CY_DFU_I2C_HW, I2C_slaveRxBuf, I2C_BTLDR_SIZEOF_RX_BUFFER, &CY_DFU_I2C_CONTEXT);
+                Cy_SCB_I2C_SlaveConfigWriteBuf(CY_DFU_I2C_HW, I2C_slaveRxBuf, I2C_RX_BUFFER_SIZE, &CY_DFU_I2C_CONTEXT);
                 status = CY_DFU_SUCCESS;
                 break;
             }
 
+        #if DFU_BOOT_SLEEP_WAIT != 0
+            /* Masks the interrupts, so the write can not complete between the check and the sleep */
+            intrState = Cy_SysLib_EnterCriticalSection();
+            if (0u == (Cy_SCB_I2C_SlaveGetStatus(CY_DFU_I2C_HW, &CY_DFU_I2C_CONTEXT) & CY_SCB_I2C_SLAVE_WR_CMPLT))
+            {
+                waiting = DFU_SleepWait(start, timeout, CY_DFU_I2C_WAKE);
+            }
+            Cy_SysLib_ExitCriticalSection(intrState);
+
+            if (0u == waiting)
+            {
+                break;
+            }
+        #else
             CyDelay(I2C_WAIT_1_MS);
             --timeout;
+        #endif /* DFU_BOOT_SLEEP_WAIT != 0 */
         }
     }
 
@@ -327,13 +425,20 @@ cy_en_dfu_status_t I2C_I2cCyBtldrCommRead(uint8_t pData[], uint32_t size, uint32
 *   Returns CYRET_SUCCESS if no problem was encountered or returns the value
 *   that best describes the problem. For more information refer to the
 *   "Return Codes" section of the System Reference Guide.
+*   CY_DFU_ERROR_LENGTH if the data does not fit the transmit buffer, nothing
+*   is sent.
 *
 *******************************************************************************/
 cy_en_dfu_status_t I2C_I2cCyBtldrCommWrite(const uint8_t pData[], uint32_t size, uint32_t *count, uint32_t timeOut)
 {
     cy_en_dfu_status_t status = CY_DFU_ERROR_UNKNOWN;
     
-    if ((NULL != pData) && (size > 0u))
+    if (size > I2C_BTLDR_SIZEOF_TX_BUFFER)
+    {
+        *count = 0u;
+        status = CY_DFU_ERROR_LENGTH;
+    }
+    else if ((NULL != pData) && (size > 0u))
     {
         /* Copy response into read buffer */
         *count = size;
@@ -383,6 +488,12 @@ static void I2C_I2CResposeInsert(uint32_t event)
          * application has a valid response packet.
          */
         Cy_SCB_I2C_SlaveConfigReadBuf(CY_DFU_I2C_HW, I2C_slaveTxBuf, 0u, &CY_DFU_I2C_CONTEXT);
+
+    #if DFU_BOOT_SINGLE_BUFFER != 0
+        /* Receive into the DFU packet buffer of the last read request */
+        I2C_slaveRxBuf = I2C_slaveRxNext;
+        Cy_SCB_I2C_SlaveConfigWriteBuf(CY_DFU_I2C_HW, I2C_slaveRxBuf, I2C_RX_BUFFER_SIZE, &CY_DFU_I2C_CONTEXT);
+    #endif
     }
     else
     {
@@ -393,6 +504,24 @@ static void I2C_I2CResposeInsert(uint32_t event)
 
 #ifndef CY_DFU_I2C_TRANSPORT_DISABLE
 
+/*******************************************************************************
+* Function Name: DFU_CmdHandle
+****************************************************************************//**
+*
+* Default handler of the custom DFU commands, for applications with none.
+* See dfu_cmd.h.
+*
+* \return 0 - the packet is for the DFU SDK.
+*
+*******************************************************************************/
+__WEAK uint32_t DFU_CmdHandle(uint8_t packet[], uint32_t size)
+{
+    (void) packet;
+    (void) size;
+    return (0u);
+}
+
+
 /*******************************************************************************
 * Function Name: Cy_DFU_TransportStart
 ****************************************************************************//**
@@ -445,7 +574,22 @@ void Cy_DFU_TransportReset(void)
 *******************************************************************************/
 cy_en_dfu_status_t Cy_DFU_TransportRead(uint8_t *buffer, uint32_t size, uint32_t *count, uint32_t timeout)
 {
-    return (I2C_I2cCyBtldrCommRead(buffer, size, count, timeout));
+    const uint32_t start = DFU_PROFILE_BEGIN();
+    cy_en_dfu_status_t status = I2C_I2cCyBtldrCommRead(buffer, size, count, timeout);
+
+    /* A custom command is answered by the application, the DFU SDK sees no packet */
+    if ( (status == CY_DFU_SUCCESS) && (DFU_CmdHandle(buffer, *count) != 0u) )
+    {
+        status = CY_DFU_ERROR_TIMEOUT;
+    }
+
+    /* Profile and trace the packets of the DFU SDK only */
+    if (status == CY_DFU_SUCCESS)
+    {
+        DFU_PROFILE_END(DFU_PROFILE_READ, start);
+        DFU_TRACE_PACKET(buffer);
+    }
+    return (status);
 }
 
 
@@ -459,7 +603,12 @@ cy_en_dfu_status_t Cy_DFU_TransportRead(uint8_t *buffer, uint32_t size, uint32_t
 *******************************************************************************/
 cy_en_dfu_status_t Cy_DFU_TransportWrite(uint8_t *buffer, uint32_t size, uint32_t *count, uint32_t timeout)
 {
-    return (I2C_I2cCyBtldrCommWrite(buffer, size, count, timeout));
+    const uint32_t start = DFU_PROFILE_BEGIN();
+    cy_en_dfu_status_t status = I2C_I2cCyBtldrCommWrite(buffer, size, count, timeout);
+
+    DFU_PROFILE_END(DFU_PROFILE_RESPONSE, start);
+    DFU_TRACE_RESPONSE(buffer);
+    return (status);
 }
 
 #endif /* CY_DFU_I2C_TRANSPORT_DISABLE */
@@ -19,13 +19,15 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "cy_dfu.h"
+#include "dfu_boot.h"
 
 /*******************************************************************************
 * Function Name: main
 ********************************************************************************
 *
 * Summary:
-*  Main function of App#1 core0. Initializes core1 (CM4) and waits forever.
+*  Main function of App#1 core0. Arms the WDT again if the application is on
+*  trial, initializes core1 (CM4) and waits forever.
 *
 * Parameters:
 *  None
@@ -38,6 +40,13 @@ int main(void)
 {
     cy_rslt_t result;
 
+#if DFU_BOOT_TIMING != 0
+    DFU_BootTimingFinish();
+#endif
+
+    /* The startup code has disabled the WDT, arm it again if on trial */
+    DFU_BootTrialResume();
+
     /* Initialize the device and board peripherals */
     result = cybsp_init() ;
     if (result != CY_RSLT_SUCCESS)
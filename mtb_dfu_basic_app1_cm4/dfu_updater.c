@@ -0,0 +1,324 @@
+/***************************************************************************//**
+* \file dfu_updater.c
+* \version 1.0
+*
+* This file provides the App1 background updater, see dfu_updater.h, and the
+* custom API of the DFU SDK it uses:
+* - Cy_DFU_ReadData (address, length, ctl, params) - to read  the NVM block
+* - Cy_DFU_WriteData(address, length, ctl, params) - to write the NVM block,
+*   only the other application slot in the internal flash and the metadata row
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_syslib.h"
+#include "cy_flash.h"
+#include "cy_dfu.h"
+#include "dfu_boot.h"
+#include "dfu_updater.h"
+#include "dfu_timer.h"
+#include "dfu_wear.h"
+
+static cy_stc_dfu_params_t *dfu_updaterParams;
+static uint32_t dfu_updaterState;
+static uint32_t dfu_updaterRunning;
+static uint32_t dfu_updaterHold;
+static uint32_t dfu_updaterApp;
+
+/* Ends the hold of the commands after a row write */
+static dfu_timer_t dfu_updaterHoldTimer;
+
+/* Expires DFU_UPDATER_COMMAND_TIMEOUT after the last command */
+static dfu_timer_t dfu_updaterIdleTimer;
+
+static void Restart(void);
+
+
+/*******************************************************************************
+* Function Name: Restart
+****************************************************************************//**
+*
+* This internal function restarts the download, e.g. after an error, and
+* commits the flash wear counters with DFU_BOOT_WEAR.
+*
+*******************************************************************************/
+static void Restart(void)
+{
+    DFU_TimerStart(&dfu_updaterIdleTimer, DFU_UPDATER_COMMAND_TIMEOUT, 0u);
+    (void) Cy_DFU_Init(&dfu_updaterState, dfu_updaterParams);
+    Cy_DFU_TransportReset();
+#if DFU_BOOT_WEAR != 0
+    /* Commit the rows of the download abandoned */
+    (void) DFU_WearCommit(dfu_updaterParams);
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_UpdaterStart
+****************************************************************************//**
+*
+* Starts the DFU transport and the DFU SDK. Does nothing once a slot is
+* pending.
+*
+* \param params     The pointer to a DFU parameters structure, with the
+*                   command and data buffers. Used by the updater until it is
+*                   stopped, it sets the timeout before each command.
+*
+*******************************************************************************/
+void DFU_UpdaterStart(cy_stc_dfu_params_t *params)
+{
+    if ( (dfu_updaterRunning == 0u) && (dfu_updaterApp == 0u) )
+    {
+        params->timeout   = DFU_UPDATER_TIMEOUT;
+        dfu_updaterParams = params;
+        dfu_updaterHold   = 0u;
+        DFU_TimerStop(&dfu_updaterHoldTimer);
+        DFU_TimerStart(&dfu_updaterIdleTimer, DFU_UPDATER_COMMAND_TIMEOUT, 0u);
+
+        (void) Cy_DFU_Init(&dfu_updaterState, params);
+        Cy_DFU_TransportStart();
+        dfu_updaterRunning = 1u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_UpdaterStop
+****************************************************************************//**
+*
+* Stops the DFU transport, e.g. before a switch to another application.
+* A download in progress is abandoned.
+*
+*******************************************************************************/
+void DFU_UpdaterStop(void)
+{
+    if (dfu_updaterRunning != 0u)
+    {
+        Cy_DFU_TransportStop();
+        DFU_TimerStop(&dfu_updaterHoldTimer);
+        DFU_TimerStop(&dfu_updaterIdleTimer);
+        dfu_updaterRunning = 0u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_UpdaterTask
+****************************************************************************//**
+*
+* Serves one DFU command, called from the application main loop before
+* DFU_TimerPoll(). Waits for a command until the next timer of dfu_timer.h
+* expires, DFU_UPDATER_TIMEOUT at most, and returns at once when the
+* commands are not served.
+*
+* When the download is finished, validates the slot written and makes it
+* active, then stops the transport. A download that is not valid restarts.
+*
+*******************************************************************************/
+void DFU_UpdaterTask(void)
+{
+    if (DFU_TimerFired(&dfu_updaterHoldTimer) != 0u)
+    {
+        dfu_updaterHold = 0u;
+    }
+
+    if ( (dfu_updaterRunning == 0u) || (dfu_updaterHold != 0u) )
+    {
+        /* The application gets the CPU */
+    }
+    else
+    {
+        cy_en_dfu_status_t status;
+
+        /* Do not delay the timers of the application */
+        dfu_updaterParams->timeout = DFU_TimerNext(DFU_UPDATER_TIMEOUT);
+        status = Cy_DFU_Continue(&dfu_updaterState, dfu_updaterParams);
+
+        if (dfu_updaterState == CY_DFU_STATE_FINISHED)
+        {
+            uint32_t app = DFU_BootWrittenApp();
+
+            status = (app != 0u) ? Cy_DFU_ValidateApp(app, dfu_updaterParams) : CY_DFU_ERROR_VERIFY;
+            if (status == CY_DFU_SUCCESS)
+            {
+                status = DFU_BootActivate(app, dfu_updaterParams);
+            }
+            if (status == CY_DFU_SUCCESS)
+            {
+                /* Pending until the next reset */
+                dfu_updaterApp = app;
+                DFU_UpdaterStop();
+            #if DFU_BOOT_WEAR != 0
+                (void) DFU_WearCommit(dfu_updaterParams);
+            #endif
+            }
+            else
+            {
+                Restart();
+            }
+        }
+        else if (dfu_updaterState == CY_DFU_STATE_FAILED)
+        {
+            Restart();
+        }
+        else if (dfu_updaterState == CY_DFU_STATE_UPDATING)
+        {
+            if (status == CY_DFU_SUCCESS)
+            {
+                DFU_TimerStart(&dfu_updaterIdleTimer, DFU_UPDATER_COMMAND_TIMEOUT, 0u);
+            }
+            else if (status == CY_DFU_ERROR_TIMEOUT)
+            {
+                /* No command for DFU_UPDATER_COMMAND_TIMEOUT, restart */
+                if (DFU_TimerFired(&dfu_updaterIdleTimer) != 0u)
+                {
+                    Restart();
+                }
+            }
+            else
+            {
+                /* Delay because Transport still may be sending error response to a host */
+                Cy_SysLib_Delay(DFU_UPDATER_TIMEOUT);
+                Restart();
+            }
+        }
+        else
+        {
+            /* Waiting for a download */
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_UpdaterPendingApp
+****************************************************************************//**
+*
+* Returns the slot downloaded and made active, it starts at the next reset.
+*
+* \return The slot, or 0 if no download is pending.
+*
+*******************************************************************************/
+uint32_t DFU_UpdaterPendingApp(void)
+{
+    return (dfu_updaterApp);
+}
+
+
+/*******************************************************************************
+* Function Name: Cy_DFU_WriteData
+****************************************************************************//**
+*
+* This function documentation is part of the DFU SDK API, see the
+* cy_dfu.h file or DFU SDK API Reference Manual for details.
+*
+* Only the rows of the internal flash slot App1 does not run from and the
+* metadata row may be written, the XIP slot is programmed by App0. The
+* commands are not served for DFU_UPDATER_WRITE_INTERVAL after a row write.
+*
+*******************************************************************************/
+cy_en_dfu_status_t Cy_DFU_WriteData (uint32_t address, uint32_t length, uint32_t ctl,
+                                               cy_stc_dfu_params_t *params)
+{
+    const uint32_t metadataAddress = (uint32_t)&__cy_boot_metadata_addr;
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    uint32_t app = DFU_BootAppOf(address);
+
+    /* Check if the address and length are valid
+     * Note Length = 0 is valid for erase command */
+    if ( ((address % CY_FLASH_SIZEOF_ROW) != 0u) ||
+         ( (length != CY_FLASH_SIZEOF_ROW) && ( (ctl & CY_DFU_IOCTL_ERASE) == 0u) ) )
+    {
+        status = CY_DFU_ERROR_LENGTH;
+    }
+
+    /* Refuse the running slot, the XIP slot and anything else than the slots and the metadata */
+    if ( ((app == 0u) || (app == Cy_DFU_GetRunningApp()) || (app == DFU_BOOT_XIP_APP))
+      && (address != metadataAddress) )
+    {
+        status = CY_DFU_ERROR_ADDRESS;
+    }
+
+    /* Refuse the boot control rows, record the slot written */
+    if (status == CY_DFU_SUCCESS)
+    {
+        status = DFU_BootCheckWrite(address);
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        uint32_t wearStart;
+        cy_en_flashdrv_status_t fstatus;
+
+        if ((ctl & CY_DFU_IOCTL_ERASE) != 0u)
+        {
+            (void) memset(params->dataBuffer, 0, CY_FLASH_SIZEOF_ROW);
+        }
+        wearStart = DFU_WEAR_BEGIN();
+        fstatus = Cy_Flash_WriteRow(address, (uint32_t*)params->dataBuffer);
+        status = (fstatus == CY_FLASH_DRV_SUCCESS) ? CY_DFU_SUCCESS : CY_DFU_ERROR_DATA;
+        DFU_WEAR_ROW(address, ctl & CY_DFU_IOCTL_ERASE, (status != CY_DFU_SUCCESS) ? 1u : 0u, wearStart);
+
+        /* Give the CPU back to the application before the next write */
+        dfu_updaterHold = 1u;
+        DFU_TimerStart(&dfu_updaterHoldTimer, DFU_UPDATER_WRITE_INTERVAL, 0u);
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: Cy_DFU_ReadData
+****************************************************************************//**
+*
+* This function documentation is part of the DFU SDK API, see the
+* cy_dfu.h file or DFU SDK API Reference Manual for details.
+*
+*******************************************************************************/
+cy_en_dfu_status_t Cy_DFU_ReadData (uint32_t address, uint32_t length, uint32_t ctl,
+                                              cy_stc_dfu_params_t *params)
+{
+    /* application flash limits */
+    /* Note that App0 is out of range */
+    const uint32_t minUFlashAddress = CY_FLASH_BASE + CY_DFU_APP0_VERIFY_LENGTH;
+    const uint32_t maxUFlashAddress = CY_FLASH_BASE + CY_FLASH_SIZE;
+
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+
+    /* Check if the length is valid */
+    if ((length % CY_FLASH_SIZEOF_ROW) != 0u)
+    {
+        status = CY_DFU_ERROR_LENGTH;
+    }
+
+    /* Check if the address is inside the valid range */
+    if ( (address < minUFlashAddress) || (address >= maxUFlashAddress) )
+    {
+        status = CY_DFU_ERROR_ADDRESS;
+    }
+
+    /* Read or Compare */
+    if (status == CY_DFU_SUCCESS)
+    {
+        if ((ctl & CY_DFU_IOCTL_COMPARE) == 0u)
+        {
+            (void) memcpy(params->dataBuffer, (const void *)address, length);
+        }
+        else
+        {
+            status = ( memcmp(params->dataBuffer, (const void *)address, length) == 0 )
+                     ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
+        }
+    }
+    return (status);
+}
+
+
+/* [] END OF FILE */
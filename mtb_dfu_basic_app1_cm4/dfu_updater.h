@@ -0,0 +1,68 @@
+/***************************************************************************//**
+* \file dfu_updater.h
+* \version 1.0
+*
+* This file provides the API of the App1 background updater.
+*
+* The updater serves the DFU transport from the App1 main loop while the
+* application keeps running. The host downloads the image of the other slot,
+* e.g. mtb_dfu_basic_app2.cyacd2 when App1 runs from slot 1: the running slot
+* and the boot control rows are refused. When the download is finished and
+* valid, the updater makes the new slot active in the boot control record and
+* stops the transport. The new slot is then pending: it starts on trial at
+* the next reset, App0 has nothing else to install.
+*
+* Each call to DFU_UpdaterTask() serves one DFU command at most. Row writes
+* stall the CPU, so after a write the commands are not served for
+* DFU_UPDATER_WRITE_INTERVAL: the host waits for the response meanwhile, and
+* the application gets the CPU.
+*
+* The write interval and the command timeout are timers of dfu_timer.h, so
+* they keep their length whatever the main loop rate: the application calls
+* DFU_TimerInit() before DFU_UpdaterStart(), and DFU_TimerPoll() after each
+* DFU_UpdaterTask().
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_UPDATER_H)
+#define DFU_UPDATER_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The longest DFU_UpdaterTask() waits for a command, in milliseconds */
+#define DFU_UPDATER_TIMEOUT         (10u)
+
+/** The shortest time between two row writes, in milliseconds */
+#define DFU_UPDATER_WRITE_INTERVAL  (50u)
+
+/** The download restarts if no command is received in this time, in milliseconds */
+#define DFU_UPDATER_COMMAND_TIMEOUT (5000u)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_UpdaterStart(cy_stc_dfu_params_t *params);
+void DFU_UpdaterStop(void);
+void DFU_UpdaterTask(void);
+uint32_t DFU_UpdaterPendingApp(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_UPDATER_H) */
+
+
+/* [] END OF FILE */
@@ -61,7 +61,7 @@ extern "C" {
 * 
 * The smallest metadata size if CY_DFU_MAX_APPS * 8 (bytes per one app) + 4 (bytes for CRC-32C)
 */
-#define CY_DFU_MAX_APPS            (2u)
+#define CY_DFU_MAX_APPS            (4u)
 
 
 /** A non-zero value enables the Verify Data DFU command  */
@@ -104,6 +104,13 @@ extern "C" {
 /** A non-zero value enables the usage of CRC-16 for DFU packet verification */
 #define CY_DFU_OPT_PACKET_CRC      (0)
 
+/**
+* A non-zero value enables the decryption of the Program Data payloads.
+* The payloads are AES-128 CTR encrypted by the host, see dfu_decrypt.h.
+* Requires \c CY_DFU_OPT_SET_EIVECTOR to receive the initial counter block.
+*/
+#define CY_DFU_OPT_ENCRYPTED_DATA  (0)
+
 /** \} group_dfu_macro_config */
 
 #if !defined(CY_DOXYGEN)
@@ -115,6 +122,10 @@ extern "C" {
         #define CY_DFU_APP0_VERIFY_LENGTH      ( CY_APP0_FLASH_LENGTH - CY_DFU_SIGNATURE_SIZE)
         #define CY_DFU_APP1_VERIFY_START       ( CY_APP1_FLASH_ADDR )
         #define CY_DFU_APP1_VERIFY_LENGTH      ( CY_APP1_FLASH_LENGTH - CY_DFU_SIGNATURE_SIZE)
+        #define CY_DFU_APP2_VERIFY_START       ( CY_APP2_FLASH_ADDR )
+        #define CY_DFU_APP2_VERIFY_LENGTH      ( CY_APP2_FLASH_LENGTH - CY_DFU_SIGNATURE_SIZE)
+        #define CY_DFU_APP3_VERIFY_START       ( CY_APP3_FLASH_ADDR )
+        #define CY_DFU_APP3_VERIFY_LENGTH      ( CY_APP3_FLASH_LENGTH - CY_DFU_SIGNATURE_SIZE)
 
     #elif defined(__GNUC__) || defined(__ICCARM__)
         /*
@@ -125,12 +136,20 @@ extern "C" {
         extern uint8_t __cy_app0_verify_length;
         extern uint8_t __cy_app1_verify_start;
         extern uint8_t __cy_app1_verify_length;
+        extern uint8_t __cy_app2_verify_start;
+        extern uint8_t __cy_app2_verify_length;
+        extern uint8_t __cy_app3_verify_start;
+        extern uint8_t __cy_app3_verify_length;
         extern uint8_t __cy_boot_signature_size;
 
         #define CY_DFU_APP0_VERIFY_START       ( (uint32_t)&__cy_app0_verify_start )
         #define CY_DFU_APP0_VERIFY_LENGTH      ( (uint32_t)&__cy_app0_verify_length )
         #define CY_DFU_APP1_VERIFY_START       ( (uint32_t)&__cy_app1_verify_start )
         #define CY_DFU_APP1_VERIFY_LENGTH      ( (uint32_t)&__cy_app1_verify_length )
+        #define CY_DFU_APP2_VERIFY_START       ( (uint32_t)&__cy_app2_verify_start )
+        #define CY_DFU_APP2_VERIFY_LENGTH      ( (uint32_t)&__cy_app2_verify_length )
+        #define CY_DFU_APP3_VERIFY_START       ( (uint32_t)&__cy_app3_verify_start )
+        #define CY_DFU_APP3_VERIFY_LENGTH      ( (uint32_t)&__cy_app3_verify_length )
         #define CY_DFU_SIGNATURE_SIZE          ( (uint32_t)&__cy_boot_signature_size )
     #else
         #error "Not implemented for this compiler"
@@ -4,8 +4,11 @@
 *
 * This file provides App1 Core1 example source.
 * App1 Core1 firmware does the following:
+* - Confirms the application if it is started on trial
+* - Downloads the image of the other slot in the background, see dfu_updater.h
 * - Blinks a LED
-* - Swithes to App0 if button is pressed
+* - Swithes to the downloaded slot if button is clicked, else to App0, also
+*   on a touch of a CapSense button with DFU_BOOT_TOUCH
 *
 ********************************************************************************
 * \copyright
@@ -19,14 +22,14 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "cy_dfu.h"
-
-/*
-* For usage with Cy_GPIO_Read(PIN_SW2) and Cy_GPIO_Write(PIN_SW2, value)
-* instead of Cy_GPII_Read(GPIO_PTR0, 4u) and Cy_GPIO_Write(GPIO_PTR0, 4u, value)
-*
-* Pin for user button SW2.
-*/
-#define PIN_SW2     GPIO_PRT0, 4u
+#include "dfu_boot.h"
+#include "dfu_updater.h"
+#include "dfu_timer.h"
+#include "dfu_button.h"
+#include "dfu_settings.h"
+#include "dfu_trace.h"
+#include "dfu_wear.h"
+#include "dfu_touch.h"
 
 /*
 * For usage with Cy_GPIO_Inv(PIN_LED) instead of Cy_GPIO_Inv(GPIO_PRT0, 3u).
@@ -34,6 +37,8 @@
 */
 #define PIN_LED     GPIO_PRT13, 7u
 
+#define BLINK_PERIOD        (250u)      /* LED toggle period */
+
 
 /* This section is used to verify an application signature.
    For checksum verification, set the number of elements in the array to 1, and
@@ -49,8 +54,12 @@ CY_SECTION(".cy_app_signature") __USED static const uint32_t cy_appSignature[1];
 *
 * Summary:
 *  Main function of Application#1 core1 (CM4).
-*  Blinks a LED, when button is pressed and released it switches to app#0 for
-*  new app#1 to be downloaded.  
+*  Confirms the application if App0 started it on trial.
+*  Serves the background updater and blinks a LED. When button is pressed and
+*  released it switches to the downloaded slot if there is one, else to app#0
+*  for new app#1 to be downloaded.
+*  The LED blink and the button debounce are timed by the timers of
+*  dfu_timer.h, so the loop never waits for the button.
 *
 * Parameters:
 *  None
@@ -61,30 +70,94 @@ CY_SECTION(".cy_app_signature") __USED static const uint32_t cy_appSignature[1];
 *******************************************************************************/
 int main(void)
 {
+    /* DFU params, used by the updater and to confirm the application */
+    cy_stc_dfu_params_t dfuParams;
+
+    /* Buffer to store DFU commands, also used to write the boot control record */
+    CY_ALIGN(4) static uint8_t buffer[CY_DFU_SIZEOF_DATA_BUFFER];
+
+    /* Buffer for DFU packets for Transport API */
+    CY_ALIGN(4) static uint8_t packet[CY_DFU_SIZEOF_CMD_BUFFER];
+
+    /* Toggles the LED */
+    static dfu_timer_t blinkTimer;
+
+    /* The button was clicked, or a CapSense button touched */
+    uint32_t clicked;
+
+    /* The downloaded slot */
+    uint32_t app;
+
     /* Enable global interrupts */
     __enable_irq();
 
+#if DFU_BOOT_TRACE != 0
+    /* Record the start after the events of App0, see dfu_trace.h */
+    DFU_TraceInit(Cy_DFU_GetRunningApp());
+#endif
+
+    dfuParams.timeout      = DFU_UPDATER_TIMEOUT;
+    dfuParams.dataBuffer   = &buffer[0];
+    dfuParams.packetBuffer = &packet[0];
+
+#if DFU_BOOT_WEAR != 0
+    /* Count the row writes of App1, see dfu_wear.h */
+    DFU_WearInit(&dfuParams);
+#endif
+
+    /*
+    * The application runs: confirm it, else the WDT resets the device and
+    * App0 switches back to the previous application. A real application
+    * would confirm once its self-test has passed.
+    */
+    (void) DFU_BootConfirm(&dfuParams);
+
+    /* The transport takes the I2C address of the settings, see dfu_settings.h */
+    DFU_SettingsInit(&dfuParams);
+
+    /* Time the blink, the button and the updater, see dfu_timer.h */
+    DFU_TimerInit();
+    DFU_TimerStart(&blinkTimer, BLINK_PERIOD, BLINK_PERIOD);
+
+    /* Debounce the button without waiting, see dfu_button.h */
+    DFU_ButtonInit();
+
+    /* Accept a new image of the other slot while running */
+    DFU_UpdaterStart(&dfuParams);
+
+#if DFU_BOOT_TOUCH != 0
+    /* Scan the CapSense buttons in the background, see dfu_touch.h */
+    (void) DFU_TouchStart();
+#endif
+
     for(;;)
     {
+        DFU_UpdaterTask();
+        DFU_TimerPoll();
+
         /* Blink twice per second */
-        Cy_GPIO_Inv(PIN_LED);
-        Cy_SysLib_Delay(250u);
-        
-        /* If Button clicked and switch to App0 */
-        if (Cy_GPIO_Read(PIN_SW2) == 0u)
+        if (DFU_TimerFired(&blinkTimer) != 0u)
+        {
+            Cy_GPIO_Inv(PIN_LED);
+        }
+
+        /* If Button clicked and switch to the downloaded slot or App0 */
+        clicked = DFU_ButtonClicked();
+
+    #if DFU_BOOT_TOUCH != 0
+        /* A click of a CapSense button switches the same way */
+        if (DFU_TouchClicked() != 0u)
+        {
+            clicked = 1u;
+        }
+    #endif
+
+        if (clicked != 0u)
         {
-            /* 50 ms delay for button debounce on button press */
-            Cy_SysLib_Delay(50u);
-            
-            if (Cy_GPIO_Read(PIN_SW2) == 0u)
-            {
-                while (Cy_GPIO_Read(PIN_SW2) == 0u)
-                {   /* 50 ms delay for button debounce on button release */
-                    Cy_SysLib_Delay(50u);
-                }
-                
-                Cy_DFU_ExecuteApp(0u);
-            }
+            /* The downloaded slot is active already, it starts on trial */
+            app = DFU_UpdaterPendingApp();
+            DFU_UpdaterStop();
+            Cy_DFU_ExecuteApp(app);
         }
     }
 }
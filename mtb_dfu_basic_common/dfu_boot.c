@@ -0,0 +1,720 @@
+/***************************************************************************//**
+* \file dfu_boot.c
+* \version 1.0
+*
+* This file provides the application slots, the trial boot, the direct
+* handoff between the applications and the boot timing record, see
+* dfu_boot.h.
+*
+* The trial uses the WDT: it is clocked by the ILO and resets the device on
+* the third match event that is not cleared. Nothing clears it during a
+* trial, the interrupt is not enabled.
+*
+* The CM0+ SysTick is clocked by the IMO, which does not depend on the clock
+* configuration, and runs with no interrupt. The 24-bit counter wraps every
+* two seconds, so DFU_BootTimingUpdate() must be called more often than that
+* while the boot is in progress.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_pdl.h"
+#include "cy_dfu.h"
+#include "dfu_boot.h"
+#include "flash_log.h"
+#include "dfu_trace.h"
+
+/* The boot control region, defined in the linker scripts */
+extern uint8_t __cy_boot_ctl_addr;
+extern uint8_t __cy_boot_ctl_length;
+
+/* The settings region, dfu_settings.c, not writable by a download either */
+extern uint8_t __cy_boot_settings_addr;
+extern uint8_t __cy_boot_settings_length;
+
+/* The wear counters, dfu_wear.c, and the log of the metadata copies */
+extern uint8_t __cy_boot_wear_addr;
+extern uint8_t __cy_boot_wear_length;
+extern uint8_t __cy_boot_md_log_addr;
+extern uint8_t __cy_boot_md_log_length;
+
+/* The slot App0 starts, kept from being overwritten. 0 if none is valid. */
+static uint32_t dfu_bootApp = 0u;
+
+/* The slot written by the current download, 0 if none */
+static uint32_t dfu_bootWrittenApp = 0u;
+
+/* 1 if the slot App0 starts is on trial */
+static uint32_t dfu_bootTrial = 0u;
+
+
+static void GetBootCtlLog(flash_log_t *log);
+static void DisableInterrupts(void);
+#if DFU_BOOT_TRIAL != 0
+static void ArmWatchdog(void);
+static void DisarmWatchdog(void);
+#endif /* DFU_BOOT_TRIAL != 0 */
+
+
+/*******************************************************************************
+* Function Name: GetBootCtlLog
+****************************************************************************//**
+*
+* This internal function returns the flash log of the boot control record.
+*
+*******************************************************************************/
+static void GetBootCtlLog(flash_log_t *log)
+{
+    log->address = (uint32_t)&__cy_boot_ctl_addr;
+    log->rows    = (uint32_t)&__cy_boot_ctl_length / CY_FLASH_SIZEOF_ROW;
+}
+
+
+/*******************************************************************************
+* Function Name: DisableInterrupts
+****************************************************************************//**
+*
+* Masks the interrupts of this core, disables all the NVIC lines, clears the
+* pending ones and stops the SysTick interrupt.
+*
+*******************************************************************************/
+static void DisableInterrupts(void)
+{
+    uint32_t idx;
+
+    __disable_irq();
+    for (idx = 0u; idx < (sizeof(NVIC->ICER) / sizeof(NVIC->ICER[0])); ++idx)
+    {
+        NVIC->ICER[idx] = 0xFFFFFFFFu;
+        NVIC->ICPR[idx] = 0xFFFFFFFFu;
+    }
+    SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+}
+
+
+#if DFU_BOOT_TRIAL != 0
+/*******************************************************************************
+* Function Name: ArmWatchdog
+****************************************************************************//**
+*
+* This internal function starts the WDT from zero, to reset the device unless
+* the slot on trial is confirmed in time.
+*
+*******************************************************************************/
+static void ArmWatchdog(void)
+{
+    Cy_WDT_Unlock();
+    Cy_WDT_Disable();
+    Cy_WDT_SetIgnoreBits(DFU_BOOT_TRIAL_WDT_IGNORE);
+    Cy_WDT_ClearWatchdog();
+    Cy_WDT_Enable();
+    Cy_WDT_Lock();
+}
+
+
+/*******************************************************************************
+* Function Name: DisarmWatchdog
+****************************************************************************//**
+*
+* This internal function stops the WDT started by ArmWatchdog().
+*
+*******************************************************************************/
+static void DisarmWatchdog(void)
+{
+    Cy_WDT_Unlock();
+    Cy_WDT_Disable();
+    Cy_WDT_ClearInterrupt();
+    Cy_WDT_Lock();
+}
+#endif /* DFU_BOOT_TRIAL != 0 */
+
+
+/*******************************************************************************
+* Function Name: DFU_BootAppOf
+****************************************************************************//**
+*
+* Returns the application slot an address belongs to.
+*
+* \param address    The address.
+*
+* \return The slot, DFU_BOOT_FIRST_APP to DFU_BOOT_LAST_APP, or 0 if the
+*         address is not in a slot.
+*
+*******************************************************************************/
+uint32_t DFU_BootAppOf(uint32_t address)
+{
+    const uint32_t slotStart[] = { CY_DFU_APP1_VERIFY_START, CY_DFU_APP2_VERIFY_START, CY_DFU_APP3_VERIFY_START };
+    const uint32_t slotLength[] = { CY_DFU_APP1_VERIFY_LENGTH, CY_DFU_APP2_VERIFY_LENGTH, CY_DFU_APP3_VERIFY_LENGTH };
+    uint32_t app = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < (sizeof(slotStart) / sizeof(slotStart[0])); ++idx)
+    {
+        /* The slot includes the signature */
+        if ( (slotStart[idx] <= address) && (address < (slotStart[idx] + slotLength[idx] + CY_DFU_SIGNATURE_SIZE)) )
+        {
+            app = idx + DFU_BOOT_FIRST_APP;
+            break;
+        }
+    }
+    return (app);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootSlotReadable
+****************************************************************************//**
+*
+* Tells if this core can read an application slot. The XIP slot can only be
+* read once the SMIF is in the memory mode: App0 CM4 overrides this function
+* in dfu_qspi.c to set it.
+*
+* \param appId      The slot.
+*
+* \return 1 - the slot may be read, e.g. validated, else 0.
+*
+*******************************************************************************/
+__WEAK uint32_t DFU_BootSlotReadable(uint32_t appId)
+{
+    return ( (appId != DFU_BOOT_XIP_APP) ? 1u : 0u );
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootCtlRead
+****************************************************************************//**
+*
+* Reads the boot control record. A device with no record, e.g. programmed
+* before the slots were added, starts the first slot.
+*
+* \param ctl        The pointer to the record to fill.
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return
+* - CY_DFU_SUCCESS when the record is read.
+* - CY_DFU_ERROR_VERIFY if there is no valid record, ctl holds the defaults.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_BootCtlRead(dfu_boot_ctl_t *ctl, cy_stc_dfu_params_t *params)
+{
+    flash_log_t log;
+    cy_en_dfu_status_t status;
+
+    GetBootCtlLog(&log);
+    status = FlashLog_Read(&log, ctl, sizeof(*ctl), NULL, params);
+    if (status != CY_DFU_SUCCESS)
+    {
+        (void) memset(ctl, 0, sizeof(*ctl));
+        ctl->activeApp = DFU_BOOT_FIRST_APP;
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootSelectApp
+****************************************************************************//**
+*
+* Selects the application to start: the active slot if it is valid, else the
+* previous one if it is valid. The selected slot is kept from being
+* overwritten by the downloads, see DFU_BootCheckWrite().
+*
+* If the active slot is on trial and the WDT has reset the device, the slot
+* has failed: the previous slot is made active again, the failed one is not
+* kept as a fallback. This writes the record, so with no params->dataBuffer
+* 0 is returned and the rollback is left to a caller with a buffer.
+* 0 is also returned if this core can not read the active slot, see
+* DFU_BootSlotReadable().
+*
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return The slot to start, or 0 if no slot is valid.
+*
+*******************************************************************************/
+uint32_t DFU_BootSelectApp(cy_stc_dfu_params_t *params)
+{
+    dfu_boot_ctl_t ctl;
+    uint32_t app = 0u;
+
+    (void) DFU_BootCtlRead(&ctl, params);
+
+#if DFU_BOOT_TRIAL != 0
+    if ( (ctl.state == DFU_BOOT_STATE_TRIAL)
+      && ((Cy_SysLib_GetResetReason() & CY_SYSLIB_RESET_HWWDT) != 0u) )
+    {
+        if (params->dataBuffer != NULL)
+        {
+            flash_log_t log;
+
+            /* Roll back, even if the record can not be written this time */
+            ctl.activeApp   = ctl.previousApp;
+            ctl.previousApp = 0u;
+            ctl.state       = DFU_BOOT_STATE_CONFIRMED;
+
+            GetBootCtlLog(&log);
+            (void) FlashLog_Append(&log, &ctl, sizeof(ctl), params);
+        }
+        else
+        {
+            ctl.activeApp   = 0u;
+            ctl.previousApp = 0u;
+        }
+    }
+#endif /* DFU_BOOT_TRIAL != 0 */
+
+    if (DFU_BootSlotReadable(ctl.activeApp) == 0u)
+    {
+        /* Left to a core that can read the slot, e.g. App0 CM4 for the XIP slot */
+    }
+    else if ( (ctl.activeApp >= DFU_BOOT_FIRST_APP) && (ctl.activeApp <= DFU_BOOT_LAST_APP)
+           && (Cy_DFU_ValidateApp(ctl.activeApp, params) == CY_DFU_SUCCESS) )
+    {
+        app = ctl.activeApp;
+    }
+    else if ( (ctl.previousApp >= DFU_BOOT_FIRST_APP) && (ctl.previousApp <= DFU_BOOT_LAST_APP)
+           && (Cy_DFU_ValidateApp(ctl.previousApp, params) == CY_DFU_SUCCESS) )
+    {
+        /* Roll back */
+        app = ctl.previousApp;
+    }
+    else
+    {
+        /* No valid application */
+    }
+
+    dfu_bootApp = app;
+    dfu_bootTrial = ( (app == ctl.activeApp) && (ctl.state == DFU_BOOT_STATE_TRIAL) ) ? 1u : 0u;
+    return (app);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootActivate
+****************************************************************************//**
+*
+* Makes a slot active, the slot active so far becomes the previous one.
+* The record is updated with a single row write, a reset during the write
+* leaves the former record in place. With DFU_BOOT_TRIAL the slot is on
+* trial until it is confirmed.
+*
+* \param appId      The slot to make active, must be valid.
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer is used to write the record.
+*
+* \return
+* - CY_DFU_SUCCESS when the slot is active.
+* - Any other status code on error.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_BootActivate(uint32_t appId, cy_stc_dfu_params_t *params)
+{
+    const uint32_t state = (DFU_BOOT_TRIAL != 0) ? DFU_BOOT_STATE_TRIAL : DFU_BOOT_STATE_CONFIRMED;
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    dfu_boot_ctl_t ctl;
+
+    (void) DFU_BootCtlRead(&ctl, params);
+
+    if ( (ctl.activeApp != appId) || (ctl.state != state) )
+    {
+        flash_log_t log;
+
+        if (ctl.activeApp != appId)
+        {
+            ctl.previousApp = ctl.activeApp;
+            ctl.activeApp   = (uint8_t)appId;
+        }
+        ctl.state = (uint8_t)state;
+
+        GetBootCtlLog(&log);
+        status = FlashLog_Append(&log, &ctl, sizeof(ctl), params);
+    }
+    if (status == CY_DFU_SUCCESS)
+    {
+        dfu_bootApp = appId;
+        dfu_bootTrial = (state == DFU_BOOT_STATE_TRIAL) ? 1u : 0u;
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootCheckWrite
+****************************************************************************//**
+*
+* Checks a row write of a download. Refuses the boot control rows, the
+* settings rows, the wear counter rows, the metadata log rows and the slot
+* selected by DFU_BootSelectApp(), and records the slot written. The host
+* may write from __cy_dfu_flash_start to the end of the flash, which holds
+* these rows.
+*
+* \param address    The row address.
+*
+* \return
+* - CY_DFU_SUCCESS when the row may be written.
+* - CY_DFU_ERROR_ADDRESS if it may not.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_BootCheckWrite(uint32_t address)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    uint32_t app = DFU_BootAppOf(address);
+
+    if ( ((address - (uint32_t)&__cy_boot_ctl_addr) < (uint32_t)&__cy_boot_ctl_length)
+      || ((address - (uint32_t)&__cy_boot_settings_addr) < (uint32_t)&__cy_boot_settings_length)
+      || ((address - (uint32_t)&__cy_boot_wear_addr) < (uint32_t)&__cy_boot_wear_length)
+      || ((address - (uint32_t)&__cy_boot_md_log_addr) < (uint32_t)&__cy_boot_md_log_length)
+      || ((app != 0u) && (app == dfu_bootApp)) )
+    {
+        status = CY_DFU_ERROR_ADDRESS;
+    }
+    else if (app != 0u)
+    {
+        dfu_bootWrittenApp = app;
+    }
+    else
+    {
+        /* Not a slot */
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootWrittenApp
+****************************************************************************//**
+*
+* Returns the slot written by the download.
+*
+* \return The slot, or 0 if the download wrote no slot.
+*
+*******************************************************************************/
+uint32_t DFU_BootWrittenApp(void)
+{
+    return (dfu_bootWrittenApp);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootTrialResume
+****************************************************************************//**
+*
+* Arms the WDT again if the running application is on trial. The CM0+ startup
+* code disables the WDT armed by App0, so the application CM0+ calls this at
+* the start of main(). Only reads the record, with no buffer.
+*
+*******************************************************************************/
+void DFU_BootTrialResume(void)
+{
+#if DFU_BOOT_TRIAL != 0
+    cy_stc_dfu_params_t params;
+    dfu_boot_ctl_t ctl;
+
+    /* The checksum does not use the buffers */
+    params.timeout      = 0u;
+    params.dataBuffer   = NULL;
+    params.packetBuffer = NULL;
+
+    if ( (DFU_BootCtlRead(&ctl, &params) == CY_DFU_SUCCESS) && (ctl.state == DFU_BOOT_STATE_TRIAL)
+      && (ctl.activeApp == Cy_DFU_GetRunningApp()) )
+    {
+        ArmWatchdog();
+    }
+#endif /* DFU_BOOT_TRIAL != 0 */
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootConfirm
+****************************************************************************//**
+*
+* Confirms the running application: if it is on trial, marks its slot as
+* confirmed and stops the WDT. Called by the application once it runs
+* properly, e.g. after its self-test. Does nothing if the application is not
+* on trial.
+*
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer, at least one flash row, is used to write the
+*                   record.
+*
+* \return
+* - CY_DFU_SUCCESS when the application is confirmed.
+* - Any other status code on error, the WDT is still armed.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_BootConfirm(cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+#if DFU_BOOT_TRIAL != 0
+    dfu_boot_ctl_t ctl;
+
+    if ( (DFU_BootCtlRead(&ctl, params) == CY_DFU_SUCCESS) && (ctl.state == DFU_BOOT_STATE_TRIAL)
+      && (ctl.activeApp == Cy_DFU_GetRunningApp()) )
+    {
+        flash_log_t log;
+
+        ctl.state = DFU_BOOT_STATE_CONFIRMED;
+
+        GetBootCtlLog(&log);
+        status = FlashLog_Append(&log, &ctl, sizeof(ctl), params);
+        if (status == CY_DFU_SUCCESS)
+        {
+            DisarmWatchdog();
+        }
+    }
+#else
+    (void) params;
+#endif /* DFU_BOOT_TRIAL != 0 */
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootExecuteApp
+****************************************************************************//**
+*
+* Drop-in replacement of Cy_DFU_ExecuteApp() for App0 CM4.
+*
+* With DFU_BOOT_DIRECT_HANDOFF, masks the interrupts of this core, posts the
+* request to CM0+ on the DFU_BOOT_IPC_CHAN channel and sleeps until CM0+
+* disables this core. The caller must stop the DFU transport and the
+* peripherals it uses first, the SMIF is left running for the XIP slot.
+* Otherwise calls Cy_DFU_ExecuteApp().
+* Arms the WDT first if the application is on trial, and records the switch
+* with DFU_BOOT_TRACE.
+*
+* \param appId  The application to switch to.
+*
+*******************************************************************************/
+void DFU_BootExecuteApp(uint32_t appId)
+{
+    DFU_TRACE(DFU_TRACE_EXECUTE, appId, 0u);
+
+#if DFU_BOOT_TRIAL != 0
+    if ( (dfu_bootTrial != 0u) && (appId == dfu_bootApp) )
+    {
+        ArmWatchdog();
+    }
+#endif /* DFU_BOOT_TRIAL != 0 */
+
+#if DFU_BOOT_DIRECT_HANDOFF != 0
+    IPC_STRUCT_Type *ipc = Cy_IPC_Drv_GetIpcBaseAddress(DFU_BOOT_IPC_CHAN);
+
+    /* The XIP slot runs from the SMIF memory mode, set there */
+    (void) DFU_BootSlotReadable(appId);
+
+    DisableInterrupts();
+
+    while (Cy_IPC_Drv_LockAcquire(ipc) != CY_IPC_DRV_SUCCESS)
+    {
+        /* Wait for the channel */
+    }
+    Cy_IPC_Drv_WriteDataValue(ipc, DFU_BOOT_HANDOFF_MAGIC | (appId & ~DFU_BOOT_HANDOFF_MASK));
+
+    /* Wakes CM0+ if it waits for an event, with DFU_BOOT_DEEPSLEEP */
+    __SEV();
+
+    for (;;)
+    {
+        /* No interrupt is enabled, so this core stays asleep until it is disabled */
+        __WFI();
+    }
+#else
+    Cy_DFU_ExecuteApp(appId);
+#endif /* DFU_BOOT_DIRECT_HANDOFF != 0 */
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootHandoffRequested
+****************************************************************************//**
+*
+* Checks for a direct handoff request of App0 CM4. Called by App0 CM0+ from
+* its main loop. When there is a request, waits for CM4 to sleep, disables
+* CM4 and frees the IPC channel.
+*
+* \param appId  The pointer to a variable to store the requested application.
+*
+* \return 1 - CM4 is disabled and the caller must switch to appId, else 0.
+*
+*******************************************************************************/
+uint32_t DFU_BootHandoffRequested(uint32_t *appId)
+{
+    uint32_t requested = 0u;
+#if DFU_BOOT_DIRECT_HANDOFF != 0
+    IPC_STRUCT_Type *ipc = Cy_IPC_Drv_GetIpcBaseAddress(DFU_BOOT_IPC_CHAN);
+
+    if (Cy_IPC_Drv_IsLockAcquired(ipc))
+    {
+        uint32_t value = Cy_IPC_Drv_ReadDataValue(ipc);
+
+        if ((value & DFU_BOOT_HANDOFF_MASK) == DFU_BOOT_HANDOFF_MAGIC)
+        {
+            while (_FLD2VAL(CPUSS_CM4_STATUS_SLEEPING, CPUSS_CM4_STATUS) == 0u)
+            {
+                /* CM4 may only be disabled while it sleeps */
+            }
+            Cy_SysDisableCM4();
+
+            Cy_IPC_Drv_WriteDataValue(ipc, 0u);
+            (void) Cy_IPC_Drv_LockRelease(ipc, CY_IPC_NO_NOTIFICATION);
+
+            *appId = value & ~DFU_BOOT_HANDOFF_MASK;
+            requested = 1u;
+        }
+    }
+#else
+    (void) appId;
+#endif /* DFU_BOOT_DIRECT_HANDOFF != 0 */
+    return (requested);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootSwitchToApp
+****************************************************************************//**
+*
+* Switches CM0+ to an application without a reset. Disables the interrupts
+* of this core, points VTOR to the application vector table and calls
+* Cy_DFU_SwitchToApp(). The application startup copies its vector table and
+* sets VTOR again, the application enables the interrupts.
+* Arms the WDT first if the application is on trial.
+*
+* \param appId  The application to switch to.
+*
+*******************************************************************************/
+void DFU_BootSwitchToApp(uint32_t appId)
+{
+    uint32_t startAddress;
+    uint32_t length;
+
+    DisableInterrupts();
+
+#if DFU_BOOT_TIMING != 0
+    DFU_BootTimingUpdate();
+#endif
+
+#if DFU_BOOT_TRIAL != 0
+    /* With the direct handoff App0 Core1 has armed it already */
+    if ( (dfu_bootTrial != 0u) && (appId == dfu_bootApp) )
+    {
+        ArmWatchdog();
+    }
+#endif /* DFU_BOOT_TRIAL != 0 */
+
+    (void) Cy_DFU_GetAppMetadata(appId, &startAddress, &length);
+    SCB->VTOR = startAddress;
+    __DSB();
+    __ISB();
+
+    /* Never returns */
+    Cy_DFU_SwitchToApp(appId);
+}
+
+
+#if DFU_BOOT_TIMING != 0
+
+/* The boot timing record, shared between all the applications */
+CY_SECTION(".cy_boot_noinit") __USED
+static dfu_boot_timing_t dfu_bootTiming;
+
+
+/*******************************************************************************
+* Function Name: DFU_BootTimingStart
+****************************************************************************//**
+*
+* Resets the boot timing record and starts the SysTick.
+* Called by App0 CM0+ at the start of main().
+*
+*******************************************************************************/
+void DFU_BootTimingStart(void)
+{
+    Cy_SysTick_SetClockSource(CY_SYSTICK_CLOCK_SOURCE_CLK_IMO);
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL  = 0u;
+    SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+
+    dfu_bootTiming.ticks  = 0u;
+    dfu_bootTiming.last   = SysTick->VAL;
+    dfu_bootTiming.flags  = 0u;
+    dfu_bootTiming.timeUs = 0u;
+    dfu_bootTiming.magic  = DFU_BOOT_TIMING_MAGIC;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootTimingUpdate
+****************************************************************************//**
+*
+* Adds the ticks passed since the previous update to the record.
+*
+*******************************************************************************/
+void DFU_BootTimingUpdate(void)
+{
+    if ( (dfu_bootTiming.magic == DFU_BOOT_TIMING_MAGIC)
+      && ((SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) != 0u) )
+    {
+        uint32_t now = SysTick->VAL;
+
+        /* The SysTick counts down */
+        dfu_bootTiming.ticks += (dfu_bootTiming.last - now) & SysTick_LOAD_RELOAD_Msk;
+        dfu_bootTiming.last = now;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootTimingFinish
+****************************************************************************//**
+*
+* Completes the boot timing record. Called by App1 CM0+ at the start of main().
+*
+* If the SysTick is still running App1 has been started by the App0 fast
+* path, and the time covers the whole boot. Otherwise a software reset has
+* stopped it, and the time only covers App0.
+*
+*******************************************************************************/
+void DFU_BootTimingFinish(void)
+{
+    if ( (dfu_bootTiming.magic == DFU_BOOT_TIMING_MAGIC)
+      && ((dfu_bootTiming.flags & DFU_BOOT_TIMING_DONE) == 0u) )
+    {
+        if ((SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) != 0u)
+        {
+            DFU_BootTimingUpdate();
+            SysTick->CTRL = 0u;
+            dfu_bootTiming.flags |= DFU_BOOT_TIMING_FAST;
+        }
+        else
+        {
+            dfu_bootTiming.flags |= DFU_BOOT_TIMING_PARTIAL;
+        }
+        dfu_bootTiming.timeUs = dfu_bootTiming.ticks / DFU_BOOT_TIMING_CLK_MHZ;
+        dfu_bootTiming.flags |= DFU_BOOT_TIMING_DONE;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_BootTimingGet
+****************************************************************************//**
+*
+* Returns the boot timing record, e.g. to report it from App1.
+*
+* \return The boot timing record, or NULL if it is not valid.
+*
+*******************************************************************************/
+const dfu_boot_timing_t * DFU_BootTimingGet(void)
+{
+    return ( (dfu_bootTiming.magic == DFU_BOOT_TIMING_MAGIC) ? &dfu_bootTiming : NULL );
+}
+
+#endif /* DFU_BOOT_TIMING != 0 */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,283 @@
+/***************************************************************************//**
+* \file dfu_boot.h
+* \version 1.0
+*
+* This file provides the boot options shared by the App0 and App1 projects,
+* the API of the application slots and of the boot timing record.
+*
+* Applications 1 and 2 are two slots for the same firmware, built for either
+* address. The boot control record in the flash_boot_ctl region selects the
+* active one, App0 starts it and keeps it from being overwritten, so
+* downloads always go to the other slot. When the download is finished and
+* valid, the record is updated in a single row write, which makes the new
+* slot active. The previous slot stays as the fallback if the active one is
+* not valid.
+*
+* A newly activated slot starts in the trial state. App0 arms the WDT before
+* it starts a slot on trial, and the application calls DFU_BootConfirm() once
+* it runs properly. If the WDT resets the device before that, App0 rolls back
+* to the previous slot. The startup code of CM0+ disables the WDT, so the
+* application CM0+ arms it again with DFU_BootTrialResume().
+*
+* Application 3 is the XIP slot, with DFU_BOOT_XIP: an image linked to run
+* from the QSPI memory through the memory mapped (XIP) window. App0 CM4
+* programs it in the QSPI memory, and enables the SMIF memory mode and cache
+* before it reads the slot. The other cores and applications can not read
+* the slot, DFU_BootSlotReadable() tells when it may be read.
+*
+* The boot timing record is placed in the .cy_boot_noinit section, so it is
+* at the same address in every application and survives the switch from App0
+* to App1. It counts IMO ticks with the CM0+ SysTick, from the start of the
+* App0 CM0+ main() to the start of the App1 CM0+ main().
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_BOOT_H)
+#define DFU_BOOT_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+* A non-zero value enables the cold boot fast path in App0 CM0+:
+* on a non-software reset App0 CM0+ validates the metadata and App1 with only
+* the system clocks initialized, and switches to App1 directly. The board,
+* CM4, the DFU transport and the metadata repair are only initialized when
+* App1 can not be started.
+* Not available with CY_DFU_OPT_CRYPTO_HW, as the Crypto server is not
+* started on the fast path.
+*/
+#define DFU_BOOT_FAST_PATH          (1)
+
+/**
+* A non-zero value enables the direct handoff from App0 to another application:
+* instead of the software reset of Cy_DFU_ExecuteApp(), App0 CM4 stops and
+* hands over to App0 CM0+ through an IPC channel. CM0+ disables CM4 and
+* switches to the application, which then starts its own CM4 image.
+* The boot ROM and the App0 startup do not run a second time.
+*/
+#define DFU_BOOT_DIRECT_HANDOFF     (0)
+
+/** The IPC channel used for the direct handoff, the Crypto uses channel 9 */
+#define DFU_BOOT_IPC_CHAN           (8u)
+
+/** The handoff request tag, the application ID is in the lower byte */
+#define DFU_BOOT_HANDOFF_MAGIC      (0x484E4400u)
+
+/** The mask of the handoff request tag */
+#define DFU_BOOT_HANDOFF_MASK       (0xFFFFFF00u)
+
+/** The first application slot */
+#define DFU_BOOT_FIRST_APP          (1u)
+
+/** The last application slot */
+#define DFU_BOOT_LAST_APP           (CY_DFU_MAX_APPS - 1u)
+
+/**
+* A non-zero value enables the XIP slot: App0 CM4 accepts the image of
+* DFU_BOOT_XIP_APP, validates it through the XIP window and starts it.
+* The SMIF is reset by a software reset, so the slot is started with the
+* direct handoff only.
+* The application startup runs from the QSPI memory. Its clock
+* initialization switches CLK_PATH0 to the IMO while the FLL locks, so
+* CLK_HF2, the SMIF clock, keeps running at a lower rate meanwhile.
+*/
+#define DFU_BOOT_XIP                (0)
+
+/** The XIP slot, in the QSPI memory */
+#define DFU_BOOT_XIP_APP            (3u)
+
+#if (DFU_BOOT_XIP != 0) && (DFU_BOOT_DIRECT_HANDOFF == 0)
+    #error "DFU_BOOT_XIP requires DFU_BOOT_DIRECT_HANDOFF"
+#endif
+
+/**
+* A non-zero value makes App0 wait for the host in DeepSleep: App0 CM4
+* sleeps between the DFU packets and wakes on the I2C address match, the
+* button or an MCWDT timeout, see dfu_sleep.h. App0 CM0+ waits for an event
+* meanwhile, so the system enters DeepSleep with CM4.
+* The I2C wakes the device from DeepSleep when "Enable wakeup from Deep
+* Sleep" is set in its Device Configurator settings, as for DFU_I2C on
+* SCB8 in the App0 design, else CM4 uses Sleep.
+* CM0+ stays active with DFU_BOOT_TIMING, its SysTick counts the boot time.
+*/
+#define DFU_BOOT_DEEPSLEEP          (0)
+
+/**
+* The DeepSleep wait of DFU_BOOT_DEEPSLEEP in the CM4 sources shared with
+* App1: the transport, the timers and the button. App1 CM4 builds them with
+* DFU_BOOT_NO_SLEEP, its main loop has other work and it does not have
+* dfu_sleep.c, so they poll and count the SysTick.
+*/
+#if (DFU_BOOT_DEEPSLEEP != 0) && !defined(DFU_BOOT_NO_SLEEP)
+    #define DFU_BOOT_SLEEP_WAIT         (1)
+#else
+    #define DFU_BOOT_SLEEP_WAIT         (0)
+#endif
+
+/**
+* A non-zero value makes a touch of the CapSense buttons Button0 and Button1
+* act as the button SW2, for enclosures without a mechanical button: App0
+* switches to App1 and App1 switches back, see dfu_touch.h. The CSD block
+* scans the buttons from its interrupt while the DFU transport runs.
+* The CSD block does not scan in DeepSleep.
+*/
+#define DFU_BOOT_TOUCH              (0)
+
+#if (DFU_BOOT_TOUCH != 0) && (DFU_BOOT_DEEPSLEEP != 0)
+    #error "DFU_BOOT_TOUCH does not work with DFU_BOOT_DEEPSLEEP"
+#endif
+
+/**
+* A non-zero value journals the EM_EEPROM window: App0 CM4 keeps the rows
+* downloaded there in a logical EEPROM of DFU_EEPROM_SIZE bytes, and commits
+* the bytes that changed at the end of the download as one transaction of
+* the em_eeprom journal, see dfu_eeprom.h. Without it the rows are written
+* to the em_eeprom flash as they are.
+*/
+#define DFU_BOOT_EEPROM             (0)
+
+/**
+* A non-zero value makes App0 CM4 keep the row data and the DFU packets in
+* one buffer: a packet is received after the part of the row assembled and
+* a gap of DFU_BOOT_PACKET_SIZE bytes, and the DFU SDK copies its data down
+* into the row, so the Send Data chunks need no separate packet buffer. The
+* I2C transport receives the packets into the DFU packet buffer directly,
+* without its receive buffer, up to DFU_BOOT_PACKET_SIZE bytes each.
+* Get Metadata then reads DFU_BOOT_PACKET_SIZE - 7 bytes at most.
+*/
+#define DFU_BOOT_SINGLE_BUFFER      (0)
+
+/** The largest DFU packet with DFU_BOOT_SINGLE_BUFFER, a multiple of 4 */
+#define DFU_BOOT_PACKET_SIZE        (128u)
+
+#if (DFU_BOOT_SINGLE_BUFFER != 0) && \
+    ((DFU_BOOT_PACKET_SIZE % 4u) != 0u || DFU_BOOT_PACKET_SIZE > CY_DFU_SIZEOF_CMD_BUFFER)
+    #error "DFU_BOOT_PACKET_SIZE must be a multiple of 4, up to CY_DFU_SIZEOF_CMD_BUFFER"
+#endif
+
+/**
+* A non-zero value profiles the DFU phases of App0 CM4 with the DWT cycle
+* counter: the transport read and response write, the packet parse of the
+* DFU SDK, Cy_DFU_WriteData(), Cy_DFU_ReadData() and the flash busy time,
+* see dfu_profile.h. The custom command DFU_CMD_PROFILE returns the figures.
+*/
+#define DFU_BOOT_PROFILE            (0)
+
+/**
+* A non-zero value records the DFU state transitions, commands, timeouts and
+* errors of App0 CM4, and the start of App1 CM4, to a ring of events in the
+* .cy_boot_noinit.trace section, see dfu_trace.h. The ring survives the
+* software resets, the custom command DFU_CMD_TRACE returns it.
+*/
+#define DFU_BOOT_TRACE              (0)
+
+/**
+* A non-zero value counts the row writes, erases, compare skips and flash
+* busy time of the CM4 writes per flash region, see dfu_wear.h. The counters
+* are kept in the flash_boot_wear rows, committed once per download. The
+* custom command DFU_CMD_WEAR returns them.
+*/
+#define DFU_BOOT_WEAR               (0)
+
+/**
+* A non-zero value enables the trial boot: a newly activated slot has to
+* confirm it runs with DFU_BootConfirm(), else the WDT resets the device and
+* App0 rolls back to the previous slot.
+*/
+#define DFU_BOOT_TRIAL              (1)
+
+/**
+* The WDT ignore bits during a trial. With 0 the WDT counts 65536 ILO cycles
+* between matches, and resets the device on the third match: about 6 s.
+*/
+#define DFU_BOOT_TRIAL_WDT_IGNORE   (0u)
+
+/** The slot is confirmed, or was activated with DFU_BOOT_TRIAL disabled */
+#define DFU_BOOT_STATE_CONFIRMED    (0u)
+
+/** The slot is on trial until the application confirms it */
+#define DFU_BOOT_STATE_TRIAL        (1u)
+
+/** A non-zero value enables the boot timing record */
+#define DFU_BOOT_TIMING             (0)
+
+/** The boot timing record is valid */
+#define DFU_BOOT_TIMING_MAGIC       (0x544D4954u)
+
+/** The SysTick clock frequency, the IMO, in MHz */
+#define DFU_BOOT_TIMING_CLK_MHZ     (8u)
+
+/** The App1 has been started with no software reset: fast path or direct handoff */
+#define DFU_BOOT_TIMING_FAST        (0x01u)
+
+/** The time is measured up to the start of the App1 CM0+ main() */
+#define DFU_BOOT_TIMING_DONE        (0x02u)
+
+/**
+* The App1 has been started through a software reset, the time does not
+* include the boot after that reset.
+*/
+#define DFU_BOOT_TIMING_PARTIAL     (0x04u)
+
+
+/** The boot control record */
+typedef struct
+{
+    uint8_t activeApp;      /**< The application slot to start */
+    uint8_t previousApp;    /**< The slot active before activeApp, 0 if none */
+    uint8_t state;          /**< The state of activeApp: DFU_BOOT_STATE_CONFIRMED or DFU_BOOT_STATE_TRIAL */
+    uint8_t reserved;       /**< Reserved, zero */
+} dfu_boot_ctl_t;
+
+/** The boot timing record */
+typedef struct
+{
+    uint32_t magic;     /**< DFU_BOOT_TIMING_MAGIC when the record is valid */
+    uint32_t ticks;     /**< The IMO ticks counted so far */
+    uint32_t last;      /**< The SysTick value at the last update */
+    uint32_t flags;     /**< DFU_BOOT_TIMING_FAST, DFU_BOOT_TIMING_DONE, DFU_BOOT_TIMING_PARTIAL */
+    uint32_t timeUs;    /**< The boot time in microseconds, valid with DFU_BOOT_TIMING_DONE */
+} dfu_boot_timing_t;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+uint32_t DFU_BootAppOf(uint32_t address);
+uint32_t DFU_BootSlotReadable(uint32_t appId);
+cy_en_dfu_status_t DFU_BootCtlRead(dfu_boot_ctl_t *ctl, cy_stc_dfu_params_t *params);
+uint32_t DFU_BootSelectApp(cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_BootActivate(uint32_t appId, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_BootCheckWrite(uint32_t address);
+uint32_t DFU_BootWrittenApp(void);
+void DFU_BootTrialResume(void);
+cy_en_dfu_status_t DFU_BootConfirm(cy_stc_dfu_params_t *params);
+
+void DFU_BootExecuteApp(uint32_t appId);
+uint32_t DFU_BootHandoffRequested(uint32_t *appId);
+void DFU_BootSwitchToApp(uint32_t appId);
+
+void DFU_BootTimingStart(void);
+void DFU_BootTimingUpdate(void);
+void DFU_BootTimingFinish(void);
+const dfu_boot_timing_t * DFU_BootTimingGet(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_BOOT_H) */
+
+
+/* [] END OF FILE */
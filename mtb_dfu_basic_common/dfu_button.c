@@ -0,0 +1,169 @@
+/***************************************************************************//**
+* \file dfu_button.c
+* \version 1.0
+*
+* This file provides the CM4 user button, see dfu_button.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include "cy_pdl.h"
+#include "dfu_boot.h"
+#include "dfu_button.h"
+#include "dfu_timer.h"
+
+#if (CY_CPU_CORTEX_M4)
+
+#if DFU_BOOT_SLEEP_WAIT != 0
+    #include "dfu_sleep.h"
+#endif
+
+/* The user button SW2, low when pressed */
+#define BUTTON_PORT             GPIO_PRT0
+#define BUTTON_PIN              (4u)
+#define BUTTON_IRQN             ioss_interrupts_gpio_0_IRQn
+
+/* The interrupt priority, the same as the DFU transport */
+#define BUTTON_INTR_PRIORITY    (7u)
+
+/* The debounce states */
+#define BUTTON_RELEASED         (0u)    /* Waits for a press */
+#define BUTTON_PRESSING         (1u)    /* Debounces a press */
+#define BUTTON_PRESSED          (2u)    /* Waits for the release */
+#define BUTTON_RELEASING        (3u)    /* Debounces the release */
+#define BUTTON_HELD             (4u)    /* Held since the start, waits for the release, no click */
+
+/* An edge occurred since the last DFU_ButtonClicked() */
+static volatile uint32_t dfu_buttonEdge = 0u;
+
+/* The debounce state */
+static uint32_t dfu_buttonState = BUTTON_RELEASED;
+
+/* Expires DFU_BUTTON_DEBOUNCE after the last edge */
+static dfu_timer_t dfu_buttonTimer;
+
+static void ButtonIsr(void);
+
+
+/*******************************************************************************
+* Function Name: ButtonIsr
+****************************************************************************//**
+*
+* This internal function handles the button interrupt, it records an edge.
+* In App0 with DFU_BOOT_DEEPSLEEP the edge also ends the wait for the host,
+* so the main loop runs the debounce.
+*
+*******************************************************************************/
+static void ButtonIsr(void)
+{
+    Cy_GPIO_ClearInterrupt(BUTTON_PORT, BUTTON_PIN);
+    dfu_buttonEdge = 1u;
+#if DFU_BOOT_SLEEP_WAIT != 0
+    DFU_SleepWake();
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_ButtonInit
+****************************************************************************//**
+*
+* Enables the interrupt on both edges of the button. Called by the
+* application after DFU_TimerInit(). A button held at the start makes no
+* click: it must be released and pressed again.
+*
+*******************************************************************************/
+void DFU_ButtonInit(void)
+{
+    static const cy_stc_sysint_t buttonIntrConfig =
+    {
+        .intrSrc      = BUTTON_IRQN,
+        .intrPriority = BUTTON_INTR_PRIORITY
+    };
+
+    dfu_buttonState = (Cy_GPIO_Read(BUTTON_PORT, BUTTON_PIN) == 0u) ? BUTTON_HELD : BUTTON_RELEASED;
+    DFU_TimerStop(&dfu_buttonTimer);
+
+    Cy_GPIO_SetInterruptEdge(BUTTON_PORT, BUTTON_PIN, CY_GPIO_INTR_BOTH);
+    Cy_GPIO_ClearInterrupt(BUTTON_PORT, BUTTON_PIN);
+    Cy_GPIO_SetInterruptMask(BUTTON_PORT, BUTTON_PIN, 1u);
+    (void) Cy_SysInt_Init(&buttonIntrConfig, &ButtonIsr);
+    NVIC_EnableIRQ(BUTTON_IRQN);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_ButtonClicked
+****************************************************************************//**
+*
+* Runs the debounce state machine. Called by the main loop after
+* DFU_TimerPoll(), it never waits.
+*
+* \return 1 - the button was clicked, it is reported once, else 0.
+*
+*******************************************************************************/
+uint32_t DFU_ButtonClicked(void)
+{
+    uint32_t clicked = 0u;
+    uint32_t edge;
+
+    NVIC_DisableIRQ(BUTTON_IRQN);
+    edge = dfu_buttonEdge;
+    dfu_buttonEdge = 0u;
+    NVIC_EnableIRQ(BUTTON_IRQN);
+
+    if (edge != 0u)
+    {
+        /* A bounce restarts the debounce time */
+        if ( (dfu_buttonState == BUTTON_RELEASED) || (dfu_buttonState == BUTTON_PRESSING) )
+        {
+            dfu_buttonState = BUTTON_PRESSING;
+        }
+        else if (dfu_buttonState != BUTTON_HELD)
+        {
+            dfu_buttonState = BUTTON_RELEASING;
+        }
+        else
+        {
+            /* The release of a button held at the start is debounced in BUTTON_HELD */
+        }
+        DFU_TimerStart(&dfu_buttonTimer, DFU_BUTTON_DEBOUNCE, 0u);
+    }
+    else if (DFU_TimerFired(&dfu_buttonTimer) != 0u)
+    {
+        const uint32_t pressed = (Cy_GPIO_Read(BUTTON_PORT, BUTTON_PIN) == 0u) ? 1u : 0u;
+
+        if (dfu_buttonState == BUTTON_PRESSING)
+        {
+            dfu_buttonState = (pressed != 0u) ? BUTTON_PRESSED : BUTTON_RELEASED;
+        }
+        else if (dfu_buttonState == BUTTON_RELEASING)
+        {
+            dfu_buttonState = (pressed != 0u) ? BUTTON_PRESSED : BUTTON_RELEASED;
+            clicked = (pressed != 0u) ? 0u : 1u;
+        }
+        else if (dfu_buttonState == BUTTON_HELD)
+        {
+            dfu_buttonState = (pressed != 0u) ? BUTTON_HELD : BUTTON_RELEASED;
+        }
+        else
+        {
+            /* Settled already */
+        }
+    }
+    else
+    {
+        /* Nothing to do */
+    }
+    return (clicked);
+}
+
+#endif /* (CY_CPU_CORTEX_M4) */
+
+
+/* [] END OF FILE */
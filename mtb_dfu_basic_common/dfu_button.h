@@ -0,0 +1,51 @@
+/***************************************************************************//**
+* \file dfu_button.h
+* \version 1.0
+*
+* This file provides the API of the CM4 user button SW2. A click switches
+* App0 to the selected application slot, and App1 to the downloaded slot or
+* back to App0.
+*
+* The button is debounced without blocking the main loop: the GPIO interrupt
+* records each edge of SW2, and DFU_ButtonClicked() runs a state machine that
+* waits DFU_BUTTON_DEBOUNCE on a timer of dfu_timer.h after an edge before it
+* reads the pin. A click is a debounced press followed by a debounced
+* release, so the main loop and the DFU transport run while the button is
+* held.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_BUTTON_H)
+#define DFU_BUTTON_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The time the pin must keep its level after an edge, in milliseconds */
+#define DFU_BUTTON_DEBOUNCE         (50u)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_ButtonInit(void);
+uint32_t DFU_ButtonClicked(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_BUTTON_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,633 @@
+/***************************************************************************//**
+* \file dfu_eeprom.c
+* \version 1.0
+*
+* This file provides the journaled Emulated EEPROM, see dfu_eeprom.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_syslib.h"
+#include "cy_flash.h"
+#include "dfu_boot.h"
+#include "dfu_eeprom.h"
+#include "dfu_wear.h"
+
+#if (DFU_BOOT_EEPROM != 0) && (CY_CPU_CORTEX_M4)
+
+/* The Emulated EEPROM flash, defined in the linker scripts */
+extern uint8_t __cy_memory_1_start;
+extern uint8_t __cy_memory_1_length;
+
+/* The row tag */
+#define EEPROM_MAGIC            (0x4A454544u)
+
+/* The row header fields, in 32-bit words */
+#define HEADER_MAGIC_IDX        (0u)
+#define HEADER_CRC_IDX          (1u)
+#define HEADER_SEQ_IDX          (2u)
+#define HEADER_TXN_IDX          (3u)
+#define HEADER_INFO_IDX         (4u)
+
+/* The size of the row header */
+#define HEADER_SIZE             (20u)
+
+/* The offset of the checksummed part of a row */
+#define CRC_START               (8u)
+
+/* The info field: the bytes used in the row and the flags */
+#define INFO_USED_MASK          (0x0000FFFFu)
+#define INFO_COMMIT             (0x00010000u)   /* The last row of a transaction */
+#define INFO_BASE               (0x00020000u)   /* The first row of a base transaction */
+
+/* The size of an entry header: the offset and the length, 16 bits each */
+#define ENTRY_HEADER_SIZE       (4u)
+
+/* Packs the entries of a commit into rows, or counts the rows */
+typedef struct
+{
+    uint32_t write;         /* 1 to write the rows, 0 to count them */
+    uint32_t flags;         /* INFO_BASE for a base transaction */
+    uint32_t used;          /* The bytes used in the current row */
+    uint32_t rows;          /* The rows written or counted */
+    cy_en_dfu_status_t status;
+    cy_stc_dfu_params_t *params;
+} dfu_eeprom_pack_t;
+
+/* The committed logical EEPROM, and the working copy the writes change */
+static uint8_t dfu_eepromImage[DFU_EEPROM_SIZE];
+static uint8_t dfu_eepromWork[DFU_EEPROM_SIZE];
+
+/* The working copy may differ from the committed one */
+static uint32_t dfu_eepromDirty = 0u;
+
+/* The next row to write, its sequence number and the next transaction */
+static uint32_t dfu_eepromNext = 0u;
+static uint32_t dfu_eepromSeq = 1u;
+static uint32_t dfu_eepromTxn = 1u;
+
+/* The rows from the latest base to the latest row written */
+static uint32_t dfu_eepromLive = 0u;
+
+/* The rows of a base */
+static uint32_t dfu_eepromBaseRows = 0u;
+
+static uint32_t RowCount(void);
+static const uint32_t *RowAt(uint32_t index);
+static uint32_t IsRowValid(uint32_t index, cy_stc_dfu_params_t *params);
+static void ApplyRow(uint32_t index);
+static void PackFlush(dfu_eeprom_pack_t *pack, uint32_t flags);
+static void PackEntry(dfu_eeprom_pack_t *pack, uint32_t offset, uint32_t length);
+static uint32_t PackChanges(dfu_eeprom_pack_t *pack);
+
+
+/*******************************************************************************
+* Function Name: RowCount
+****************************************************************************//**
+*
+* This internal function returns the number of rows of the em_eeprom region.
+*
+*******************************************************************************/
+static uint32_t RowCount(void)
+{
+    return ((uint32_t)&__cy_memory_1_length / CY_FLASH_SIZEOF_ROW);
+}
+
+
+/*******************************************************************************
+* Function Name: RowAt
+****************************************************************************//**
+*
+* This internal function returns the address of a row of the ring.
+*
+*******************************************************************************/
+static const uint32_t *RowAt(uint32_t index)
+{
+    return ((const uint32_t *)((uint32_t)&__cy_memory_1_start + (index * CY_FLASH_SIZEOF_ROW)));
+}
+
+
+/*******************************************************************************
+* Function Name: IsRowValid
+****************************************************************************//**
+*
+* This internal function checks the header and the checksum of a row.
+*
+* \param index      The row index.
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return 1 - the row is a journal row, else 0
+*
+*******************************************************************************/
+static uint32_t IsRowValid(uint32_t index, cy_stc_dfu_params_t *params)
+{
+    const uint32_t *row = RowAt(index);
+    const uint32_t used = row[HEADER_INFO_IDX] & INFO_USED_MASK;
+    uint32_t valid = 0u;
+
+    if ( (row[HEADER_MAGIC_IDX] == EEPROM_MAGIC) && (used >= HEADER_SIZE) && (used <= CY_FLASH_SIZEOF_ROW) )
+    {
+        uint32_t crc = Cy_DFU_DataChecksum((const uint8_t *)row + CRC_START, used - CRC_START, params);
+        valid = (crc == row[HEADER_CRC_IDX]) ? 1u : 0u;
+    }
+    return (valid);
+}
+
+
+/*******************************************************************************
+* Function Name: ApplyRow
+****************************************************************************//**
+*
+* This internal function copies the entries of a valid row to the committed
+* logical EEPROM. An entry outside the logical EEPROM ends the row.
+*
+* \param index      The row index.
+*
+*******************************************************************************/
+static void ApplyRow(uint32_t index)
+{
+    const uint8_t *row = (const uint8_t *)RowAt(index);
+    const uint32_t used = RowAt(index)[HEADER_INFO_IDX] & INFO_USED_MASK;
+    uint32_t pos = HEADER_SIZE;
+
+    while ((pos + ENTRY_HEADER_SIZE) <= used)
+    {
+        const uint32_t offset = (uint32_t)row[pos] | ((uint32_t)row[pos + 1u] << 8u);
+        const uint32_t length = (uint32_t)row[pos + 2u] | ((uint32_t)row[pos + 3u] << 8u);
+
+        pos += ENTRY_HEADER_SIZE;
+        if ( (length > (used - pos)) || (offset > DFU_EEPROM_SIZE) || (length > (DFU_EEPROM_SIZE - offset)) )
+        {
+            break;
+        }
+        (void) memcpy(&dfu_eepromImage[offset], &row[pos], length);
+        pos += length;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: PackFlush
+****************************************************************************//**
+*
+* This internal function ends the current row of a commit: it writes the row
+* to the next row of the ring, or only counts it.
+*
+* \param pack       The commit.
+* \param flags      INFO_COMMIT for the last row of the commit, else 0.
+*
+*******************************************************************************/
+static void PackFlush(dfu_eeprom_pack_t *pack, uint32_t flags)
+{
+    if ( (pack->write != 0u) && (pack->status == CY_DFU_SUCCESS) )
+    {
+        uint32_t *row = (uint32_t *)pack->params->dataBuffer;
+        const uint32_t address = (uint32_t)RowAt(dfu_eepromNext);
+        uint32_t start;
+        cy_en_flashdrv_status_t fstatus;
+
+        (void) memset(&pack->params->dataBuffer[pack->used], 0, CY_FLASH_SIZEOF_ROW - pack->used);
+        row[HEADER_MAGIC_IDX] = EEPROM_MAGIC;
+        row[HEADER_SEQ_IDX]   = dfu_eepromSeq;
+        row[HEADER_TXN_IDX]   = dfu_eepromTxn;
+        row[HEADER_INFO_IDX]  = pack->used | flags | ((pack->rows == 0u) ? pack->flags : 0u);
+        row[HEADER_CRC_IDX]   = Cy_DFU_DataChecksum(&pack->params->dataBuffer[CRC_START],
+                                                    pack->used - CRC_START, pack->params);
+
+        start = DFU_WEAR_BEGIN();
+        fstatus = Cy_Flash_WriteRow(address, row);
+        if ( (fstatus == CY_FLASH_DRV_SUCCESS) && (memcmp(row, (const void *)address, CY_FLASH_SIZEOF_ROW) == 0) )
+        {
+            DFU_WEAR_ROW(address, 0u, 0u, start);
+            dfu_eepromNext = (dfu_eepromNext + 1u) % RowCount();
+            dfu_eepromSeq++;
+        }
+        else
+        {
+            /* The next commit writes this row again, the rows before it
+             * stay in sequence */
+            DFU_WEAR_ROW(address, 0u, 1u, start);
+            pack->status = CY_DFU_ERROR_DATA;
+        }
+    }
+    pack->rows++;
+    pack->used = HEADER_SIZE;
+}
+
+
+/*******************************************************************************
+* Function Name: PackEntry
+****************************************************************************//**
+*
+* This internal function adds an entry of the working copy to a commit. An
+* entry longer than the rest of the row is split.
+*
+* \param pack       The commit.
+* \param offset     The offset in the logical EEPROM.
+* \param length     The size, in bytes.
+*
+*******************************************************************************/
+static void PackEntry(dfu_eeprom_pack_t *pack, uint32_t offset, uint32_t length)
+{
+    while (length != 0u)
+    {
+        uint32_t chunk;
+
+        if ((pack->used + ENTRY_HEADER_SIZE) >= CY_FLASH_SIZEOF_ROW)
+        {
+            PackFlush(pack, 0u);
+        }
+        chunk = CY_FLASH_SIZEOF_ROW - (pack->used + ENTRY_HEADER_SIZE);
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        if (pack->write != 0u)
+        {
+            uint8_t *entry = &pack->params->dataBuffer[pack->used];
+
+            entry[0] = (uint8_t)offset;
+            entry[1] = (uint8_t)(offset >> 8u);
+            entry[2] = (uint8_t)chunk;
+            entry[3] = (uint8_t)(chunk >> 8u);
+            (void) memcpy(&entry[ENTRY_HEADER_SIZE], &dfu_eepromWork[offset], chunk);
+        }
+        pack->used += ENTRY_HEADER_SIZE + chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: PackChanges
+****************************************************************************//**
+*
+* This internal function adds the bytes of the working copy that differ from
+* the committed logical EEPROM to a commit, and ends it. Runs closer than an
+* entry header are merged. A base commit adds the whole working copy.
+*
+* \param pack       The commit.
+*
+* \return The number of rows of the commit, 0 if nothing changed.
+*
+*******************************************************************************/
+static uint32_t PackChanges(dfu_eeprom_pack_t *pack)
+{
+    const uint32_t base = ((pack->flags & INFO_BASE) != 0u) ? 1u : 0u;
+    uint32_t offset = 0u;
+
+    pack->used = HEADER_SIZE;
+    pack->rows = 0u;
+    pack->status = CY_DFU_SUCCESS;
+
+    while (offset < DFU_EEPROM_SIZE)
+    {
+        if ( (base != 0u) || (dfu_eepromWork[offset] != dfu_eepromImage[offset]) )
+        {
+            uint32_t last = offset;
+            uint32_t idx;
+
+            for (idx = offset + 1u; (idx < DFU_EEPROM_SIZE) && ((idx - last) <= ENTRY_HEADER_SIZE); ++idx)
+            {
+                if ( (base != 0u) || (dfu_eepromWork[idx] != dfu_eepromImage[idx]) )
+                {
+                    last = idx;
+                }
+            }
+            PackEntry(pack, offset, (last + 1u) - offset);
+            offset = last + 1u;
+        }
+        else
+        {
+            offset++;
+        }
+    }
+
+    if (pack->used > HEADER_SIZE)
+    {
+        PackFlush(pack, INFO_COMMIT);
+    }
+    return (pack->rows);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_EepromInit
+****************************************************************************//**
+*
+* Reads the logical EEPROM: finds the latest row of the ring, walks back over
+* the rows written before it, and replays the committed transactions from the
+* oldest one. A base transaction clears the logical EEPROM first. The next
+* commit is written after the last commit row. Called once at the start,
+* before the other functions.
+*
+* \param params     The pointer to a DFU parameters structure, used for
+*                   the checksum.
+*
+*******************************************************************************/
+void DFU_EepromInit(cy_stc_dfu_params_t *params)
+{
+    const uint32_t rows = RowCount();
+    uint32_t head = 0u;
+    uint32_t found = 0u;
+    uint32_t idx;
+
+    (void) memset(dfu_eepromImage, 0, DFU_EEPROM_SIZE);
+    dfu_eepromNext = 0u;
+    dfu_eepromSeq = 1u;
+    dfu_eepromTxn = 1u;
+    dfu_eepromLive = 0u;
+
+    for (idx = 0u; idx < rows; ++idx)
+    {
+        /* Wrap-around safe comparison */
+        if ( (IsRowValid(idx, params) != 0u) &&
+             ( (found == 0u) || ((int32_t)(RowAt(idx)[HEADER_SEQ_IDX] - RowAt(head)[HEADER_SEQ_IDX]) > 0) ) )
+        {
+            head = idx;
+            found = 1u;
+        }
+    }
+
+    if (found != 0u)
+    {
+        uint32_t start = head;
+        uint32_t count = 1u;
+        uint32_t txnStart;
+        uint32_t base;
+        uint32_t last;
+        uint32_t k;
+
+        /* The rows written in turn before the latest one */
+        while (count < rows)
+        {
+            const uint32_t prev = (start + rows - 1u) % rows;
+
+            if ( (IsRowValid(prev, params) == 0u) ||
+                 (RowAt(prev)[HEADER_SEQ_IDX] != (RowAt(start)[HEADER_SEQ_IDX] - 1u)) )
+            {
+                break;
+            }
+            start = prev;
+            count++;
+        }
+
+        /* Apply the transactions with a commit row, an interrupted one has none */
+        txnStart = start;
+        base = start;
+        last = count;
+        dfu_eepromTxn = RowAt(start)[HEADER_TXN_IDX];
+        for (k = 0u; k < count; ++k)
+        {
+            const uint32_t *row;
+
+            idx = (start + k) % rows;
+            row = RowAt(idx);
+            if (row[HEADER_TXN_IDX] != RowAt(txnStart)[HEADER_TXN_IDX])
+            {
+                txnStart = idx;
+            }
+            if ((int32_t)(row[HEADER_TXN_IDX] - dfu_eepromTxn) > 0)
+            {
+                dfu_eepromTxn = row[HEADER_TXN_IDX];
+            }
+
+            if ((row[HEADER_INFO_IDX] & INFO_COMMIT) != 0u)
+            {
+                uint32_t apply = txnStart;
+
+                if ((RowAt(txnStart)[HEADER_INFO_IDX] & INFO_BASE) != 0u)
+                {
+                    (void) memset(dfu_eepromImage, 0, DFU_EEPROM_SIZE);
+                    base = txnStart;
+                }
+                for (;;)
+                {
+                    ApplyRow(apply);
+                    if (apply == idx)
+                    {
+                        break;
+                    }
+                    apply = (apply + 1u) % rows;
+                }
+                last = k;
+            }
+        }
+
+        /* The rows of an interrupted transaction after the last commit are
+         * written again, the transaction numbers stay unique */
+        dfu_eepromTxn++;
+        if (last != count)
+        {
+            idx = (start + last) % rows;
+            dfu_eepromNext = (idx + 1u) % rows;
+            dfu_eepromSeq = RowAt(idx)[HEADER_SEQ_IDX] + 1u;
+            dfu_eepromLive = ((idx + rows - base) % rows) + 1u;
+        }
+        else
+        {
+            dfu_eepromNext = start;
+            dfu_eepromSeq = RowAt(start)[HEADER_SEQ_IDX];
+        }
+    }
+
+    (void) memcpy(dfu_eepromWork, dfu_eepromImage, DFU_EEPROM_SIZE);
+    dfu_eepromDirty = 0u;
+
+    /* The size of a base, to decide at each commit */
+    {
+        dfu_eeprom_pack_t pack = { 0u, INFO_BASE, 0u, 0u, CY_DFU_SUCCESS, params };
+        dfu_eepromBaseRows = PackChanges(&pack);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_EepromRead
+****************************************************************************//**
+*
+* Reads the working copy of the logical EEPROM, with the writes not committed
+* yet.
+*
+* \param offset     The offset in the logical EEPROM.
+* \param data       The buffer to read into.
+* \param size       The size, in bytes.
+*
+* \return CY_DFU_SUCCESS, or CY_DFU_ERROR_LENGTH if the range is outside the
+*         logical EEPROM.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_EepromRead(uint32_t offset, uint8_t *data, uint32_t size)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_LENGTH;
+
+    if ( (offset <= DFU_EEPROM_SIZE) && (size <= (DFU_EEPROM_SIZE - offset)) )
+    {
+        (void) memcpy(data, &dfu_eepromWork[offset], size);
+        status = CY_DFU_SUCCESS;
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_EepromCompare
+****************************************************************************//**
+*
+* Compares data with the working copy of the logical EEPROM.
+*
+* \param offset     The offset in the logical EEPROM.
+* \param data       The data to compare.
+* \param size       The size, in bytes.
+*
+* \return
+* - CY_DFU_SUCCESS if the data is the same.
+* - CY_DFU_ERROR_VERIFY if it differs.
+* - CY_DFU_ERROR_LENGTH if the range is outside the logical EEPROM.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_EepromCompare(uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_LENGTH;
+
+    if ( (offset <= DFU_EEPROM_SIZE) && (size <= (DFU_EEPROM_SIZE - offset)) )
+    {
+        status = (memcmp(data, &dfu_eepromWork[offset], size) == 0) ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY;
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_EepromWrite
+****************************************************************************//**
+*
+* Writes the working copy of the logical EEPROM. Nothing is written to the
+* flash until DFU_EepromCommit().
+*
+* \param offset     The offset in the logical EEPROM.
+* \param data       The data to write.
+* \param size       The size, in bytes.
+*
+* \return CY_DFU_SUCCESS, or CY_DFU_ERROR_LENGTH if the range is outside the
+*         logical EEPROM.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_EepromWrite(uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_LENGTH;
+
+    if ( (offset <= DFU_EEPROM_SIZE) && (size <= (DFU_EEPROM_SIZE - offset)) )
+    {
+        (void) memcpy(&dfu_eepromWork[offset], data, size);
+        dfu_eepromDirty = 1u;
+        status = CY_DFU_SUCCESS;
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_EepromCommit
+****************************************************************************//**
+*
+* Journals the changes of the working copy as one transaction. A base is
+* written instead when the changes would take as many rows, or when the rows
+* left after this commit could not hold the next base. The previous base and
+* the transactions after it are never overwritten.
+*
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer is used to prepare the rows.
+*
+* \return
+* - CY_DFU_SUCCESS when the changes are committed, or there are none.
+* - CY_DFU_ERROR_DATA if a row write fails, the changes are kept in the
+*   working copy.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_EepromCommit(cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+
+    if (dfu_eepromDirty != 0u)
+    {
+        dfu_eeprom_pack_t pack = { 0u, 0u, 0u, 0u, CY_DFU_SUCCESS, params };
+        const uint32_t spare = RowCount() - dfu_eepromLive;
+        const uint32_t rows = PackChanges(&pack);
+
+        if (rows != 0u)
+        {
+            if ( (rows >= dfu_eepromBaseRows) || (spare < (rows + dfu_eepromBaseRows)) )
+            {
+                pack.flags = INFO_BASE;
+            }
+
+            if ( ((pack.flags & INFO_BASE) != 0u) && (spare < dfu_eepromBaseRows) )
+            {
+                /* The previous base must stay until this one is committed */
+                status = CY_DFU_ERROR_DATA;
+            }
+            else
+            {
+                const uint32_t first = dfu_eepromNext;
+                const uint32_t firstSeq = dfu_eepromSeq;
+
+                pack.write = 1u;
+                (void) PackChanges(&pack);
+                status = pack.status;
+                dfu_eepromTxn++;
+
+                if (status != CY_DFU_SUCCESS)
+                {
+                    /* The rows of the interrupted transaction are written again */
+                    dfu_eepromNext = first;
+                    dfu_eepromSeq = firstSeq;
+                }
+                else if ((pack.flags & INFO_BASE) != 0u)
+                {
+                    dfu_eepromLive = pack.rows;
+                }
+                else
+                {
+                    dfu_eepromLive += pack.rows;
+                }
+            }
+        }
+
+        if (status == CY_DFU_SUCCESS)
+        {
+            (void) memcpy(dfu_eepromImage, dfu_eepromWork, DFU_EEPROM_SIZE);
+            dfu_eepromDirty = 0u;
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_EepromDiscard
+****************************************************************************//**
+*
+* Drops the changes of the working copy not committed yet.
+*
+*******************************************************************************/
+void DFU_EepromDiscard(void)
+{
+    if (dfu_eepromDirty != 0u)
+    {
+        (void) memcpy(dfu_eepromWork, dfu_eepromImage, DFU_EEPROM_SIZE);
+        dfu_eepromDirty = 0u;
+    }
+}
+#endif /* (DFU_BOOT_EEPROM != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/* [] END OF FILE */
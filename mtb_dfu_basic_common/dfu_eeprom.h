@@ -0,0 +1,74 @@
+/***************************************************************************//**
+* \file dfu_eeprom.h
+* \version 1.0
+*
+* This file provides the API of the journaled Emulated EEPROM of the CM4
+* projects, used with DFU_BOOT_EEPROM in dfu_boot.h. It keeps the calibration
+* and configuration data downloaded to the EM_EEPROM window.
+*
+* The host and the applications see a logical EEPROM of DFU_EEPROM_SIZE
+* bytes, kept in RAM. Writes of any size change a working copy; they are
+* coalesced there until DFU_EepromCommit(), which journals the bytes that
+* changed since the previous commit as one transaction.
+*
+* The rows of the em_eeprom region are a ring of journal rows, written in
+* turn so the wear is spread over the whole region. A row holds a header
+* with a sequence number, a transaction number, flags and a checksum, then
+* entries of an offset, a length and the data. The last row of a transaction
+* is flagged as its commit, and a base transaction holds the whole logical
+* EEPROM. DFU_EepromInit() replays the transactions from the latest base, so
+* a transaction interrupted by a reset is not applied. A commit writes a new
+* base when the rows after the previous base run low, or when the changes
+* would take as many rows as a base.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_EEPROM_H)
+#define DFU_EEPROM_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+* The size of the logical EEPROM, a multiple of the row size. A base takes
+* about DFU_EEPROM_SIZE / 488 rows, at most half of the em_eeprom rows.
+*/
+#define DFU_EEPROM_SIZE             (2048u)
+
+#if (DFU_EEPROM_SIZE % CY_FLASH_SIZEOF_ROW) != 0u
+    #error "DFU_EEPROM_SIZE must be a multiple of the row size"
+#endif
+
+#if DFU_EEPROM_SIZE > 0x10000u
+    #error "DFU_EEPROM_SIZE must fit the 16-bit entry offsets"
+#endif
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_EepromInit(cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_EepromRead(uint32_t offset, uint8_t *data, uint32_t size);
+cy_en_dfu_status_t DFU_EepromCompare(uint32_t offset, const uint8_t *data, uint32_t size);
+cy_en_dfu_status_t DFU_EepromWrite(uint32_t offset, const uint8_t *data, uint32_t size);
+cy_en_dfu_status_t DFU_EepromCommit(cy_stc_dfu_params_t *params);
+void DFU_EepromDiscard(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_EEPROM_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,185 @@
+/***************************************************************************//**
+* \file dfu_profile.c
+* \version 1.0
+*
+* This file provides the DFU phase profiler, see dfu_profile.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_syslib.h"
+#include "dfu_boot.h"
+#include "dfu_profile.h"
+
+#if (DFU_BOOT_PROFILE != 0) && (CY_CPU_CORTEX_M4)
+
+/* The figures of the phases, without the clock */
+static dfu_profile_stats_t dfu_profileStats[DFU_PROFILE_PHASES];
+
+/* The cycles of the phases within the current Cy_DFU_Continue() */
+static uint32_t dfu_profileNested = 0u;
+
+/* A packet for the DFU SDK was read within the current Cy_DFU_Continue() */
+static uint32_t dfu_profilePacket = 0u;
+
+
+/*******************************************************************************
+* Function Name: DFU_ProfileInit
+****************************************************************************//**
+*
+* Starts the DWT cycle counter and clears the figures.
+*
+*******************************************************************************/
+void DFU_ProfileInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    DFU_ProfileClear(DFU_PROFILE_PHASES);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_ProfileBeginParse
+****************************************************************************//**
+*
+* Starts DFU_PROFILE_PARSE, use DFU_PROFILE_BEGIN_PARSE() before
+* Cy_DFU_Continue(): the phases measured until DFU_PROFILE_END() are taken
+* off its duration.
+*
+* \return The start of the phase.
+*
+*******************************************************************************/
+uint32_t DFU_ProfileBeginParse(void)
+{
+    dfu_profileNested = 0u;
+    dfu_profilePacket = 0u;
+    return (DWT->CYCCNT);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_ProfileRecord
+****************************************************************************//**
+*
+* Adds a duration to the figures of a phase, use DFU_PROFILE_END().
+* The DFU_PROFILE_PARSE duration is the whole Cy_DFU_Continue(), the other
+* phases within it are taken off, and it is dropped when no packet was read.
+* The phases measured outside Cy_DFU_Continue() are not taken off.
+*
+* \param phase      The phase, DFU_PROFILE_...
+* \param cycles     The duration, in cycles.
+*
+*******************************************************************************/
+void DFU_ProfileRecord(uint32_t phase, uint32_t cycles)
+{
+    uint32_t record = 1u;
+
+    if (phase == DFU_PROFILE_PARSE)
+    {
+        record = dfu_profilePacket;
+        cycles = (cycles > dfu_profileNested) ? (cycles - dfu_profileNested) : 0u;
+    }
+    else if (phase != DFU_PROFILE_FLASH)
+    {
+        /* The flash busy time is within Cy_DFU_WriteData() */
+        dfu_profileNested += cycles;
+        if (phase == DFU_PROFILE_READ)
+        {
+            dfu_profilePacket = 1u;
+        }
+    }
+    else
+    {
+        /* Nothing to account */
+    }
+
+    if ( (record != 0u) && (phase < DFU_PROFILE_PHASES) )
+    {
+        dfu_profile_stats_t *stats = &dfu_profileStats[phase];
+        uint32_t bucket = 31u - (uint32_t)__CLZ(cycles | 1u);
+
+        bucket = (bucket > DFU_PROFILE_BUCKET_SHIFT) ? (bucket - DFU_PROFILE_BUCKET_SHIFT) : 0u;
+        if (bucket >= DFU_PROFILE_BUCKETS)
+        {
+            bucket = DFU_PROFILE_BUCKETS - 1u;
+        }
+
+        if ( (stats->count == 0u) || (cycles < stats->min) )
+        {
+            stats->min = cycles;
+        }
+        if (cycles > stats->max)
+        {
+            stats->max = cycles;
+        }
+        stats->count++;
+        stats->sum += cycles;
+        if (stats->histogram[bucket] != 0xFFFFu)
+        {
+            stats->histogram[bucket]++;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_ProfileGet
+****************************************************************************//**
+*
+* Returns the figures of a phase.
+*
+* \param phase      The phase, DFU_PROFILE_...
+* \param stats      The pointer to the figures to fill.
+*
+* \return
+* - CY_DFU_SUCCESS when the figures are returned.
+* - CY_DFU_ERROR_DATA if the phase is not valid.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_ProfileGet(uint32_t phase, dfu_profile_stats_t *stats)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_DATA;
+
+    if (phase < DFU_PROFILE_PHASES)
+    {
+        *stats = dfu_profileStats[phase];
+        stats->clock = SystemCoreClock;
+        status = CY_DFU_SUCCESS;
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_ProfileClear
+****************************************************************************//**
+*
+* Clears the figures of a phase.
+*
+* \param phase      The phase, DFU_PROFILE_..., or DFU_PROFILE_PHASES to
+*                   clear all of them.
+*
+*******************************************************************************/
+void DFU_ProfileClear(uint32_t phase)
+{
+    if (phase < DFU_PROFILE_PHASES)
+    {
+        (void) memset(&dfu_profileStats[phase], 0, sizeof(dfu_profileStats[0]));
+    }
+    else
+    {
+        (void) memset(dfu_profileStats, 0, sizeof(dfu_profileStats));
+    }
+}
+
+#endif /* (DFU_BOOT_PROFILE != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/* [] END OF FILE */
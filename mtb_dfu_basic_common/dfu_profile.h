@@ -0,0 +1,113 @@
+/***************************************************************************//**
+* \file dfu_profile.h
+* \version 1.0
+*
+* This file provides the API of the DFU phase profiler of the CM4 projects,
+* used with DFU_BOOT_PROFILE in dfu_boot.h.
+*
+* The phases are measured with the DWT cycle counter of CM4, at the CPU
+* clock: DFU_PROFILE_BEGIN() reads the counter, DFU_PROFILE_END() adds the
+* cycles since to the figures of a phase. A phase keeps its count, minimum,
+* maximum and sum, for the mean, and a histogram of DFU_PROFILE_BUCKETS
+* power of 2 buckets: bucket n counts the durations of 2^(n + 8) cycles up
+* to 2^(n + 9) - 1, the first and last buckets also count the shorter and
+* longer ones. A bucket stops at 65535.
+*
+* DFU_PROFILE_PARSE is the part of Cy_DFU_Continue() not spent in the other
+* phases, for the packets the DFU SDK receives. DFU_PROFILE_FLASH is a part
+* of DFU_PROFILE_WRITE_DATA. DFU_PROFILE_READ includes the wait for the
+* host, the DWT does not count while CM4 sleeps with DFU_BOOT_DEEPSLEEP.
+*
+* Without DFU_BOOT_PROFILE the macros compile to nothing.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_PROFILE_H)
+#define DFU_PROFILE_H
+
+#include "cy_syslib.h"
+#include "cy_dfu.h"
+#include "dfu_boot.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The transport read of a packet for the DFU SDK, with the wait for it */
+#define DFU_PROFILE_READ            (0u)
+
+/** The packet parse and checks of the DFU SDK */
+#define DFU_PROFILE_PARSE           (1u)
+
+/** Cy_DFU_WriteData() */
+#define DFU_PROFILE_WRITE_DATA      (2u)
+
+/** Cy_DFU_ReadData() */
+#define DFU_PROFILE_READ_DATA       (3u)
+
+/** The flash busy time of a row write */
+#define DFU_PROFILE_FLASH           (4u)
+
+/** The transport write of a response */
+#define DFU_PROFILE_RESPONSE        (5u)
+
+/** The number of phases */
+#define DFU_PROFILE_PHASES          (6u)
+
+/** The number of histogram buckets */
+#define DFU_PROFILE_BUCKETS         (16u)
+
+/** The duration of the first bucket, 2^8 cycles */
+#define DFU_PROFILE_BUCKET_SHIFT    (8u)
+
+/** The figures of a phase, as returned by DFU_CMD_PROFILE */
+typedef struct
+{
+    uint32_t clock;                             /**< The CPU clock, in Hz */
+    uint32_t count;                             /**< The durations measured */
+    uint32_t min;                               /**< The shortest, in cycles */
+    uint32_t max;                               /**< The longest, in cycles */
+    uint64_t sum;                               /**< The sum, in cycles */
+    uint16_t histogram[DFU_PROFILE_BUCKETS];    /**< See dfu_profile.h */
+} dfu_profile_stats_t;
+
+#if (DFU_BOOT_PROFILE != 0) && (CY_CPU_CORTEX_M4)
+    /** Returns the start of a phase */
+    #define DFU_PROFILE_BEGIN()             (DWT->CYCCNT)
+
+    /** Returns the start of DFU_PROFILE_PARSE, around Cy_DFU_Continue() */
+    #define DFU_PROFILE_BEGIN_PARSE()       DFU_ProfileBeginParse()
+
+    /** Ends a phase */
+    #define DFU_PROFILE_END(phase, start)   DFU_ProfileRecord((phase), DWT->CYCCNT - (start))
+#else
+    #define DFU_PROFILE_BEGIN()             (0u)
+    #define DFU_PROFILE_BEGIN_PARSE()       (0u)
+    #define DFU_PROFILE_END(phase, start)   ((void)(phase), (void)(start))
+#endif /* (DFU_BOOT_PROFILE != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_ProfileInit(void);
+uint32_t DFU_ProfileBeginParse(void);
+void DFU_ProfileRecord(uint32_t phase, uint32_t cycles);
+cy_en_dfu_status_t DFU_ProfileGet(uint32_t phase, dfu_profile_stats_t *stats);
+void DFU_ProfileClear(uint32_t phase);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_PROFILE_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,215 @@
+/***************************************************************************//**
+* \file dfu_settings.c
+* \version 1.0
+*
+* This file provides the bootloader settings, see dfu_settings.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_syslib.h"
+#include "cy_flash.h"
+#include "flash_log.h"
+#include "dfu_settings.h"
+
+/* The settings rows, defined in the linker scripts */
+extern uint8_t __cy_boot_settings_addr;
+extern uint8_t __cy_boot_settings_length;
+
+/* The stored record: the keys set and their values */
+typedef struct
+{
+    uint32_t mask;                          /* Bit n set: key n is set */
+    uint32_t value[DFU_SETTINGS_COUNT];     /* The values, by key */
+} dfu_settings_record_t;
+
+/* The valid values of a key */
+typedef struct
+{
+    uint32_t min;
+    uint32_t max;
+} dfu_settings_range_t;
+
+/* The valid values, by key */
+static const dfu_settings_range_t dfu_settingsRanges[DFU_SETTINGS_COUNT] =
+{
+    { 0x08u, 0x77u },           /* DFU_SETTING_I2C_ADDRESS */
+    { 1u, 1000u },              /* DFU_SETTING_PACKET_TIMEOUT */
+    { 100u, 60000u },           /* DFU_SETTING_SESSION_TIMEOUT */
+    { 1000u, 3600000u },        /* DFU_SETTING_IDLE_TIMEOUT */
+};
+
+/* The settings, read by DFU_SettingsInit() */
+static dfu_settings_record_t dfu_settings;
+
+static void GetSettingsLog(flash_log_t *log);
+
+
+/*******************************************************************************
+* Function Name: GetSettingsLog
+****************************************************************************//**
+*
+* This internal function returns the flash log of the settings.
+*
+*******************************************************************************/
+static void GetSettingsLog(flash_log_t *log)
+{
+    log->address = (uint32_t)&__cy_boot_settings_addr;
+    log->rows    = (uint32_t)&__cy_boot_settings_length / CY_FLASH_SIZEOF_ROW;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SettingsInit
+****************************************************************************//**
+*
+* Reads the settings. A value out of its range, e.g. after a range change,
+* is not used. Called at the start, before the settings are used.
+*
+* \param params     The pointer to a DFU parameters structure, used for
+*                   the checksum.
+*
+*******************************************************************************/
+void DFU_SettingsInit(cy_stc_dfu_params_t *params)
+{
+    flash_log_t log;
+    uint32_t key;
+
+    GetSettingsLog(&log);
+    if (FlashLog_Read(&log, &dfu_settings, sizeof(dfu_settings), NULL, params) != CY_DFU_SUCCESS)
+    {
+        (void) memset(&dfu_settings, 0, sizeof(dfu_settings));
+    }
+
+    for (key = 0u; key < DFU_SETTINGS_COUNT; ++key)
+    {
+        if ( (dfu_settings.value[key] < dfu_settingsRanges[key].min) ||
+             (dfu_settings.value[key] > dfu_settingsRanges[key].max) )
+        {
+            dfu_settings.mask &= ~(1UL << key);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SettingsGet
+****************************************************************************//**
+*
+* Returns a setting.
+*
+* \param key            The key, DFU_SETTING_...
+* \param defaultValue   The value to return if the key is not set.
+*
+* \return The value.
+*
+*******************************************************************************/
+uint32_t DFU_SettingsGet(uint32_t key, uint32_t defaultValue)
+{
+    return ( ( (key < DFU_SETTINGS_COUNT) && ((dfu_settings.mask & (1UL << key)) != 0u) )
+             ? dfu_settings.value[key] : defaultValue );
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SettingsList
+****************************************************************************//**
+*
+* Returns the keys set and their values.
+*
+* \param settings   The array to fill, in key order.
+* \param max        The size of the array.
+*
+* \return The number of settings filled.
+*
+*******************************************************************************/
+uint32_t DFU_SettingsList(dfu_setting_t settings[], uint32_t max)
+{
+    uint32_t count = 0u;
+    uint32_t key;
+
+    for (key = 0u; (key < DFU_SETTINGS_COUNT) && (count < max); ++key)
+    {
+        if ((dfu_settings.mask & (1UL << key)) != 0u)
+        {
+            settings[count].key = key;
+            settings[count].value = dfu_settings.value[key];
+            count++;
+        }
+    }
+    return (count);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_SettingsSet
+****************************************************************************//**
+*
+* Sets or clears settings, and stores them with one record if they changed.
+* Nothing is changed if a setting is not valid.
+*
+* \param settings   The settings, a value of DFU_SETTINGS_DEFAULT clears
+*                   the key.
+* \param count      The number of settings.
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer is used to write the record.
+*
+* \return
+* - CY_DFU_SUCCESS when the settings are stored.
+* - CY_DFU_ERROR_DATA if a key or a value is not valid, or the write fails.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_SettingsSet(const dfu_setting_t settings[], uint32_t count,
+                                   cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    dfu_settings_record_t record = dfu_settings;
+    uint32_t idx;
+
+    for (idx = 0u; (idx < count) && (status == CY_DFU_SUCCESS); ++idx)
+    {
+        const uint32_t key = settings[idx].key;
+        const uint32_t value = settings[idx].value;
+
+        if (key >= DFU_SETTINGS_COUNT)
+        {
+            status = CY_DFU_ERROR_DATA;
+        }
+        else if (value == DFU_SETTINGS_DEFAULT)
+        {
+            record.mask &= ~(1UL << key);
+            record.value[key] = 0u;
+        }
+        else if ( (value >= dfu_settingsRanges[key].min) && (value <= dfu_settingsRanges[key].max) )
+        {
+            record.mask |= (1UL << key);
+            record.value[key] = value;
+        }
+        else
+        {
+            status = CY_DFU_ERROR_DATA;
+        }
+    }
+
+    if ( (status == CY_DFU_SUCCESS) && (memcmp(&record, &dfu_settings, sizeof(record)) != 0) )
+    {
+        flash_log_t log;
+
+        GetSettingsLog(&log);
+        status = FlashLog_Append(&log, &record, sizeof(record), params);
+        if (status == CY_DFU_SUCCESS)
+        {
+            dfu_settings = record;
+        }
+    }
+    return (status);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,81 @@
+/***************************************************************************//**
+* \file dfu_settings.h
+* \version 1.0
+*
+* This file provides the API of the bootloader settings: the I2C address of
+* the DFU transport and the App0 timeouts, tuned per product without a
+* rebuild of App0.
+*
+* A setting is a key, a small number, and a 32-bit value. The settings set
+* are stored as one record of the flash_log.h ring over the flash_storage
+* rows, so a change writes the next row of the ring and a reset during the
+* write leaves the previous settings. DFU_SettingsInit() reads the record
+* into RAM once, DFU_SettingsGet() then takes a mask test and an array read.
+* A key that is not set returns the default of the caller, the value built
+* into the firmware.
+*
+* The custom commands DFU_CMD_SETTINGS_GET and DFU_CMD_SETTINGS_SET of
+* dfu_cmd.h read and change the settings. The applications read them at
+* their start, so a change takes effect at the next start.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_SETTINGS_H)
+#define DFU_SETTINGS_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The 7-bit I2C slave address of the DFU transport, 0x08 to 0x77 */
+#define DFU_SETTING_I2C_ADDRESS         (0u)
+
+/** The App0 wait for a DFU packet, 1 to 1000 ms */
+#define DFU_SETTING_PACKET_TIMEOUT      (1u)
+
+/** The App0 session timeout: no command during a download, 100 ms to 60 s */
+#define DFU_SETTING_SESSION_TIMEOUT     (2u)
+
+/** The App0 idle timeout: no download, 1 s to 1 hour */
+#define DFU_SETTING_IDLE_TIMEOUT        (3u)
+
+/** The number of keys, new keys are added at the end */
+#define DFU_SETTINGS_COUNT              (4u)
+
+/** The value that clears a setting, its default is used again */
+#define DFU_SETTINGS_DEFAULT            (0xFFFFFFFFu)
+
+/** A setting, as read and written by the custom commands */
+typedef struct
+{
+    uint32_t key;       /**< The key, DFU_SETTING_... */
+    uint32_t value;     /**< The value, or DFU_SETTINGS_DEFAULT to clear it */
+} dfu_setting_t;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_SettingsInit(cy_stc_dfu_params_t *params);
+uint32_t DFU_SettingsGet(uint32_t key, uint32_t defaultValue);
+uint32_t DFU_SettingsList(dfu_setting_t settings[], uint32_t max);
+cy_en_dfu_status_t DFU_SettingsSet(const dfu_setting_t settings[], uint32_t count,
+                                   cy_stc_dfu_params_t *params);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_SETTINGS_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,366 @@
+/***************************************************************************//**
+* \file dfu_timer.c
+* \version 1.0
+*
+* This file provides the CM4 millisecond timebase and software timers, see
+* dfu_timer.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include "cy_pdl.h"
+#include "dfu_boot.h"
+#include "dfu_timer.h"
+
+#if (CY_CPU_CORTEX_M4)
+
+#if DFU_BOOT_SLEEP_WAIT != 0
+    #include "dfu_sleep.h"
+#endif
+#if DFU_BOOT_TRACE != 0
+    #include "dfu_trace.h"
+#endif
+
+/* The wheel slot of a time */
+#define TIMER_SLOT(time)        ((time) & (DFU_TIMER_SLOTS - 1u))
+
+/* Time a is before time b, both within 2^31 ms */
+#define TIMER_BEFORE(a, b)      ((int32_t)((a) - (b)) < 0)
+
+/* The timer wheel, a list of timers per slot */
+static dfu_timer_t *dfu_timerWheel[DFU_TIMER_SLOTS];
+
+/* The time of the last DFU_TimerPoll() */
+static uint32_t dfu_timerPolled = 0u;
+
+/* The time in milliseconds */
+static volatile uint32_t dfu_timerMs = 0u;
+
+#if DFU_BOOT_SLEEP_WAIT != 0
+    /* The MCWDT ticks counted into dfu_timerMs, and the rest times 1000 */
+    static uint32_t dfu_timerTicks = 0u;
+    static uint32_t dfu_timerRest = 0u;
+#else
+    static void TimerTick(void);
+#endif
+
+static void TimerInsert(dfu_timer_t *timer);
+static void TimerRemove(dfu_timer_t *timer);
+
+
+#if DFU_BOOT_SLEEP_WAIT == 0
+/*******************************************************************************
+* Function Name: TimerTick
+****************************************************************************//**
+*
+* This internal function is the SysTick callback, it counts a millisecond.
+*
+*******************************************************************************/
+static void TimerTick(void)
+{
+    dfu_timerMs++;
+}
+#endif /* DFU_BOOT_SLEEP_WAIT == 0 */
+
+
+/*******************************************************************************
+* Function Name: TimerInsert
+****************************************************************************//**
+*
+* This internal function adds a timer to the wheel slot of its expiry time.
+*
+* \param timer      The timer.
+*
+*******************************************************************************/
+static void TimerInsert(dfu_timer_t *timer)
+{
+    const uint32_t slot = TIMER_SLOT(timer->expiry);
+
+    timer->next = dfu_timerWheel[slot];
+    timer->running = 1u;
+    dfu_timerWheel[slot] = timer;
+}
+
+
+/*******************************************************************************
+* Function Name: TimerRemove
+****************************************************************************//**
+*
+* This internal function removes a running timer from the wheel.
+*
+* \param timer      The timer.
+*
+*******************************************************************************/
+static void TimerRemove(dfu_timer_t *timer)
+{
+    dfu_timer_t **link = &dfu_timerWheel[TIMER_SLOT(timer->expiry)];
+
+    while ( (*link != NULL) && (*link != timer) )
+    {
+        link = &(*link)->next;
+    }
+    if (*link == timer)
+    {
+        *link = timer->next;
+    }
+    timer->next = NULL;
+    timer->running = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TimerInit
+****************************************************************************//**
+*
+* Starts the timebase, in App0 with DFU_BOOT_DEEPSLEEP after DFU_SleepInit().
+* Called by the application before it starts the timers.
+*
+*******************************************************************************/
+void DFU_TimerInit(void)
+{
+    uint32_t slot;
+
+    for (slot = 0u; slot < DFU_TIMER_SLOTS; slot++)
+    {
+        dfu_timerWheel[slot] = NULL;
+    }
+
+#if DFU_BOOT_SLEEP_WAIT != 0
+    dfu_timerTicks = DFU_SleepTicks();
+    dfu_timerRest = 0u;
+#else
+    /* The IMO keeps the same rate whatever the clock configuration */
+    Cy_SysTick_Init(CY_SYSTICK_CLOCK_SOURCE_CLK_IMO, (DFU_TIMER_CLK_HZ / 1000u) - 1u);
+    (void) Cy_SysTick_SetCallback(0u, &TimerTick);
+#endif
+
+    dfu_timerPolled = DFU_TimerNow();
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TimerNow
+****************************************************************************//**
+*
+* Returns the time since DFU_TimerInit(), it wraps around after about 49 days.
+* In App0 with DFU_BOOT_DEEPSLEEP it must be called at least once in 36 hours,
+* the period of the MCWDT timebase.
+*
+* \return The time, in milliseconds.
+*
+*******************************************************************************/
+uint32_t DFU_TimerNow(void)
+{
+#if DFU_BOOT_SLEEP_WAIT != 0
+    const uint32_t ticks = DFU_SleepTicks();
+    uint64_t scaled = ((uint64_t)(ticks - dfu_timerTicks) * 1000u) + dfu_timerRest;
+
+    dfu_timerTicks = ticks;
+    dfu_timerMs += (uint32_t)(scaled / DFU_SLEEP_TICK_HZ);
+    dfu_timerRest = (uint32_t)(scaled % DFU_SLEEP_TICK_HZ);
+#endif
+    return (dfu_timerMs);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TimerStart
+****************************************************************************//**
+*
+* Starts a timer, or starts a running timer again, and clears its fired state.
+*
+* \param timer      The timer.
+* \param timeout    The time to the first expiry, in milliseconds, at least 1.
+* \param period     The time between the next expiries, in milliseconds, or 0
+*                   to expire once.
+*
+*******************************************************************************/
+void DFU_TimerStart(dfu_timer_t *timer, uint32_t timeout, uint32_t period)
+{
+    if (timer->running != 0u)
+    {
+        TimerRemove(timer);
+    }
+
+    /* The slot of the current time may have been polled already */
+    timer->expiry = DFU_TimerNow() + ((timeout != 0u) ? timeout : 1u);
+    timer->period = period;
+    timer->fired = 0u;
+    TimerInsert(timer);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TimerStop
+****************************************************************************//**
+*
+* Stops a timer and clears its fired state.
+*
+* \param timer      The timer.
+*
+*******************************************************************************/
+void DFU_TimerStop(dfu_timer_t *timer)
+{
+    if (timer->running != 0u)
+    {
+        TimerRemove(timer);
+    }
+    timer->fired = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TimerPoll
+****************************************************************************//**
+*
+* Marks the timers that expired since the last call as fired, and starts the
+* periodic ones again. Called by the main loop after each wait.
+*
+*******************************************************************************/
+void DFU_TimerPoll(void)
+{
+    const uint32_t now = DFU_TimerNow();
+    uint32_t slots = now - dfu_timerPolled;
+    uint32_t time = dfu_timerPolled;
+    dfu_timer_t *expired = NULL;
+    dfu_timer_t *timer;
+
+    if (slots > DFU_TIMER_SLOTS)
+    {
+        slots = DFU_TIMER_SLOTS;
+    }
+
+    /* Take the expired timers off the visited slots */
+    while (slots != 0u)
+    {
+        dfu_timer_t **link;
+
+        time++;
+        slots--;
+        link = &dfu_timerWheel[TIMER_SLOT(time)];
+        while (*link != NULL)
+        {
+            timer = *link;
+            if (TIMER_BEFORE(now, timer->expiry))
+            {
+                /* Expires on a later turn of the wheel */
+                link = &timer->next;
+            }
+            else
+            {
+                *link = timer->next;
+                timer->next = expired;
+                expired = timer;
+            }
+        }
+    }
+    dfu_timerPolled = now;
+
+    /* Fire them, a periodic timer skips the periods already passed */
+    while (expired != NULL)
+    {
+        timer = expired;
+        expired = timer->next;
+        timer->fired = 1u;
+        timer->running = 0u;
+        timer->next = NULL;
+
+        if (timer->period != 0u)
+        {
+            timer->expiry += timer->period * (((now - timer->expiry) / timer->period) + 1u);
+            TimerInsert(timer);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TimerFired
+****************************************************************************//**
+*
+* Returns whether a timer expired, and clears its fired state.
+*
+* \param timer      The timer.
+*
+* \return 1 - the timer expired since the last call or since it was started,
+*         else 0.
+*
+*******************************************************************************/
+uint32_t DFU_TimerFired(dfu_timer_t *timer)
+{
+    const uint32_t fired = timer->fired;
+
+    timer->fired = 0u;
+    return (fired);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TimerNext
+****************************************************************************//**
+*
+* Returns the time until the first running timer expires, the longest the
+* main loop may wait before it calls DFU_TimerPoll().
+*
+* \param limit      The longest time to return, in milliseconds.
+*
+* \return The time, in milliseconds, from 1 to limit.
+*
+*******************************************************************************/
+uint32_t DFU_TimerNext(uint32_t limit)
+{
+    const uint32_t now = DFU_TimerNow();
+    uint32_t next = limit;
+    uint32_t slot;
+
+    for (slot = 0u; slot < DFU_TIMER_SLOTS; slot++)
+    {
+        const dfu_timer_t *timer;
+
+        for (timer = dfu_timerWheel[slot]; timer != NULL; timer = timer->next)
+        {
+            if (!TIMER_BEFORE(now, timer->expiry))
+            {
+                next = 0u;
+            }
+            else if ((timer->expiry - now) < next)
+            {
+                next = timer->expiry - now;
+            }
+            else
+            {
+                /* Expires later */
+            }
+        }
+    }
+    return ((next != 0u) ? next : 1u);
+}
+
+
+#if DFU_BOOT_TRACE != 0
+/*******************************************************************************
+* Function Name: DFU_TraceTime
+****************************************************************************//**
+*
+* Returns the time of the trace events, see dfu_trace.h. In App0 with
+* DFU_BOOT_DEEPSLEEP it is the time of the last DFU_TimerNow(), called once
+* per loop turn, so the events recorded are not slowed down.
+*
+* \return The time, in milliseconds.
+*
+*******************************************************************************/
+uint32_t DFU_TraceTime(void)
+{
+    return (dfu_timerMs);
+}
+#endif /* DFU_BOOT_TRACE != 0 */
+
+#endif /* (CY_CPU_CORTEX_M4) */
+
+
+/* [] END OF FILE */
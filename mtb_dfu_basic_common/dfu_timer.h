@@ -0,0 +1,74 @@
+/***************************************************************************//**
+* \file dfu_timer.h
+* \version 1.0
+*
+* This file provides the API of the CM4 millisecond timebase and software
+* timers, which time the DFU timeouts, the LED blink and the button debounce
+* independently of the main loop rate, in App0 and in App1.
+*
+* The timebase counts milliseconds with the CM4 SysTick, clocked by the IMO
+* so it does not depend on the clock configuration. With DFU_BOOT_DEEPSLEEP
+* the SysTick stops in DeepSleep, so App0 uses the MCWDT timebase of
+* dfu_sleep.h instead, see DFU_BOOT_SLEEP_WAIT.
+*
+* The timers are kept on a hashed timer wheel of DFU_TIMER_SLOTS one
+* millisecond slots, indexed by the expiry time. DFU_TimerPoll() visits the
+* slots of the time passed since the previous poll, at most one turn of the
+* wheel, and marks the timers due as fired. A periodic timer is then started
+* again from its expiry time, so it does not drift; the periods missed while
+* the loop stalled, e.g. on a flash write, fire once.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_TIMER_H)
+#define DFU_TIMER_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The SysTick clock, the IMO, in Hz */
+#define DFU_TIMER_CLK_HZ            (8000000u)
+
+/** The number of slots of the timer wheel, a power of 2 */
+#define DFU_TIMER_SLOTS             (32u)
+
+/** A software timer, owned by the caller and zero-initialized before use */
+typedef struct dfu_timer
+{
+    struct dfu_timer *next;     /**< The next timer of the same wheel slot */
+    uint32_t expiry;            /**< The DFU_TimerNow() time it expires at */
+    uint32_t period;            /**< The period in milliseconds, 0 for a one-shot timer */
+    uint32_t running;           /**< 1 while the timer is on the wheel */
+    uint32_t fired;             /**< 1 when the timer expired and was not read yet */
+} dfu_timer_t;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_TimerInit(void);
+uint32_t DFU_TimerNow(void);
+void DFU_TimerStart(dfu_timer_t *timer, uint32_t timeout, uint32_t period);
+void DFU_TimerStop(dfu_timer_t *timer);
+void DFU_TimerPoll(void);
+uint32_t DFU_TimerFired(dfu_timer_t *timer);
+uint32_t DFU_TimerNext(uint32_t limit);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_TIMER_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,144 @@
+/***************************************************************************//**
+* \file dfu_touch.c
+* \version 1.0
+*
+* This file provides the CapSense buttons, see dfu_touch.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include "cy_pdl.h"
+#include "dfu_boot.h"
+#include "dfu_touch.h"
+
+/* The CapSense middleware runs on CM4, CY_CAPSENSE_CORE in the design */
+#if (DFU_BOOT_TOUCH != 0) && (CY_CPU_CORTEX_M4)
+
+#include "cycfg_capsense.h"
+
+/* The interrupt priority, the same as the DFU transport */
+#define TOUCH_INTR_PRIORITY     (7u)
+
+/* The scans run, DFU_TouchStart() succeeded */
+static uint32_t dfu_touchRunning = 0u;
+
+/* A button was touched in the last processed scan */
+static uint32_t dfu_touchActive = 0u;
+
+static void TouchIsr(void);
+
+
+/*******************************************************************************
+* Function Name: TouchIsr
+****************************************************************************//**
+*
+* This internal function handles the CSD interrupt, it scans the next sensor.
+*
+*******************************************************************************/
+static void TouchIsr(void)
+{
+    Cy_CapSense_InterruptHandler(CYBSP_CSD_HW, &cy_capsense_context);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TouchStart
+****************************************************************************//**
+*
+* Initializes the CapSense middleware, calibrates the sensors and starts the
+* first scan. The calibration waits for a few scans.
+*
+* \return CY_DFU_SUCCESS if the scans run, else CY_DFU_ERROR_UNKNOWN.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_TouchStart(void)
+{
+    static const cy_stc_sysint_t touchIntrConfig =
+    {
+        .intrSrc      = CYBSP_CSD_IRQ,
+        .intrPriority = TOUCH_INTR_PRIORITY
+    };
+    cy_en_dfu_status_t status = CY_DFU_ERROR_UNKNOWN;
+
+    if (Cy_CapSense_Init(&cy_capsense_context) == CY_RET_SUCCESS)
+    {
+        (void) Cy_SysInt_Init(&touchIntrConfig, &TouchIsr);
+        NVIC_ClearPendingIRQ(CYBSP_CSD_IRQ);
+        NVIC_EnableIRQ(CYBSP_CSD_IRQ);
+
+        if ( (Cy_CapSense_Enable(&cy_capsense_context) == CY_RET_SUCCESS) &&
+             (Cy_CapSense_ScanAllWidgets(&cy_capsense_context) == CY_RET_SUCCESS) )
+        {
+            dfu_touchActive = 0u;
+            dfu_touchRunning = 1u;
+            status = CY_DFU_SUCCESS;
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TouchClicked
+****************************************************************************//**
+*
+* Processes the buttons when a scan is done, and starts the next scan. Called
+* by the main loop, it never waits for a scan.
+*
+* \return 1 - a button was released since the last call, else 0.
+*
+*******************************************************************************/
+uint32_t DFU_TouchClicked(void)
+{
+    uint32_t clicked = 0u;
+
+    if ( (dfu_touchRunning != 0u) && (Cy_CapSense_IsBusy(&cy_capsense_context) == CY_CAPSENSE_NOT_BUSY) )
+    {
+        uint32_t active;
+
+        /* The slider is scanned with the design, it is not used */
+        (void) Cy_CapSense_ProcessWidget(CY_CAPSENSE_BUTTON0_WDGT_ID, &cy_capsense_context);
+        (void) Cy_CapSense_ProcessWidget(CY_CAPSENSE_BUTTON1_WDGT_ID, &cy_capsense_context);
+        active = Cy_CapSense_IsWidgetActive(CY_CAPSENSE_BUTTON0_WDGT_ID, &cy_capsense_context) |
+                 Cy_CapSense_IsWidgetActive(CY_CAPSENSE_BUTTON1_WDGT_ID, &cy_capsense_context);
+
+        /* A click is a touch followed by the release, like the button SW2 */
+        clicked = ( (dfu_touchActive != 0u) && (active == 0u) ) ? 1u : 0u;
+        dfu_touchActive = active;
+
+        (void) Cy_CapSense_ScanAllWidgets(&cy_capsense_context);
+    }
+    return (clicked);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TouchStop
+****************************************************************************//**
+*
+* Lets the scan in progress end, then releases the CSD block. Called before a
+* switch to another application without a reset.
+*
+*******************************************************************************/
+void DFU_TouchStop(void)
+{
+    if (dfu_touchRunning != 0u)
+    {
+        while (Cy_CapSense_IsBusy(&cy_capsense_context) != CY_CAPSENSE_NOT_BUSY)
+        {
+            /* The CSD interrupt ends the scan */
+        }
+        NVIC_DisableIRQ(CYBSP_CSD_IRQ);
+        (void) Cy_CapSense_DeInit(&cy_capsense_context);
+        dfu_touchRunning = 0u;
+    }
+}
+#endif /* (DFU_BOOT_TOUCH != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,48 @@
+/***************************************************************************//**
+* \file dfu_touch.h
+* \version 1.0
+*
+* This file provides the API of the CapSense buttons of the App0 and App1 CM4
+* projects, used with DFU_BOOT_TOUCH in dfu_boot.h.
+*
+* The CSD block scans the widgets of the CapSense Configurator design in the
+* background: a scan is started without waiting, the CSD interrupt scans the
+* sensors one by one, and DFU_TouchClicked() processes the results once the
+* scan is done and starts the next one. The main loop never waits for the
+* CSD block, so the DFU transport keeps its throughput. The debounce is the
+* one of the widgets in the design.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_TOUCH_H)
+#define DFU_TOUCH_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+cy_en_dfu_status_t DFU_TouchStart(void);
+uint32_t DFU_TouchClicked(void);
+void DFU_TouchStop(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_TOUCH_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,182 @@
+/***************************************************************************//**
+* \file dfu_trace.c
+* \version 1.0
+*
+* This file provides the DFU trace, see dfu_trace.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_syslib.h"
+#include "dfu_boot.h"
+#include "dfu_trace.h"
+
+/* The commands of a row, the successful ones are not recorded */
+#define TRACE_CMD_SEND_DATA     (0x37u)
+#define TRACE_CMD_PROGRAM_DATA  (0x49u)
+
+/* No command is waiting for its response */
+#define TRACE_CMD_NONE          (0u)
+
+/* The status byte of a status code */
+#define TRACE_CODE(status)      ((uint16_t)((uint32_t)(status) & 0xFFFFu))
+
+#if (DFU_BOOT_TRACE != 0) && (CY_CPU_CORTEX_M4)
+
+/* The ring, shared between all the applications */
+CY_SECTION(".cy_boot_noinit.trace") __USED
+static dfu_trace_t dfu_trace;
+
+/* The command of the packet read, until its response */
+static uint32_t dfu_traceCmd = TRACE_CMD_NONE;
+
+
+/*******************************************************************************
+* Function Name: DFU_TraceInit
+****************************************************************************//**
+*
+* Clears the ring if it is not valid, then records the start of an
+* application with the reset reason.
+*
+* \param appId      The application starting.
+*
+*******************************************************************************/
+void DFU_TraceInit(uint32_t appId)
+{
+    if (dfu_trace.magic != DFU_TRACE_MAGIC)
+    {
+        (void) memset(&dfu_trace, 0, sizeof(dfu_trace));
+        dfu_trace.magic = DFU_TRACE_MAGIC;
+    }
+    dfu_traceCmd = TRACE_CMD_NONE;
+
+    DFU_TraceEvent(DFU_TRACE_START, appId, TRACE_CODE(Cy_SysLib_GetResetReason()));
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TraceEvent
+****************************************************************************//**
+*
+* Records an event over the oldest one, use DFU_TRACE().
+*
+* \param event      The type, DFU_TRACE_...
+* \param arg        The argument, the low 8 bits are kept.
+* \param code       The code, the low 16 bits are kept.
+*
+*******************************************************************************/
+void DFU_TraceEvent(uint32_t event, uint32_t arg, uint32_t code)
+{
+    dfu_trace_event_t *entry = &dfu_trace.events[dfu_trace.next & (DFU_TRACE_EVENTS - 1u)];
+
+    entry->time  = DFU_TraceTime();
+    entry->event = (uint8_t)event;
+    entry->arg   = (uint8_t)arg;
+    entry->code  = TRACE_CODE(code);
+    dfu_trace.next++;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TracePacket
+****************************************************************************//**
+*
+* Keeps the command of a packet the DFU SDK reads, recorded with the status
+* of its response, use DFU_TRACE_PACKET().
+*
+* \param cmd        The command.
+*
+*******************************************************************************/
+void DFU_TracePacket(uint32_t cmd)
+{
+    dfu_traceCmd = cmd;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TraceResponse
+****************************************************************************//**
+*
+* Records the command kept by DFU_TracePacket() with the status of its
+* response, use DFU_TRACE_RESPONSE(). The rows of a download are recorded
+* only when they fail, so they do not wipe the ring. The responses of the
+* custom commands have no command kept and are not recorded.
+*
+* \param status     The status of the response.
+*
+*******************************************************************************/
+void DFU_TraceResponse(uint32_t status)
+{
+    const uint32_t cmd = dfu_traceCmd;
+
+    dfu_traceCmd = TRACE_CMD_NONE;
+    if ( (cmd != TRACE_CMD_NONE)
+      && ( (status != 0u) || ((cmd != TRACE_CMD_SEND_DATA) && (cmd != TRACE_CMD_PROGRAM_DATA)) ) )
+    {
+        DFU_TraceEvent(DFU_TRACE_COMMAND, cmd, status);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TraceRead
+****************************************************************************//**
+*
+* Copies the events from a number on, from the oldest one the ring holds if
+* the number was overwritten or is not recorded yet.
+*
+* \param first      The number of the first event, returns the number of the
+*                   first event copied.
+* \param events     The events to fill.
+* \param max        The size of events.
+* \param next       Returns the number of the next event recorded.
+*
+* \return The number of events copied.
+*
+*******************************************************************************/
+uint32_t DFU_TraceRead(uint32_t *first, dfu_trace_event_t events[], uint32_t max, uint32_t *next)
+{
+    const uint32_t last = dfu_trace.next;
+    uint32_t count = 0u;
+
+    if ((last - *first) > DFU_TRACE_EVENTS)
+    {
+        /* Overwritten, or beyond the last one */
+        *first = (last > DFU_TRACE_EVENTS) ? (last - DFU_TRACE_EVENTS) : 0u;
+    }
+    while ( (count < max) && ((*first + count) != last) )
+    {
+        events[count] = dfu_trace.events[(*first + count) & (DFU_TRACE_EVENTS - 1u)];
+        count++;
+    }
+
+    *next = last;
+    return (count);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_TraceTime
+****************************************************************************//**
+*
+* Returns the time of the events, in milliseconds. dfu_timer.c returns the
+* time of its timebase, an application without it records the time 0.
+*
+* \return The time.
+*
+*******************************************************************************/
+__WEAK uint32_t DFU_TraceTime(void)
+{
+    return (0u);
+}
+
+#endif /* (DFU_BOOT_TRACE != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,128 @@
+/***************************************************************************//**
+* \file dfu_trace.h
+* \version 1.0
+*
+* This file provides the API of the DFU trace of the CM4 projects, used with
+* DFU_BOOT_TRACE in dfu_boot.h.
+*
+* The trace is a ring of the last DFU_TRACE_EVENTS events, 8 bytes each, in
+* the .cy_boot_noinit.trace section: at the same address in all the
+* applications, and not initialized at the start, so it survives the
+* software resets and the switches between App0 and App1. The magic number
+* tells it from the RAM content at power up, then the ring is cleared.
+*
+* An event has the time in milliseconds, from DFU_TraceTime(), its type, an
+* argument and a 16 bit code, see the DFU_TRACE_... types. A status code is
+* recorded as its low 16 bits, the status byte of the DFU packets. Recording
+* is a few stores, with no lock: the events are recorded from the main loop.
+*
+* Events are numbered from the start of the ring, DFU_TraceRead() returns
+* them from a number on. With 64 events the ring holds the numbers next - 64
+* to next - 1.
+*
+* Without DFU_BOOT_TRACE the macros compile to nothing.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_TRACE_H)
+#define DFU_TRACE_H
+
+#include "cy_syslib.h"
+#include "cy_dfu.h"
+#include "dfu_boot.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The events of the ring, a power of 2 */
+#define DFU_TRACE_EVENTS        (64u)
+
+/** The magic number of a valid ring */
+#define DFU_TRACE_MAGIC         (0x54524345u)
+
+/** An application starts: arg is the application, code the reset reason */
+#define DFU_TRACE_START         (1u)
+
+/** The DFU state changed: arg is the new state, code the status of Cy_DFU_Continue() */
+#define DFU_TRACE_STATE         (2u)
+
+/** A command of the DFU SDK was answered: arg is the command, code the status */
+#define DFU_TRACE_COMMAND       (3u)
+
+/** A timer fired: arg is DFU_TRACE_SESSION or DFU_TRACE_IDLE */
+#define DFU_TRACE_TIMEOUT       (4u)
+
+/** DFU restarts: arg is the state, code the status of the failure */
+#define DFU_TRACE_RESTART       (5u)
+
+/** App0 halts: arg is the state, code the status of the failure */
+#define DFU_TRACE_HALT          (6u)
+
+/** An application is started: arg is the application */
+#define DFU_TRACE_EXECUTE       (7u)
+
+/** The session timer, no command during a download */
+#define DFU_TRACE_SESSION       (0u)
+
+/** The idle timer, no image received */
+#define DFU_TRACE_IDLE          (1u)
+
+/** An event of the ring */
+typedef struct
+{
+    uint32_t time;      /**< The time, in milliseconds from DFU_TraceTime() */
+    uint8_t  event;     /**< The type, DFU_TRACE_... */
+    uint8_t  arg;       /**< The argument, see the type */
+    uint16_t code;      /**< The code, see the type */
+} dfu_trace_event_t;
+
+/** The ring, in the .cy_boot_noinit.trace section */
+typedef struct
+{
+    uint32_t magic;                                 /**< DFU_TRACE_MAGIC */
+    uint32_t next;                                  /**< The number of the next event */
+    dfu_trace_event_t events[DFU_TRACE_EVENTS];     /**< Event n is at n % DFU_TRACE_EVENTS */
+} dfu_trace_t;
+
+#if (DFU_BOOT_TRACE != 0) && (CY_CPU_CORTEX_M4)
+    /** Records an event */
+    #define DFU_TRACE(event, arg, code)     DFU_TraceEvent((event), (uint32_t)(arg), (uint32_t)(code))
+
+    /** Keeps the command of a packet for the DFU SDK, from its SOP */
+    #define DFU_TRACE_PACKET(packet)        DFU_TracePacket((packet)[1])
+
+    /** Records the command kept with its response status, from the SOP */
+    #define DFU_TRACE_RESPONSE(packet)      DFU_TraceResponse((packet)[1])
+#else
+    #define DFU_TRACE(event, arg, code)     ((void)(event), (void)(arg), (void)(code))
+    #define DFU_TRACE_PACKET(packet)        ((void)(packet))
+    #define DFU_TRACE_RESPONSE(packet)      ((void)(packet))
+#endif /* (DFU_BOOT_TRACE != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_TraceInit(uint32_t appId);
+void DFU_TraceEvent(uint32_t event, uint32_t arg, uint32_t code);
+void DFU_TracePacket(uint32_t cmd);
+void DFU_TraceResponse(uint32_t status);
+uint32_t DFU_TraceRead(uint32_t *first, dfu_trace_event_t events[], uint32_t max, uint32_t *next);
+uint32_t DFU_TraceTime(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_TRACE_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,264 @@
+/***************************************************************************//**
+* \file dfu_wear.c
+* \version 1.0
+*
+* This file provides the flash wear counters, see dfu_wear.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_syslib.h"
+#include "dfu_boot.h"
+#include "dfu_wear.h"
+#include "flash_log.h"
+
+#if (DFU_BOOT_WEAR != 0) && (CY_CPU_CORTEX_M4)
+
+/* The log of the counters and the regions, defined in the linker scripts */
+extern uint8_t __cy_boot_wear_addr;
+extern uint8_t __cy_boot_wear_length;
+extern uint8_t __cy_wear_app1_core0_start;
+extern uint8_t __cy_wear_app1_core0_length;
+extern uint8_t __cy_wear_app1_core1_start;
+extern uint8_t __cy_wear_app1_core1_length;
+extern uint8_t __cy_wear_app2_core0_start;
+extern uint8_t __cy_wear_app2_core0_length;
+extern uint8_t __cy_wear_app2_core1_start;
+extern uint8_t __cy_wear_app2_core1_length;
+extern uint8_t __cy_wear_metadata_start;
+extern uint8_t __cy_wear_metadata_length;
+extern uint8_t __cy_memory_1_start;
+extern uint8_t __cy_memory_1_length;
+
+/* A region of the counters */
+typedef struct
+{
+    uint32_t startAddress;  /* The first address of the region */
+    uint32_t length;        /* The size of the region */
+} dfu_wear_region_t;
+
+/* The regions, in the order of the DFU_WEAR_... numbers, DFU_WEAR_OTHER is the rest */
+static const dfu_wear_region_t dfu_wearRegions[DFU_WEAR_OTHER] =
+{
+    { (uint32_t)&__cy_wear_app1_core0_start, (uint32_t)&__cy_wear_app1_core0_length },
+    { (uint32_t)&__cy_wear_app1_core1_start, (uint32_t)&__cy_wear_app1_core1_length },
+    { (uint32_t)&__cy_wear_app2_core0_start, (uint32_t)&__cy_wear_app2_core0_length },
+    { (uint32_t)&__cy_wear_app2_core1_start, (uint32_t)&__cy_wear_app2_core1_length },
+    { (uint32_t)&__cy_wear_metadata_start,   (uint32_t)&__cy_wear_metadata_length   },
+    { (uint32_t)&__cy_memory_1_start,        (uint32_t)&__cy_memory_1_length        },
+};
+
+/* The counters, the record of the log */
+static dfu_wear_counters_t dfu_wearCounters[DFU_WEAR_REGIONS];
+
+/* The records committed */
+static uint32_t dfu_wearCommits = 0u;
+
+/* The counters changed since the last commit */
+static uint32_t dfu_wearDirty = 0u;
+
+static void GetWearLog(flash_log_t *log);
+static uint32_t GetRegion(uint32_t address);
+
+
+/*******************************************************************************
+* Function Name: GetWearLog
+****************************************************************************//**
+*
+* This internal function returns the flash log of the counters.
+*
+*******************************************************************************/
+static void GetWearLog(flash_log_t *log)
+{
+    log->address = (uint32_t)&__cy_boot_wear_addr;
+    log->rows    = (uint32_t)&__cy_boot_wear_length / CY_FLASH_SIZEOF_ROW;
+}
+
+
+/*******************************************************************************
+* Function Name: GetRegion
+****************************************************************************//**
+*
+* This internal function finds the region of a row.
+*
+* \param address    The row address.
+*
+* \return The region, DFU_WEAR_OTHER if no region holds the row, or
+*         DFU_WEAR_REGIONS for the rows of the log of the counters, they are
+*         not counted.
+*
+*******************************************************************************/
+static uint32_t GetRegion(uint32_t address)
+{
+    uint32_t region = DFU_WEAR_OTHER;
+    uint32_t idx;
+
+    if ((address - (uint32_t)&__cy_boot_wear_addr) < (uint32_t)&__cy_boot_wear_length)
+    {
+        region = DFU_WEAR_REGIONS;
+    }
+    for (idx = 0u; (idx < DFU_WEAR_OTHER) && (region == DFU_WEAR_OTHER); ++idx)
+    {
+        if ((address - dfu_wearRegions[idx].startAddress) < dfu_wearRegions[idx].length)
+        {
+            region = idx;
+        }
+    }
+    return (region);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_WearInit
+****************************************************************************//**
+*
+* Reads the counters committed and starts the DWT cycle counter. Called at
+* the start, before the first row write to count.
+*
+* \param params     The pointer to a DFU parameters structure, used for
+*                   the checksum.
+*
+*******************************************************************************/
+void DFU_WearInit(cy_stc_dfu_params_t *params)
+{
+    flash_log_t log;
+
+    GetWearLog(&log);
+    if (FlashLog_Read(&log, dfu_wearCounters, sizeof(dfu_wearCounters), &dfu_wearCommits, params) != CY_DFU_SUCCESS)
+    {
+        (void) memset(dfu_wearCounters, 0, sizeof(dfu_wearCounters));
+        dfu_wearCommits = 0u;
+    }
+    dfu_wearDirty = 0u;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_WearRow
+****************************************************************************//**
+*
+* Counts a row write, use DFU_WEAR_ROW().
+*
+* \param address    The row address.
+* \param erase      Non-zero for an erase request.
+* \param failed     Non-zero if the write failed.
+* \param cycles     The duration of the write, in CPU cycles.
+*
+*******************************************************************************/
+void DFU_WearRow(uint32_t address, uint32_t erase, uint32_t failed, uint32_t cycles)
+{
+    const uint32_t region = GetRegion(address);
+    uint32_t cyclesPerUs = SystemCoreClock / 1000000u;
+
+    if (region < DFU_WEAR_REGIONS)
+    {
+        dfu_wear_counters_t *counters = &dfu_wearCounters[region];
+
+        counters->writes++;
+        counters->erases   += (erase != 0u) ? 1u : 0u;
+        counters->failures += (failed != 0u) ? 1u : 0u;
+        counters->busyUs   += cycles / ((cyclesPerUs != 0u) ? cyclesPerUs : 1u);
+        dfu_wearDirty = 1u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_WearSkip
+****************************************************************************//**
+*
+* Counts a row a compare found unchanged, so not written, use DFU_WEAR_SKIP().
+*
+* \param address    The row address.
+*
+*******************************************************************************/
+void DFU_WearSkip(uint32_t address)
+{
+    const uint32_t region = GetRegion(address);
+
+    if (region < DFU_WEAR_REGIONS)
+    {
+        dfu_wearCounters[region].skipped++;
+        dfu_wearDirty = 1u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_WearCommit
+****************************************************************************//**
+*
+* Appends the counters to their log if they changed since the last commit.
+* Called when no download is in progress: the data buffer is used. A commit
+* that fails is not tried again before the counters change.
+*
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer is used to write the row.
+*
+* \return
+* - CY_DFU_SUCCESS when the counters are committed, or did not change.
+* - CY_DFU_ERROR_DATA if the flash write fails.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_WearCommit(cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+
+    if (dfu_wearDirty != 0u)
+    {
+        flash_log_t log;
+
+        dfu_wearDirty = 0u;
+        GetWearLog(&log);
+        status = FlashLog_Append(&log, dfu_wearCounters, sizeof(dfu_wearCounters), params);
+        if (status == CY_DFU_SUCCESS)
+        {
+            dfu_wearCommits++;
+        }
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: DFU_WearGet
+****************************************************************************//**
+*
+* Returns the counters of a region, with the counts not committed yet.
+*
+* \param region     The region, DFU_WEAR_...
+* \param counters   The pointer to the counters to fill.
+* \param commits    The pointer to a variable where the number of commits
+*                   is stored.
+*
+* \return
+* - CY_DFU_SUCCESS when the counters are returned.
+* - CY_DFU_ERROR_DATA if the region is not valid.
+*
+*******************************************************************************/
+cy_en_dfu_status_t DFU_WearGet(uint32_t region, dfu_wear_counters_t *counters, uint32_t *commits)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_DATA;
+
+    if (region < DFU_WEAR_REGIONS)
+    {
+        *counters = dfu_wearCounters[region];
+        *commits  = dfu_wearCommits;
+        status = CY_DFU_SUCCESS;
+    }
+    return (status);
+}
+
+#endif /* (DFU_BOOT_WEAR != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/* [] END OF FILE */
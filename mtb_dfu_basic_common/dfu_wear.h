@@ -0,0 +1,111 @@
+/***************************************************************************//**
+* \file dfu_wear.h
+* \version 1.0
+*
+* This file provides the API of the flash wear counters of the CM4 projects,
+* used with DFU_BOOT_WEAR in dfu_boot.h.
+*
+* Each flash region has counters of the row writes, the erase requests among
+* them, the rows a compare found unchanged and not written, and the flash busy
+* time of the writes. A row write erases and programs the row, so the writes
+* are the wear of the region. The writes of App0 and App1 CM4 are counted:
+* the DFU downloads, the copy engine of dfu_qspi.c, the logical EEPROM
+* journal and the flash_log.h records, except the log of the counters.
+*
+* The write path only adds to the counters in RAM: DFU_WEAR_BEGIN() reads
+* the DWT cycle counter, DFU_WEAR_ROW() adds the row to its region. The
+* counters are committed to the flash_boot_wear rows with DFU_WearCommit(),
+* a flash_log.h record, once a download ends or before an application
+* starts, so the counts since the last commit are lost with a reset.
+*
+* Without DFU_BOOT_WEAR the macros compile to nothing.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(DFU_WEAR_H)
+#define DFU_WEAR_H
+
+#include "cy_syslib.h"
+#include "cy_dfu.h"
+#include "dfu_boot.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The CM0+ part of the App1 slot */
+#define DFU_WEAR_APP1_CORE0     (0u)
+
+/** The CM4 part of the App1 slot */
+#define DFU_WEAR_APP1_CORE1     (1u)
+
+/** The CM0+ part of the App2 slot */
+#define DFU_WEAR_APP2_CORE0     (2u)
+
+/** The CM4 part of the App2 slot */
+#define DFU_WEAR_APP2_CORE1     (3u)
+
+/** The metadata row, the log of its copies and the boot control rows */
+#define DFU_WEAR_METADATA       (4u)
+
+/** The Emulated EEPROM flash */
+#define DFU_WEAR_EEPROM         (5u)
+
+/** The other rows, e.g. the settings and the SFlash user rows */
+#define DFU_WEAR_OTHER          (6u)
+
+/** The number of regions */
+#define DFU_WEAR_REGIONS        (7u)
+
+/** The counters of a region, as returned by DFU_CMD_WEAR */
+typedef struct
+{
+    uint32_t writes;        /**< The row writes, each erases and programs the row */
+    uint32_t erases;        /**< The writes of the erase requests */
+    uint32_t skipped;       /**< The rows not written, they held the data already */
+    uint32_t failures;      /**< The writes that failed */
+    uint64_t busyUs;        /**< The flash busy time of the writes, in microseconds */
+} dfu_wear_counters_t;
+
+#if (DFU_BOOT_WEAR != 0) && (CY_CPU_CORTEX_M4)
+    /** Returns the start of a row write */
+    #define DFU_WEAR_BEGIN()                            (DWT->CYCCNT)
+
+    /** Counts a row write, erase is non-zero for an erase request */
+    #define DFU_WEAR_ROW(address, erase, failed, start) \
+        DFU_WearRow((address), (erase), (failed), DWT->CYCCNT - (start))
+
+    /** Counts a row not written, it held the data */
+    #define DFU_WEAR_SKIP(address)                      DFU_WearSkip(address)
+#else
+    #define DFU_WEAR_BEGIN()                            (0u)
+    #define DFU_WEAR_ROW(address, erase, failed, start) \
+        ((void)(address), (void)(erase), (void)(failed), (void)(start))
+    #define DFU_WEAR_SKIP(address)                      ((void)(address))
+#endif /* (DFU_BOOT_WEAR != 0) && (CY_CPU_CORTEX_M4) */
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void DFU_WearInit(cy_stc_dfu_params_t *params);
+void DFU_WearRow(uint32_t address, uint32_t erase, uint32_t failed, uint32_t cycles);
+void DFU_WearSkip(uint32_t address);
+cy_en_dfu_status_t DFU_WearCommit(cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t DFU_WearGet(uint32_t region, dfu_wear_counters_t *counters, uint32_t *commits);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(DFU_WEAR_H) */
+
+
+/* [] END OF FILE */
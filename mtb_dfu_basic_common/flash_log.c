@@ -0,0 +1,220 @@
+/***************************************************************************//**
+* \file flash_log.c
+* \version 1.0
+*
+* This file provides a power-fail safe record store in flash, see flash_log.h.
+*
+* The row layout, in bytes:
+* - 0..3   FLASH_LOG_MAGIC
+* - 4..7   The checksum of the bytes from offset 8 to the end of the record
+* - 8..11  The sequence number, incremented on every append
+* - 12..15 The record size
+* - 16..   The record, the rest of the row is zero
+*
+* The checksum is the DFU SDK one, Cy_DFU_DataChecksum().
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <string.h>
+#include "cy_syslib.h"
+#include "cy_flash.h"
+#include "flash_log.h"
+#include "dfu_wear.h"
+
+/* The row header fields, in 32-bit words */
+#define HEADER_MAGIC_IDX    (0u)
+#define HEADER_CRC_IDX      (1u)
+#define HEADER_SEQ_IDX      (2u)
+#define HEADER_SIZE_IDX     (3u)
+
+/* The offset of the checksummed part of a row */
+#define CRC_START           (8u)
+
+
+static uint32_t IsRowValid(uint32_t address, cy_stc_dfu_params_t *params);
+static uint32_t FindLatest(const flash_log_t *log, uint32_t *index, cy_stc_dfu_params_t *params);
+
+
+/*******************************************************************************
+* Function Name: IsRowValid
+****************************************************************************//**
+*
+* This internal function checks the header and the checksum of a row.
+*
+* \param address    The row address.
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return 1 - the row holds a valid record, else 0
+*
+*******************************************************************************/
+static uint32_t IsRowValid(uint32_t address, cy_stc_dfu_params_t *params)
+{
+    const uint32_t *header = (const uint32_t *)address;
+    uint32_t valid = 0u;
+
+    if ( (header[HEADER_MAGIC_IDX] == FLASH_LOG_MAGIC) && (header[HEADER_SIZE_IDX] <= FLASH_LOG_MAX_RECORD) )
+    {
+        uint32_t crc = Cy_DFU_DataChecksum((const uint8_t *)(address + CRC_START),
+                                           (FLASH_LOG_HEADER_SIZE - CRC_START) + header[HEADER_SIZE_IDX], params);
+        valid = (crc == header[HEADER_CRC_IDX]) ? 1u : 0u;
+    }
+    return (valid);
+}
+
+
+/*******************************************************************************
+* Function Name: FindLatest
+****************************************************************************//**
+*
+* This internal function finds the valid row with the highest sequence number.
+*
+* \param log        The log.
+* \param index      The pointer to a variable where the row index is stored.
+* \param params     The pointer to a DFU parameters structure.
+*
+* \return 1 - a valid row is found, else 0
+*
+*******************************************************************************/
+static uint32_t FindLatest(const flash_log_t *log, uint32_t *index, cy_stc_dfu_params_t *params)
+{
+    uint32_t found = 0u;
+    uint32_t latestSeq = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < log->rows; ++idx)
+    {
+        uint32_t address = log->address + (idx * CY_FLASH_SIZEOF_ROW);
+
+        if (IsRowValid(address, params) != 0u)
+        {
+            uint32_t seq = ((const uint32_t *)address)[HEADER_SEQ_IDX];
+
+            /* Wrap-around safe comparison */
+            if ( (found == 0u) || ((int32_t)(seq - latestSeq) > 0) )
+            {
+                latestSeq = seq;
+                *index = idx;
+                found = 1u;
+            }
+        }
+    }
+    return (found);
+}
+
+
+/*******************************************************************************
+* Function Name: FlashLog_Read
+****************************************************************************//**
+*
+* Reads the latest valid record of a log.
+*
+* \param log        The log.
+* \param record     The buffer to read the record into. If the stored record is
+*                   shorter than size, the rest of the buffer is zeroed.
+* \param size       The size of the buffer.
+* \param seq        The pointer to a variable where the sequence number of the
+*                   record is stored. May be NULL.
+* \param params     The pointer to a DFU parameters structure, used for
+*                   the checksum.
+*
+* \return
+* - CY_DFU_SUCCESS when a record is read.
+* - CY_DFU_ERROR_VERIFY if the log holds no valid record.
+*
+*******************************************************************************/
+cy_en_dfu_status_t FlashLog_Read(const flash_log_t *log, void *record, uint32_t size,
+                                 uint32_t *seq, cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_ERROR_VERIFY;
+    uint32_t index;
+
+    if (FindLatest(log, &index, params) != 0u)
+    {
+        uint32_t address = log->address + (index * CY_FLASH_SIZEOF_ROW);
+        const uint32_t *header = (const uint32_t *)address;
+        uint32_t stored = header[HEADER_SIZE_IDX];
+        uint32_t length = (stored < size) ? stored : size;
+
+        (void) memcpy(record, (const void *)(address + FLASH_LOG_HEADER_SIZE), length);
+        (void) memset((uint8_t *)record + length, 0, size - length);
+        if (seq != NULL)
+        {
+            *seq = header[HEADER_SEQ_IDX];
+        }
+        status = CY_DFU_SUCCESS;
+    }
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: FlashLog_Append
+****************************************************************************//**
+*
+* Writes a record to the row after the latest valid one, with the next
+* sequence number. The latest record is not touched, so it is still read if
+* this write is interrupted.
+*
+* \param log        The log.
+* \param record     The record to write.
+* \param size       The record size, up to FLASH_LOG_MAX_RECORD bytes.
+* \param params     The pointer to a DFU parameters structure, its
+*                   dataBuffer is used to prepare the row.
+*
+* \return
+* - CY_DFU_SUCCESS when the record is written.
+* - CY_DFU_ERROR_LENGTH if the record is too long.
+* - CY_DFU_ERROR_DATA if the flash write fails.
+*
+*******************************************************************************/
+cy_en_dfu_status_t FlashLog_Append(const flash_log_t *log, const void *record, uint32_t size,
+                                   cy_stc_dfu_params_t *params)
+{
+    cy_en_dfu_status_t status = CY_DFU_SUCCESS;
+    uint32_t *row = (uint32_t *)params->dataBuffer;
+    uint32_t index = 0u;
+    uint32_t seq = 1u;
+
+    if (size > FLASH_LOG_MAX_RECORD)
+    {
+        status = CY_DFU_ERROR_LENGTH;
+    }
+
+    if (status == CY_DFU_SUCCESS)
+    {
+        if (FindLatest(log, &index, params) != 0u)
+        {
+            seq = ((const uint32_t *)(log->address + (index * CY_FLASH_SIZEOF_ROW)))[HEADER_SEQ_IDX] + 1u;
+            index = (index + 1u) % log->rows;
+        }
+
+        (void) memset(row, 0, CY_FLASH_SIZEOF_ROW);
+        (void) memcpy(&params->dataBuffer[FLASH_LOG_HEADER_SIZE], record, size);
+        row[HEADER_MAGIC_IDX] = FLASH_LOG_MAGIC;
+        row[HEADER_SEQ_IDX]   = seq;
+        row[HEADER_SIZE_IDX]  = size;
+        row[HEADER_CRC_IDX]   = Cy_DFU_DataChecksum(&params->dataBuffer[CRC_START],
+                                                    (FLASH_LOG_HEADER_SIZE - CRC_START) + size, params);
+
+        {
+            uint32_t address = log->address + (index * CY_FLASH_SIZEOF_ROW);
+            const uint32_t start = DFU_WEAR_BEGIN();
+            cy_en_flashdrv_status_t fstatus = Cy_Flash_WriteRow(address, row);
+
+            status = ( (fstatus == CY_FLASH_DRV_SUCCESS)
+                    && (memcmp(row, (const void *)address, CY_FLASH_SIZEOF_ROW) == 0) )
+                     ? CY_DFU_SUCCESS : CY_DFU_ERROR_DATA;
+            DFU_WEAR_ROW(address, 0u, (status != CY_DFU_SUCCESS) ? 1u : 0u, start);
+        }
+    }
+    return (status);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/***************************************************************************//**
+* \file flash_log.h
+* \version 1.0
+*
+* This file provides the API of a power-fail safe record store in flash.
+*
+* A log is a range of flash rows, used as a ring. Each append writes the
+* whole record to the row after the latest one, with a header holding a
+* sequence number and a checksum. A read returns the valid record with the
+* highest sequence number, so a write interrupted by a reset leaves the
+* previous record in place.
+*
+* Records shorter than the reader expects are zero-extended, so fields can
+* be added at the end of a record type without invalidating stored records.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(FLASH_LOG_H)
+#define FLASH_LOG_H
+
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The row header tag */
+#define FLASH_LOG_MAGIC            (0x474F4C46u)
+
+/** The size of the row header: tag, checksum, sequence number and record size */
+#define FLASH_LOG_HEADER_SIZE      (16u)
+
+/** The largest record, in bytes */
+#define FLASH_LOG_MAX_RECORD       (CY_FLASH_SIZEOF_ROW - FLASH_LOG_HEADER_SIZE)
+
+
+/** A log: a range of flash rows */
+typedef struct
+{
+    uint32_t address;   /**< The address of the first row, row aligned */
+    uint32_t rows;      /**< The number of rows, at least 2 */
+} flash_log_t;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+cy_en_dfu_status_t FlashLog_Read(const flash_log_t *log, void *record, uint32_t size,
+                                 uint32_t *seq, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t FlashLog_Append(const flash_log_t *log, const void *record, uint32_t size,
+                                   cy_stc_dfu_params_t *params);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(FLASH_LOG_H) */
+
+
+/* [] END OF FILE */
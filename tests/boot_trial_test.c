@@ -0,0 +1,366 @@
+/***************************************************************************//**
+* \file boot_trial_test.c
+* \version 1.0
+*
+* This file provides the host test of the trial boot, see dfu_boot.h: the
+* common dfu_boot.c and flash_log.c run against the emulated flash, WDT and
+* resets of host/emu.c.
+*
+* Boot() is App0 after a reset: the CM0+ fast path selects the slot with no
+* buffer, App0 CM4 with one if the fast path started nothing. RunApp() is
+* the application started: CM0+ resumes the trial, CM4 confirms it or hangs
+* until the WDT resets the device. The RAM of dfu_boot.c is not cleared by
+* the emulated resets, each boot selects the slot again as App0 does.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "emu.h"
+#include "dfu_boot.h"
+
+/* The reserved rows of the linker scripts */
+#define SETTINGS_ADDR       (0x100C0000u)
+#define WEAR_ADDR           (0x100FE600u)
+#define MD_LOG_ADDR         (0x100FEE00u)
+#define BOOT_CTL_ADDR       (0x100FF600u)
+
+/* Checks a condition, the test goes on */
+#define CHECK(cond)         Check((cond), #cond, __LINE__)
+
+static uint32_t failures = 0u;
+static uint32_t checks = 0u;
+
+static uint8_t dataBuffer[CY_DFU_SIZEOF_DATA_BUFFER];
+
+/* App0 CM4 and the applications write the record with a buffer */
+static cy_stc_dfu_params_t params = { 0u, dataBuffer, NULL };
+
+/* The App0 CM0+ fast path has no buffer */
+static cy_stc_dfu_params_t fastParams = { 0u, NULL, NULL };
+
+
+static void Check(int cond, const char *text, int line)
+{
+    ++checks;
+    if (!cond)
+    {
+        ++failures;
+        (void) printf("  FAIL line %d: %s\n", line, text);
+    }
+}
+
+
+/* App0 after a reset, returns the slot started, 0 if it stays in App0 */
+static uint32_t Boot(uint32_t reason)
+{
+    uint32_t app;
+
+    emu.resetReason = reason;
+    emu.runningApp  = 0u;
+    /* The CM0+ startup code disables the WDT */
+    emu.wdtEnabled  = 0u;
+
+    app = DFU_BootSelectApp(&fastParams);
+    if (app != 0u)
+    {
+        DFU_BootSwitchToApp(app);
+    }
+    else
+    {
+        app = DFU_BootSelectApp(&params);
+        if (app != 0u)
+        {
+            DFU_BootExecuteApp(app);
+        }
+    }
+    return (app);
+}
+
+
+/* The application started, confirms it runs or hangs */
+static void RunApp(uint32_t confirms)
+{
+    /* The CM0+ startup code of the application disables the WDT */
+    emu.wdtEnabled = 0u;
+    DFU_BootTrialResume();
+    if (confirms != 0u)
+    {
+        CHECK(DFU_BootConfirm(&params) == CY_DFU_SUCCESS);
+    }
+}
+
+
+/* The reset after the application ran: the WDT one while it runs, else a power cycle */
+static uint32_t NextReset(void)
+{
+    return ( (emu.wdtEnabled != 0u) ? CY_SYSLIB_RESET_HWWDT : 0u );
+}
+
+
+/* Downloads a slot and makes it active, as App0 or the App1 updater */
+static void Update(uint32_t app)
+{
+    emu.valid[app] = 1u;
+    CHECK(DFU_BootActivate(app, &params) == CY_DFU_SUCCESS);
+}
+
+
+/* Reads the record, returns its fields as 0xAAPPSS */
+static uint32_t Record(void)
+{
+    dfu_boot_ctl_t ctl;
+
+    (void) DFU_BootCtlRead(&ctl, &params);
+    return ( ((uint32_t)ctl.activeApp << 16u) | ((uint32_t)ctl.previousApp << 8u) | ctl.state );
+}
+
+
+/* A device with App1, confirmed */
+static void Start(void)
+{
+    Emu_Init();
+    emu.valid[1] = 1u;
+    CHECK(Boot(0u) == 1u);
+    RunApp(1u);
+}
+
+
+static void TestFirstBoot(void)
+{
+    Start();
+    CHECK(emu.runningApp == 1u);
+    CHECK(emu.wdtEnabled == 0u);
+    /* No record, nothing to confirm */
+    CHECK(emu.writes == 0u);
+    CHECK(Record() == 0x010000u);
+}
+
+
+static void TestConfirm(void)
+{
+    Start();
+    Update(2u);
+    CHECK(Record() == 0x020101u);
+
+    CHECK(Boot(0u) == 2u);
+    CHECK(emu.wdtEnabled == 1u);
+    RunApp(1u);
+    CHECK(emu.wdtEnabled == 0u);
+    CHECK(Record() == 0x020100u);
+
+    /* A confirmed slot is not armed again */
+    CHECK(Boot(NextReset()) == 2u);
+    RunApp(0u);
+    CHECK(emu.wdtEnabled == 0u);
+}
+
+
+static void TestRollback(void)
+{
+    Start();
+    Update(2u);
+    CHECK(Boot(0u) == 2u);
+    RunApp(0u);
+    CHECK(NextReset() == CY_SYSLIB_RESET_HWWDT);
+
+    CHECK(Boot(NextReset()) == 1u);
+    CHECK(emu.runningApp == 1u);
+    CHECK(Record() == 0x010000u);
+    RunApp(0u);
+    CHECK(emu.wdtEnabled == 0u);
+
+    /* The failed slot is not a fallback, even if valid */
+    CHECK(Boot(0u) == 1u);
+}
+
+
+static void TestFastPathLeavesRollback(void)
+{
+    uint32_t writes;
+
+    Start();
+    Update(2u);
+    CHECK(Boot(0u) == 2u);
+    RunApp(0u);
+
+    emu.resetReason = CY_SYSLIB_RESET_HWWDT;
+    writes = emu.writes;
+    CHECK(DFU_BootSelectApp(&fastParams) == 0u);
+    CHECK(emu.writes == writes);
+    CHECK(Record() == 0x020101u);
+}
+
+
+static void TestInvalidActive(void)
+{
+    Start();
+    Update(2u);
+    emu.valid[2] = 0u;
+
+    /* The previous slot starts, not on trial */
+    CHECK(Boot(0u) == 1u);
+    CHECK(emu.wdtEnabled == 0u);
+    RunApp(0u);
+    CHECK(emu.wdtEnabled == 0u);
+    CHECK(Record() == 0x020101u);
+}
+
+
+static void TestPowerFailActivate(void)
+{
+    Start();
+    Update(2u);
+    CHECK(Boot(0u) == 2u);
+    RunApp(1u);
+
+    emu.failWrite = emu.writes + 1u;
+    if (setjmp(emu.reset) == 0)
+    {
+        (void) DFU_BootActivate(1u, &params);
+        CHECK(0 && "the power is lost");
+    }
+    /* The former record is kept */
+    CHECK(Record() == 0x020100u);
+    CHECK(Boot(0u) == 2u);
+    CHECK(emu.wdtEnabled == 0u);
+
+    Update(1u);
+    CHECK(Record() == 0x010201u);
+}
+
+
+static void TestPowerFailConfirm(void)
+{
+    Start();
+    Update(2u);
+    CHECK(Boot(0u) == 2u);
+
+    emu.failWrite = emu.writes + 1u;
+    if (setjmp(emu.reset) == 0)
+    {
+        RunApp(1u);
+        CHECK(0 && "the power is lost");
+    }
+    /* Still on trial, armed again at the next boot */
+    CHECK(Record() == 0x020101u);
+    CHECK(Boot(0u) == 2u);
+    CHECK(emu.wdtEnabled == 1u);
+    RunApp(1u);
+    CHECK(Record() == 0x020100u);
+}
+
+
+static void TestPowerFailRollback(void)
+{
+    Start();
+    Update(2u);
+    CHECK(Boot(0u) == 2u);
+    RunApp(0u);
+
+    emu.failWrite = emu.writes + 1u;
+    if (setjmp(emu.reset) == 0)
+    {
+        (void) Boot(NextReset());
+        CHECK(0 && "the power is lost");
+    }
+    /* The slot gets another trial after the power cycle, then rolls back */
+    CHECK(Record() == 0x020101u);
+    CHECK(Boot(0u) == 2u);
+    RunApp(0u);
+    CHECK(Boot(NextReset()) == 1u);
+    CHECK(Record() == 0x010000u);
+}
+
+
+static void TestCheckWrite(void)
+{
+    Start();
+    CHECK(Boot(0u) == 1u);
+
+    /* The slot started, the reserved rows */
+    CHECK(DFU_BootCheckWrite(CY_DFU_APP1_VERIFY_START) == CY_DFU_ERROR_ADDRESS);
+    CHECK(DFU_BootCheckWrite(CY_DFU_APP1_VERIFY_START + CY_DFU_APP1_VERIFY_LENGTH) == CY_DFU_ERROR_ADDRESS);
+    CHECK(DFU_BootCheckWrite(BOOT_CTL_ADDR) == CY_DFU_ERROR_ADDRESS);
+    CHECK(DFU_BootCheckWrite(BOOT_CTL_ADDR + CY_FLASH_SIZEOF_ROW) == CY_DFU_ERROR_ADDRESS);
+    CHECK(DFU_BootCheckWrite(SETTINGS_ADDR) == CY_DFU_ERROR_ADDRESS);
+    CHECK(DFU_BootCheckWrite(WEAR_ADDR) == CY_DFU_ERROR_ADDRESS);
+    CHECK(DFU_BootCheckWrite(MD_LOG_ADDR) == CY_DFU_ERROR_ADDRESS);
+    CHECK(DFU_BootWrittenApp() == 0u);
+
+    /* The other slot */
+    CHECK(DFU_BootCheckWrite(CY_DFU_APP2_VERIFY_START) == CY_DFU_SUCCESS);
+    CHECK(DFU_BootWrittenApp() == 2u);
+}
+
+
+static void TestRingWrap(void)
+{
+    uint32_t app = 1u;
+    uint32_t idx;
+
+    Start();
+    for (idx = 0u; idx < 10u; ++idx)
+    {
+        const uint32_t next = 3u - app;
+
+        Update(next);
+        CHECK(Boot(0u) == next);
+        if ((idx % 3u) == 2u)
+        {
+            /* Fails its trial */
+            RunApp(0u);
+            CHECK(Boot(NextReset()) == app);
+            CHECK(Record() == (app << 16u));
+            RunApp(1u);
+        }
+        else
+        {
+            RunApp(1u);
+            CHECK(Record() == ((next << 16u) | (app << 8u)));
+            app = next;
+        }
+    }
+}
+
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        void (*run)(void);
+    } tests[] =
+    {
+        { "first boot",                   &TestFirstBoot },
+        { "confirm",                      &TestConfirm },
+        { "rollback",                     &TestRollback },
+        { "fast path leaves rollback",    &TestFastPathLeavesRollback },
+        { "invalid active slot",          &TestInvalidActive },
+        { "power fail in activate",       &TestPowerFailActivate },
+        { "power fail in confirm",        &TestPowerFailConfirm },
+        { "power fail in rollback",       &TestPowerFailRollback },
+        { "check write",                  &TestCheckWrite },
+        { "ring wrap",                    &TestRingWrap },
+    };
+    uint32_t idx;
+
+    for (idx = 0u; idx < (sizeof(tests) / sizeof(tests[0])); ++idx)
+    {
+        const uint32_t before = failures;
+
+        tests[idx].run();
+        (void) printf("%s %s\n", (failures == before) ? "PASS" : "FAIL", tests[idx].name);
+    }
+    (void) printf("%u checks, %u failures\n", (unsigned)checks, (unsigned)failures);
+    return ( (failures == 0u) ? 0 : 1 );
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,121 @@
+/***************************************************************************//**
+* \file decrypt_test.c
+* \version 1.0
+*
+* This file provides the host test of the software AES-128 CTR decryption of
+* App0 CM4, dfu_decrypt.c, with the SP800-38A F.5.1 vector, and measures its
+* throughput on the host per 512-byte row.
+*
+* The Makefile builds dfu_decrypt.c with the SP800-38A test key as
+* DFU_DECRYPT_KEY, only for this test.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "dfu_decrypt.h"
+
+/* The rows decrypted for the throughput */
+#define BENCH_ROWS          (20000u)
+
+/* Checks a condition, the test goes on */
+#define CHECK(cond)         Check((cond), #cond, __LINE__)
+
+static uint32_t failures = 0u;
+static uint32_t checks = 0u;
+
+/* SP800-38A F.5.1 CTR-AES128.Encrypt: the initial counter block */
+static const uint8_t eiv[DFU_DECRYPT_EIV_SIZE] =
+{
+    0xF0u, 0xF1u, 0xF2u, 0xF3u, 0xF4u, 0xF5u, 0xF6u, 0xF7u,
+    0xF8u, 0xF9u, 0xFAu, 0xFBu, 0xFCu, 0xFDu, 0xFEu, 0xFFu
+};
+
+/* The plaintext */
+static const uint8_t plain[64] =
+{
+    0x6Bu, 0xC1u, 0xBEu, 0xE2u, 0x2Eu, 0x40u, 0x9Fu, 0x96u, 0xE9u, 0x3Du, 0x7Eu, 0x11u, 0x73u, 0x93u, 0x17u, 0x2Au,
+    0xAEu, 0x2Du, 0x8Au, 0x57u, 0x1Eu, 0x03u, 0xACu, 0x9Cu, 0x9Eu, 0xB7u, 0x6Fu, 0xACu, 0x45u, 0xAFu, 0x8Eu, 0x51u,
+    0x30u, 0xC8u, 0x1Cu, 0x46u, 0xA3u, 0x5Cu, 0xE4u, 0x11u, 0xE5u, 0xFBu, 0xC1u, 0x19u, 0x1Au, 0x0Au, 0x52u, 0xEFu,
+    0xF6u, 0x9Fu, 0x24u, 0x45u, 0xDFu, 0x4Fu, 0x9Bu, 0x17u, 0xADu, 0x2Bu, 0x41u, 0x7Bu, 0xE6u, 0x6Cu, 0x37u, 0x10u
+};
+
+/* The ciphertext */
+static const uint8_t cipher[64] =
+{
+    0x87u, 0x4Du, 0x61u, 0x91u, 0xB6u, 0x20u, 0xE3u, 0x26u, 0x1Bu, 0xEFu, 0x68u, 0x64u, 0x99u, 0x0Du, 0xB6u, 0xCEu,
+    0x98u, 0x06u, 0xF6u, 0x6Bu, 0x79u, 0x70u, 0xFDu, 0xFFu, 0x86u, 0x17u, 0x18u, 0x7Bu, 0xB9u, 0xFFu, 0xFDu, 0xFFu,
+    0x5Au, 0xE4u, 0xDFu, 0x3Eu, 0xDBu, 0xD5u, 0xD3u, 0x5Eu, 0x5Bu, 0x4Fu, 0x09u, 0x02u, 0x0Du, 0xB0u, 0x3Eu, 0xABu,
+    0x1Eu, 0x03u, 0x1Du, 0xDAu, 0x2Fu, 0xBEu, 0x03u, 0xD1u, 0x79u, 0x21u, 0x70u, 0xA0u, 0xF3u, 0x00u, 0x9Cu, 0xEEu
+};
+
+
+static void Check(int cond, const char *text, int line)
+{
+    ++checks;
+    if (!cond)
+    {
+        ++failures;
+        (void) printf("  FAIL line %d: %s\n", line, text);
+    }
+}
+
+
+static void TestVector(void)
+{
+    CY_ALIGN(4) uint8_t data[sizeof(cipher)];
+
+    (void) memcpy(data, cipher, sizeof(data));
+    CHECK(DFU_DecryptData(0u, data, sizeof(data), eiv) == CY_DFU_SUCCESS);
+    CHECK(memcmp(data, plain, sizeof(data)) == 0);
+
+    /* A row decrypts on its own, from its address */
+    (void) memcpy(data, &cipher[32], 32u);
+    CHECK(DFU_DecryptData(32u, data, 32u, eiv) == CY_DFU_SUCCESS);
+    CHECK(memcmp(data, &plain[32], 32u) == 0);
+
+    CHECK(DFU_DecryptData(8u, data, 32u, eiv) == CY_DFU_ERROR_LENGTH);
+    CHECK(DFU_DecryptData(0u, data, 24u, eiv) == CY_DFU_ERROR_LENGTH);
+}
+
+
+static void Throughput(void)
+{
+    CY_ALIGN(4) static uint8_t row[CY_FLASH_SIZEOF_ROW];
+    struct timespec start;
+    struct timespec end;
+    double seconds;
+    uint32_t idx;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &start);
+    for (idx = 0u; idx < BENCH_ROWS; ++idx)
+    {
+        (void) DFU_DecryptData(0x10040000u + ((idx % 256u) * CY_FLASH_SIZEOF_ROW), row, sizeof(row), eiv);
+    }
+    (void) clock_gettime(CLOCK_MONOTONIC, &end);
+
+    seconds = (double)(end.tv_sec - start.tv_sec) + ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+    (void) printf("%.1f us per %lu-byte row, %.1f MB/s on the host\n",
+                  (seconds * 1e6) / BENCH_ROWS, CY_FLASH_SIZEOF_ROW,
+                  ((double)BENCH_ROWS * CY_FLASH_SIZEOF_ROW) / seconds / 1e6);
+}
+
+
+int main(void)
+{
+    TestVector();
+    (void) printf("%s SP800-38A F.5.1\n", (failures == 0u) ? "PASS" : "FAIL");
+    Throughput();
+    (void) printf("%u checks, %u failures\n", (unsigned)checks, (unsigned)failures);
+    return ( (failures == 0u) ? 0 : 1 );
+}
+
+
+/* [] END OF FILE */
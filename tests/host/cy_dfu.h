@@ -0,0 +1,75 @@
+/***************************************************************************//**
+* \file cy_dfu.h
+* \version 1.0
+*
+* This file provides the host build of the DFU SDK parts used by the common
+* modules under test, and the slots of the linker scripts: App1 at
+* 0x10040000 and App2 at 0x10060000, 128 KB each, and the XIP slot App3.
+* emu.c emulates the functions.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(CY_DFU_H)
+#define CY_DFU_H
+
+#include "cy_pdl.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The applications: App0 and the slots 1 to 3 */
+#define CY_DFU_MAX_APPS                 (4u)
+
+#define CY_DFU_SIZEOF_DATA_BUFFER       (CY_FLASH_SIZEOF_ROW + 16u)
+
+#define CY_DFU_SIGNATURE_SIZE           (4u)
+#define CY_DFU_APP1_VERIFY_START        (0x10040000u)
+#define CY_DFU_APP1_VERIFY_LENGTH       (0x00020000u - CY_DFU_SIGNATURE_SIZE)
+#define CY_DFU_APP2_VERIFY_START        (0x10060000u)
+#define CY_DFU_APP2_VERIFY_LENGTH       (0x00020000u - CY_DFU_SIGNATURE_SIZE)
+#define CY_DFU_APP3_VERIFY_START        (0x18400000u)
+#define CY_DFU_APP3_VERIFY_LENGTH       (0x00080000u - CY_DFU_SIGNATURE_SIZE)
+
+typedef enum
+{
+    CY_DFU_SUCCESS          = 0x0D500000u,
+    CY_DFU_ERROR_VERIFY     = 0x0D5B0002u,
+    CY_DFU_ERROR_LENGTH     = 0x0D5B0003u,
+    CY_DFU_ERROR_DATA       = 0x0D5B0004u,
+    CY_DFU_ERROR_ADDRESS    = 0x0D5B000Au
+} cy_en_dfu_status_t;
+
+typedef struct
+{
+    uint32_t timeout;
+    uint8_t *dataBuffer;
+    uint8_t *packetBuffer;
+} cy_stc_dfu_params_t;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+uint32_t Cy_DFU_DataChecksum(const uint8_t *address, uint32_t length, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t Cy_DFU_ValidateApp(uint32_t appId, cy_stc_dfu_params_t *params);
+cy_en_dfu_status_t Cy_DFU_GetAppMetadata(uint32_t appId, uint32_t *verifyAddress, uint32_t *verifySize);
+uint32_t Cy_DFU_GetRunningApp(void);
+void Cy_DFU_ExecuteApp(uint32_t appId);
+void Cy_DFU_SwitchToApp(uint32_t appId);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(CY_DFU_H) */
+
+
+/* [] END OF FILE */
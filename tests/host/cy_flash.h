@@ -0,0 +1,18 @@
+/***************************************************************************//**
+* \file cy_flash.h
+* \version 1.0
+*
+* This file provides the host build of cy_flash.h, see cy_pdl.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include "cy_pdl.h"
+
+
+/* [] END OF FILE */
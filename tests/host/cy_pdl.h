@@ -0,0 +1,112 @@
+/***************************************************************************//**
+* \file cy_pdl.h
+* \version 1.0
+*
+* This file provides the host build of the PDL parts used by the common
+* modules under test: the types, the registers they touch and the driver
+* functions, which emu.c emulates.
+*
+* The flash is emulated at its device addresses, so the modules read it
+* through the addresses of the linker scripts as on the device.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(CY_PDL_H)
+#define CY_PDL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define __WEAK                          __attribute__((weak))
+#define __USED                          __attribute__((used))
+#define CY_SECTION(name)
+#define CY_ALIGN(align)                 __attribute__((aligned(align)))
+
+/** The user flash of the CY8C624ABZI device */
+#define CY_FLASH_BASE                   (0x10000000UL)
+#define CY_FLASH_SIZE                   (0x00100000UL)
+#define CY_FLASH_SIZEOF_ROW             (512UL)
+
+/** The reset reasons of Cy_SysLib_GetResetReason(), 0 after a power-on reset */
+#define CY_SYSLIB_RESET_HWWDT           (0x0001u)
+#define CY_SYSLIB_RESET_SOFT            (0x0010u)
+
+typedef enum
+{
+    CY_FLASH_DRV_SUCCESS        = 0x00u,
+    CY_FLASH_DRV_INV_PROT       = 0x01u
+} cy_en_flashdrv_status_t;
+
+/* The core registers used by dfu_boot.c, only written on the host */
+typedef struct
+{
+    volatile uint32_t ICER[8];
+    volatile uint32_t ICPR[8];
+} NVIC_Type;
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t LOAD;
+    volatile uint32_t VAL;
+} SysTick_Type;
+
+typedef struct
+{
+    volatile uint32_t VTOR;
+} SCB_Type;
+
+extern NVIC_Type    emu_nvic;
+extern SysTick_Type emu_sysTick;
+extern SCB_Type     emu_scb;
+
+#define NVIC                            (&emu_nvic)
+#define SysTick                         (&emu_sysTick)
+#define SCB                             (&emu_scb)
+
+#define SysTick_CTRL_ENABLE_Msk         (1UL << 0u)
+#define SysTick_CTRL_TICKINT_Msk        (1UL << 1u)
+#define SysTick_LOAD_RELOAD_Msk         (0x00FFFFFFUL)
+
+#define __disable_irq()                 ((void)0)
+#define __enable_irq()                  ((void)0)
+#define __DSB()                         ((void)0)
+#define __ISB()                         ((void)0)
+#define __SEV()                         ((void)0)
+#define __WFI()                         ((void)0)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+uint32_t Cy_SysLib_GetResetReason(void);
+cy_en_flashdrv_status_t Cy_Flash_WriteRow(uint32_t rowAddr, const uint32_t *data);
+
+void Cy_WDT_Unlock(void);
+void Cy_WDT_Lock(void);
+void Cy_WDT_Enable(void);
+void Cy_WDT_Disable(void);
+void Cy_WDT_SetIgnoreBits(uint32_t bitsNum);
+void Cy_WDT_ClearWatchdog(void);
+void Cy_WDT_ClearInterrupt(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(CY_PDL_H) */
+
+
+/* [] END OF FILE */
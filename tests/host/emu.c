@@ -0,0 +1,218 @@
+/***************************************************************************//**
+* \file emu.c
+* \version 1.0
+*
+* This file provides the emulated device of the host tests, see emu.h, and
+* the PDL and DFU SDK functions the common modules call.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "emu.h"
+
+/* The erased flash value of the emulation */
+#define ERASED_VALUE    (0x00u)
+
+/* The bytes of a row programmed before the power is lost */
+#define TORN_SIZE       (8u)
+
+emu_t emu;
+
+NVIC_Type    emu_nvic;
+SysTick_Type emu_sysTick;
+SCB_Type     emu_scb;
+
+/* The flash mapping, at CY_FLASH_BASE */
+static uint8_t *emu_flash = NULL;
+
+
+/*******************************************************************************
+* Function Name: Emu_Init
+****************************************************************************//**
+*
+* Maps the flash on the first call and erases it, and powers the device on
+* with no valid slot.
+*
+*******************************************************************************/
+void Emu_Init(void)
+{
+    if (emu_flash == NULL)
+    {
+        void *map = mmap((void *)CY_FLASH_BASE, CY_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (map != (void *)CY_FLASH_BASE)
+        {
+            (void) fprintf(stderr, "emu: can not map the flash at 0x%08lX\n", CY_FLASH_BASE);
+            exit(2);
+        }
+        emu_flash = (uint8_t *)map;
+    }
+    (void) memset(emu_flash, ERASED_VALUE, CY_FLASH_SIZE);
+    (void) memset(emu.valid, 0, sizeof(emu.valid));
+    emu.resetReason = 0u;
+    emu.wdtEnabled  = 0u;
+    emu.runningApp  = 0u;
+    emu.writes      = 0u;
+    emu.failWrite   = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: Emu_Crc32c
+****************************************************************************//**
+*
+* Returns the CRC-32C of the data, the checksum of the DFU SDK.
+*
+*******************************************************************************/
+uint32_t Emu_Crc32c(const uint8_t *data, uint32_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    uint32_t idx;
+    uint32_t bit;
+
+    for (idx = 0u; idx < length; ++idx)
+    {
+        crc ^= data[idx];
+        for (bit = 0u; bit < 8u; ++bit)
+        {
+            crc = (crc >> 1u) ^ (0x82F63B78u & (0u - (crc & 1u)));
+        }
+    }
+    return (~crc);
+}
+
+
+uint32_t Cy_SysLib_GetResetReason(void)
+{
+    return (emu.resetReason);
+}
+
+
+cy_en_flashdrv_status_t Cy_Flash_WriteRow(uint32_t rowAddr, const uint32_t *data)
+{
+    cy_en_flashdrv_status_t status = CY_FLASH_DRV_SUCCESS;
+
+    if ( ((rowAddr % CY_FLASH_SIZEOF_ROW) != 0u) || (rowAddr < CY_FLASH_BASE)
+      || (rowAddr >= (CY_FLASH_BASE + CY_FLASH_SIZE)) )
+    {
+        status = CY_FLASH_DRV_INV_PROT;
+    }
+    else
+    {
+        uint8_t *row = &emu_flash[rowAddr - CY_FLASH_BASE];
+
+        ++emu.writes;
+        if (emu.writes == emu.failWrite)
+        {
+            /* The power is lost during the write */
+            (void) memset(row, ERASED_VALUE, CY_FLASH_SIZEOF_ROW);
+            (void) memcpy(row, data, TORN_SIZE);
+            emu.failWrite = 0u;
+            longjmp(emu.reset, 1);
+        }
+        (void) memcpy(row, data, CY_FLASH_SIZEOF_ROW);
+    }
+    return (status);
+}
+
+
+void Cy_WDT_Unlock(void)
+{
+}
+
+
+void Cy_WDT_Lock(void)
+{
+}
+
+
+void Cy_WDT_Enable(void)
+{
+    emu.wdtEnabled = 1u;
+}
+
+
+void Cy_WDT_Disable(void)
+{
+    emu.wdtEnabled = 0u;
+}
+
+
+void Cy_WDT_SetIgnoreBits(uint32_t bitsNum)
+{
+    (void) bitsNum;
+}
+
+
+void Cy_WDT_ClearWatchdog(void)
+{
+}
+
+
+void Cy_WDT_ClearInterrupt(void)
+{
+}
+
+
+uint32_t Cy_DFU_DataChecksum(const uint8_t *address, uint32_t length, cy_stc_dfu_params_t *params)
+{
+    (void) params;
+    return (Emu_Crc32c(address, length));
+}
+
+
+cy_en_dfu_status_t Cy_DFU_ValidateApp(uint32_t appId, cy_stc_dfu_params_t *params)
+{
+    (void) params;
+    return ( ((appId < CY_DFU_MAX_APPS) && (emu.valid[appId] != 0u)) ? CY_DFU_SUCCESS : CY_DFU_ERROR_VERIFY );
+}
+
+
+cy_en_dfu_status_t Cy_DFU_GetAppMetadata(uint32_t appId, uint32_t *verifyAddress, uint32_t *verifySize)
+{
+    const uint32_t start[] = { 0u, CY_DFU_APP1_VERIFY_START, CY_DFU_APP2_VERIFY_START, CY_DFU_APP3_VERIFY_START };
+    const uint32_t length[] = { 0u, CY_DFU_APP1_VERIFY_LENGTH, CY_DFU_APP2_VERIFY_LENGTH, CY_DFU_APP3_VERIFY_LENGTH };
+    cy_en_dfu_status_t status = CY_DFU_ERROR_VERIFY;
+
+    if (appId < CY_DFU_MAX_APPS)
+    {
+        *verifyAddress = start[appId];
+        *verifySize = length[appId];
+        status = CY_DFU_SUCCESS;
+    }
+    return (status);
+}
+
+
+uint32_t Cy_DFU_GetRunningApp(void)
+{
+    return (emu.runningApp);
+}
+
+
+/* The software reset to App0, which starts the application */
+void Cy_DFU_ExecuteApp(uint32_t appId)
+{
+    emu.runningApp = appId;
+}
+
+
+/* The switch of CM0+ to the application, without a reset */
+void Cy_DFU_SwitchToApp(uint32_t appId)
+{
+    emu.runningApp = appId;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,62 @@
+/***************************************************************************//**
+* \file emu.h
+* \version 1.0
+*
+* This file provides the API of the emulated device of the host tests: the
+* user flash, mapped at its device address, the WDT, the reset reason and
+* the application slots of the DFU SDK.
+*
+* A test sets emu.reset with setjmp() before a flash write that may lose
+* power: the write of row emu.failWrite, counted from the Emu_Init() call,
+* is torn, the row erased and only its first 8 bytes programmed, and
+* longjmp() returns to emu.reset as the device resets.
+*
+********************************************************************************
+* \copyright
+* Copyright 2019, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(EMU_H)
+#define EMU_H
+
+#include <setjmp.h>
+#include "cy_pdl.h"
+#include "cy_dfu.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** The emulated device */
+typedef struct
+{
+    uint32_t resetReason;               /**< Returned by Cy_SysLib_GetResetReason() */
+    uint32_t wdtEnabled;                /**< 1 while the WDT runs */
+    uint32_t runningApp;                /**< The application started, 0 for App0 */
+    uint32_t valid[CY_DFU_MAX_APPS];    /**< 1 if Cy_DFU_ValidateApp() accepts the slot */
+    uint32_t writes;                    /**< The row writes since Emu_Init() */
+    uint32_t failWrite;                 /**< The row write that loses power, 0 for none */
+    jmp_buf reset;                      /**< Where a power loss returns */
+} emu_t;
+
+extern emu_t emu;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void Emu_Init(void);
+uint32_t Emu_Crc32c(const uint8_t *data, uint32_t length);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined(EMU_H) */
+
+
+/* [] END OF FILE */
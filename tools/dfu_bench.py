@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+"""Benchmarks a DFU download of a .cyacd2 image on modelled transports.
+
+A model of the App0 DFU engine runs the download of dfu_program.py, with
+the same packets, in simulated time, so the figures do not depend on the
+build host. The model checks the packets as the DFU SDK does: the packet
+checksum, the CRC-32C of each row, the rows in the slot of Set Application
+Metadata and the signature of the slot at Verify Application, so the image
+of dfu_image.py is checked too.
+
+The time of a packet is the host overhead, the write on the link, the wait
+of App0 for its next poll of the transport (1 ms, as I2C_I2cCyBtldrCommRead
+waits), the processing and, for Program Data, the flash row write (erase
+and program), then the response: the I2C and SPI hosts poll for it, reading
+64 bytes each time, the UART sends it as soon as it is ready. Each transport
+is one run, e.g.:
+
+    python3 tools/dfu_bench.py mtb_dfu_basic_app1.cyacd2
+    python3 tools/dfu_bench.py app.cyacd2 --transport i2c:400000 --transport uart:1000000 --json
+    python3 tools/dfu_bench.py app.cyacd2 --json --baseline bench.json --tolerance 0.05
+
+With --baseline the rows/s of each transport are compared with a previous
+--json output, and the exit status is 1 if one is slower by more than the
+tolerance. --serve runs the model as a device for dfu_program.py --socket,
+with no timing.
+"""
+
+import argparse
+import json
+import math
+import socket
+import struct
+import sys
+
+import dfu_packet
+import dfu_program
+
+# The transports of a run with no --transport, the bit rate or the baud rate
+TRANSPORTS = ['i2c:100000', 'i2c:400000', 'i2c:1000000', 'uart:115200', 'spi:1000000']
+
+# The bytes of a poll for the response, as dfu_packet.I2cLink reads them
+POLL_SIZE = 64
+
+# The size of the application signature, CY_DFU_SIGNATURE_SIZE
+SIGNATURE_SIZE = 4
+
+# The size of the DFU SDK data buffer, CY_DFU_SIZEOF_DATA_BUFFER
+DATA_BUFFER = 512 + 16
+
+
+class Transport:
+    """The timing of a link: the bits of each byte and of each transfer."""
+
+    def __init__(self, spec, poll):
+        kind, _, rate = spec.partition(':')
+        if kind not in ('i2c', 'uart', 'spi') or not rate.isdigit():
+            raise ValueError('%s: not i2c:<Hz>, uart:<baud> or spi:<Hz>' % spec)
+        self.name = spec
+        self.kind = kind
+        self.rate = int(rate)
+        # I2C: 8 bits and the ACK, a start, the address byte and a stop;
+        # UART: a start and a stop bit; SPI: 8 bits, no framing
+        self.byte_bits = {'i2c': 9, 'uart': 10, 'spi': 8}[kind]
+        self.frame_bits = {'i2c': 9 + 2, 'uart': 0, 'spi': 0}[kind]
+        self.polled = kind != 'uart'
+        self.poll = poll
+
+    def time(self, size):
+        """Returns the time of a transfer of size bytes, in seconds."""
+        return (self.frame_bits + size * self.byte_bits) / self.rate
+
+
+class Device:
+    """The model of the App0 DFU engine, the commands of dfu_program.py."""
+
+    def __init__(self, silicon_id, silicon_rev, crc, args):
+        self.silicon_id = silicon_id
+        self.silicon_rev = silicon_rev
+        self.crc = crc
+        self.args = args
+        self.flash = {}
+        self.data = b''
+        self.app = None
+
+    def handle(self, packet):
+        """Returns the response of a packet, None for Exit, and the time
+        App0 takes, in seconds, the flash row write included."""
+        busy = self.args.packet_us * 1e-6 + len(packet) * self.args.byte_ns * 1e-9
+        try:
+            cmd, data = dfu_packet.parse(packet, self.crc)
+        except dfu_packet.DfuError:
+            return self.response(0x08), busy
+        if cmd == dfu_program.CMD_EXIT:
+            return None, busy
+        if cmd == dfu_program.CMD_ENTER:
+            self.data = b''
+            return self.response(0, struct.pack('<IB3s', self.silicon_id, self.silicon_rev, b'\x00\x01\x04')), busy
+        if cmd == dfu_program.CMD_SET_METADATA and len(data) == 9:
+            self.app = struct.unpack('<BII', data)
+            return self.response(0), busy
+        if cmd == dfu_program.CMD_SEND_DATA:
+            self.data += data
+            return self.response(0x03 if len(self.data) > DATA_BUFFER else 0), busy
+        if cmd == dfu_program.CMD_PROGRAM_DATA and len(data) >= 8:
+            address, crc = struct.unpack_from('<II', data)
+            row, self.data = self.data + data[8:], b''
+            busy += len(row) * self.args.crc_ns * 1e-9
+            # The slot of the metadata, and its signature after it
+            if self.app is None or not self.app[1] <= address < self.app[1] + self.app[2] + SIGNATURE_SIZE \
+                    or address % self.args.row_size != 0 or len(row) != self.args.row_size:
+                return self.response(0x0A), busy
+            if dfu_packet.crc32c(row) != crc:
+                return self.response(0x08), busy
+            self.flash[address] = row
+            return self.response(0), busy + (self.args.erase_ms + self.args.program_ms) * 1e-3
+        if cmd == dfu_program.CMD_VERIFY_APP and self.app is not None:
+            # The CRC of length bytes, the signature after them, as Cy_DFU_ValidateApp()
+            _, start, length = self.app
+            busy += length * self.args.crc_ns * 1e-9
+            end = start + length + SIGNATURE_SIZE
+            first = start - start % self.args.row_size
+            slot = b''.join(self.flash.get(address, bytes(self.args.row_size))
+                            for address in range(first, end, self.args.row_size))[start - first:end - first]
+            valid = dfu_packet.crc32c(slot[:length]) == struct.unpack_from('<I', slot, length)[0]
+            return self.response(0, bytes([1 if valid else 0])), busy
+        return self.response(0x05), busy
+
+    def response(self, status, data=b''):
+        return dfu_packet.build(status, data, self.crc)
+
+
+class Link:
+    """The link of dfu_program.py to the model, in simulated time."""
+
+    def __init__(self, device, transport, args):
+        self.device = device
+        self.transport = transport
+        self.args = args
+        self.now = 0.0
+        self.link_busy = 0.0
+        self.flash_busy = 0.0
+
+    def deliver(self, packet):
+        """Writes a packet, returns the response and when it is ready."""
+        self.now += self.args.host_us * 1e-6
+        write = self.transport.time(len(packet) + (1 if self.transport.kind == 'i2c' else 0))
+        self.now += write
+        self.link_busy += write
+        # App0 checks the transport once per poll period
+        tick = self.args.device_poll_ms * 1e-3
+        seen = math.ceil(self.now / tick - 1e-9) * tick if tick else self.now
+        response, busy = self.device.handle(packet)
+        if response is not None and response[1] == 0 and packet[1] == dfu_program.CMD_PROGRAM_DATA:
+            self.flash_busy += (self.args.erase_ms + self.args.program_ms) * 1e-3
+        return response, seen + busy
+
+    def write(self, packet):
+        self.deliver(packet)
+
+    def transfer(self, packet, size=0):
+        response, ready = self.deliver(packet)
+        if self.transport.polled:
+            # The host reads POLL_SIZE bytes, then waits before the next poll
+            read = self.transport.time(POLL_SIZE + (1 if self.transport.kind == 'i2c' else 0))
+            while True:
+                start = self.now
+                self.now += read
+                self.link_busy += read
+                if start >= ready:
+                    break
+                self.now += self.transport.poll
+        else:
+            read = self.transport.time(len(response))
+            self.now = max(self.now, ready) + read
+            self.link_busy += read
+        return response
+
+    def close(self):
+        pass
+
+
+def run(path, spec, args):
+    """Downloads the image on a transport, returns the figures."""
+    image = dfu_program.Cyacd2(path)
+    try:
+        device = Device(image.silicon_id, image.silicon_rev, image.crc, args)
+        link = Link(device, Transport(spec, args.host_poll_ms * 1e-3), args)
+        options = argparse.Namespace(packet_size=args.packet_size, force=False, progress=False)
+        report = dfu_program.program(link, image, options, lambda: link.now)
+    finally:
+        image.close()
+    total = link.now
+    return {
+        'transport': spec,
+        'rows': report['rows'],
+        'bytes': report['bytes'],
+        'seconds': total,
+        'phases': report['phases'],
+        'rows_per_s': report['rows_per_s'],
+        'bytes_per_s': report['bytes_per_s'],
+        'link_utilization': link.link_busy / total if total else 0.0,
+        'flash_utilization': link.flash_busy / total if total else 0.0,
+        'latency_ms': report['latency_ms'],
+    }
+
+
+def compare(results, path, tolerance):
+    """Returns the transports slower than in the baseline."""
+    with open(path) as baseline:
+        previous = {result['transport']: result for result in json.load(baseline)['results']}
+    slower = []
+    for result in results:
+        before = previous.get(result['transport'])
+        if before and result['rows_per_s'] < before['rows_per_s'] * (1.0 - tolerance):
+            slower.append('%s: %.2f rows/s, was %.2f' % (result['transport'], result['rows_per_s'],
+                                                        before['rows_per_s']))
+    return slower
+
+
+def render(results, out=sys.stdout):
+    """Prints a table of the runs."""
+    out.write('%-13s %8s %8s %8s %8s %9s %10s %6s %6s\n'
+              % ('transport', 'total s', 'enter s', 'rows s', 'verify s', 'rows/s', 'bytes/s', 'link', 'flash'))
+    for result in results:
+        phases = result['phases']
+        out.write('%-13s %8.2f %8.3f %8.2f %8.3f %9.1f %10.0f %5.0f%% %5.0f%%\n'
+                  % (result['transport'], result['seconds'], phases['enter'], phases['rows'], phases['verify'],
+                     result['rows_per_s'], result['bytes_per_s'], result['link_utilization'] * 100,
+                     result['flash_utilization'] * 100))
+
+
+def serve(path, port, args):
+    """Runs the model as a device for dfu_program.py --socket."""
+    image = dfu_program.Cyacd2(path)
+    image.close()
+    listener = socket.create_server(('localhost', port))
+    sys.stderr.write('dfu_bench: serving on localhost:%d\n' % port)
+    while True:
+        connection, _ = listener.accept()
+        device = Device(image.silicon_id, image.silicon_rev, image.crc, args)
+        with connection:
+            stream = connection.makefile('rb')
+            while True:
+                head = stream.read(4)
+                if len(head) < 4:
+                    break
+                packet = head + stream.read((head[2] | (head[3] << 8)) + dfu_packet.OVERHEAD - 4)
+                response, _ = device.handle(packet)
+                if response is not None:
+                    connection.sendall(response)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('image', help='the .cyacd2 file, e.g. mtb_dfu_basic_app1.cyacd2')
+    parser.add_argument('--transport', action='append',
+                        help='i2c:<Hz>, uart:<baud> or spi:<Hz>, repeated (default %s)' % ', '.join(TRANSPORTS))
+    parser.add_argument('--packet-size', type=int, default=64, help='the largest packet (default 64)')
+    parser.add_argument('--row-size', type=int, default=512, help='the flash row size (default 512)')
+    parser.add_argument('--erase-ms', type=float, default=11.0, help='the row erase time (default 11 ms)')
+    parser.add_argument('--program-ms', type=float, default=5.0, help='the row program time (default 5 ms)')
+    parser.add_argument('--packet-us', type=float, default=20.0,
+                        help='the processing of a packet by App0 (default 20 us)')
+    parser.add_argument('--byte-ns', type=float, default=100.0,
+                        help='the processing of a packet byte, checksum and copy (default 100 ns)')
+    parser.add_argument('--crc-ns', type=float, default=100.0, help='the CRC-32C of a byte (default 100 ns)')
+    parser.add_argument('--device-poll-ms', type=float, default=1.0,
+                        help='the period App0 checks the transport, 0 for an interrupt (default 1 ms)')
+    parser.add_argument('--host-us', type=float, default=50.0,
+                        help='the host overhead of a transfer (default 50 us)')
+    parser.add_argument('--host-poll-ms', type=float, default=1.0,
+                        help='the wait of the host between the polls for a response (default 1 ms)')
+    parser.add_argument('--json', action='store_true', help='print JSON instead of a table')
+    parser.add_argument('--baseline', help='a previous --json output to compare the rows/s with')
+    parser.add_argument('--tolerance', type=float, default=0.05,
+                        help='the slowdown allowed with --baseline (default 0.05)')
+    parser.add_argument('--serve', type=int, metavar='PORT', help='serve the model for dfu_program.py --socket')
+    args = parser.parse_args()
+
+    try:
+        if args.serve:
+            serve(args.image, args.serve, args)
+        results = [run(args.image, spec, args) for spec in args.transport or TRANSPORTS]
+        slower = compare(results, args.baseline, args.tolerance) if args.baseline else []
+    except (dfu_packet.DfuError, ValueError, OSError, KeyError) as error:
+        sys.exit('dfu_bench: %s' % error)
+
+    if args.json:
+        model = {key: getattr(args, key) for key in ('packet_size', 'row_size', 'erase_ms', 'program_ms',
+                                                     'packet_us', 'byte_ns', 'crc_ns', 'device_poll_ms',
+                                                     'host_us', 'host_poll_ms')}
+        json.dump({'image': args.image, 'model': model, 'results': results}, sys.stdout, indent=2)
+        sys.stdout.write('\n')
+    else:
+        render(results)
+    for line in slower:
+        sys.stderr.write('dfu_bench: slower than the baseline, %s\n' % line)
+    sys.exit(1 if slower else 0)
+
+
+if __name__ == '__main__':
+    main()
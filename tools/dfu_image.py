@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""Builds the .hex and .cyacd2 images of the CM4 and CM0+ ELF files.
+
+The post-build step of the CM4 projects without cymcuelftool, e.g. on a
+Linux build host (DFU_IMAGE_TOOL=python in the Makefiles):
+
+    python3 tools/dfu_image.py app1_cm4.elf app1_cm0p.elf \\
+        --hex mtb_dfu_basic_app1_signed.hex --cyacd2 mtb_dfu_basic_app1.cyacd2
+
+The loadable segments of the ELF files are merged, at their load address,
+and must not overlap. --sign, implied by --cyacd2, fills the application
+slot of the linker scripts, __cy_app_verify_start and
+__cy_app_verify_length, with 0x00 where no segment is loaded, the erased
+flash value, and writes the CRC-32C of the slot to .cy_app_signature, after
+it, as the DFU SDK checks it. The .cyacd2 image has every row of the slot
+and the signature, so a download leaves no row of the previous image; its
+@APPINFO length is __cy_app_verify_length, without the signature, as the
+DFU SDK metadata.
+
+The .hex image also has the .cymeta record (0x90500000) and the checksum
+of the flash (0x90300000) of the Cypress hex format. --manifest writes the
+CRC-32C of each row of the slot as JSON, to compare the rows of two images
+or of an image and a device, or with --sparse only the rows that hold
+loaded data and their ranges; a name ending with .gz is compressed.
+"""
+
+import argparse
+import gzip
+import json
+import struct
+import sys
+
+import dfu_packet
+
+PT_LOAD = 1
+SHT_SYMTAB = 2
+
+# The Cypress hex format records
+CHECKSUM_ADDRESS = 0x90300000
+META_ADDRESS = 0x90500000
+
+# The user flash, for the checksum of the hex image
+FLASH_START = 0x10000000
+FLASH_END = 0x10200000
+
+# The size of the CRC-32C signature, __cy_boot_signature_size
+SIGNATURE_SIZE = 4
+
+# The symbols of the linker scripts of the DFU SDK
+SYMBOLS = ('__cy_app_verify_start', '__cy_app_verify_length', '__cy_app_id',
+           '__cy_product_id', '__cy_checksum_type', '__cy_boot_signature_size')
+
+
+class Elf:
+    """The loadable segments, the symbols and .cymeta of an ELF32 file."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as elf:
+            data = elf.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+            raise ValueError('%s: not a little endian ELF32 file' % path)
+        self.path = path
+        (phoff, shoff, _, _, phentsize, phnum, shentsize, shnum, shstrndx) = \
+            struct.unpack_from('<IIIHHHHHH', data, 28)
+
+        # The segments with file data, at their load address
+        self.segments = []
+        for index in range(phnum):
+            p_type, offset, _, paddr, filesz = struct.unpack_from('<IIIII', data, phoff + index * phentsize)
+            if p_type == PT_LOAD and filesz != 0:
+                self.segments.append((paddr, data[offset:offset + filesz]))
+
+        sections = [struct.unpack_from('<IIIIIIIIII', data, shoff + index * shentsize) for index in range(shnum)]
+        names = sections[shstrndx]
+
+        def name(table, at):
+            start = table[4] + at
+            return data[start:data.index(b'\0', start)].decode()
+
+        self.symbols = {}
+        self.meta = None
+        for section in sections:
+            if name(names, section[0]) == '.cymeta' and section[5] != 0:
+                self.meta = data[section[4]:section[4] + section[5]]
+            if section[1] == SHT_SYMTAB:
+                strings = sections[section[6]]
+                for at in range(section[4], section[4] + section[5], 16):
+                    st_name, value = struct.unpack_from('<II', data, at)
+                    if st_name != 0:
+                        symbol = name(strings, st_name)
+                        if symbol in SYMBOLS:
+                            self.symbols[symbol] = value
+
+
+class Image:
+    """The merged segments of the ELF files."""
+
+    def __init__(self, elves):
+        self.chunks = sorted((address, bytes(data), elf.path) for elf in elves for address, data in elf.segments)
+        for (address, data, path), (after, _, other) in zip(self.chunks, self.chunks[1:]):
+            if address + len(data) > after:
+                raise ValueError('%s and %s overlap at 0x%08X' % (path, other, after))
+
+    def read(self, start, length):
+        """Returns the bytes of a range, 0x00 where nothing is loaded."""
+        out = bytearray(length)
+        for address, data, _ in self.chunks:
+            low = max(start, address)
+            high = min(start + length, address + len(data))
+            if low < high:
+                out[low - start:high - start] = data[low - address:high - address]
+        return out
+
+    def loaded(self, start, length):
+        """Returns the ranges of a range that hold loaded data."""
+        ranges = []
+        for address, data, _ in self.chunks:
+            low = max(start, address)
+            high = min(start + length, address + len(data))
+            if low < high:
+                ranges.append((low, high - low))
+        return ranges
+
+    def replace(self, start, data, path):
+        """Replaces the chunks of a range with data."""
+        end = start + len(data)
+        kept = []
+        for address, chunk, owner in self.chunks:
+            if address < start:
+                kept.append((address, chunk[:max(0, start - address)], owner))
+            if address + len(chunk) > end:
+                skip = max(0, end - address)
+                kept.append((address + skip, chunk[skip:], owner))
+        self.chunks = sorted([c for c in kept if c[1]] + [(start, bytes(data), path)])
+
+
+def symbol(elves, name, default=None):
+    """Returns a symbol of the linker scripts, the same in all the files."""
+    values = {elf.symbols[name] for elf in elves if name in elf.symbols}
+    if len(values) > 1:
+        raise ValueError('%s differs between the ELF files' % name)
+    if not values:
+        if default is None:
+            raise ValueError('no %s in the ELF files' % name)
+        return default
+    return values.pop()
+
+
+def sign(image, elves):
+    """Fills the slot and writes its signature, returns the slot and the
+    ranges of it that hold loaded data."""
+    start = symbol(elves, '__cy_app_verify_start')
+    length = symbol(elves, '__cy_app_verify_length')
+    size = symbol(elves, '__cy_boot_signature_size', SIGNATURE_SIZE)
+    if size != SIGNATURE_SIZE:
+        raise ValueError('only the CRC-32C signature, of 4 bytes, is supported, not %d bytes' % size)
+    for address, data, path in image.chunks:
+        if address < start + length + size and address + len(data) > start \
+                and (address < start or address + len(data) > start + length + size):
+            raise ValueError('%s: 0x%08X..0x%08X crosses the slot 0x%08X..0x%08X'
+                             % (path, address, address + len(data), start, start + length + size))
+    ranges = image.loaded(start, length + size)
+    slot = image.read(start, length)
+    slot += struct.pack('<I', dfu_packet.crc32c(slot))
+    image.replace(start, slot, 'signature')
+    return start, slot, ranges
+
+
+def write_hex(path, image, meta):
+    """Writes the Intel hex image, with the Cypress hex records."""
+    chunks = [(address, data) for address, data, _ in image.chunks]
+    total = 0
+    for address, data in chunks:
+        low = max(address, FLASH_START)
+        high = min(address + len(data), FLASH_END)
+        if low < high:
+            total += sum(data[low - address:high - address])
+    chunks.append((CHECKSUM_ADDRESS, struct.pack('>H', total & 0xFFFF)))
+    if meta is not None and not image.loaded(META_ADDRESS, len(meta)):
+        chunks.append((META_ADDRESS, meta))
+    chunks.sort()
+
+    lines = []
+    upper = None
+    for address, data in chunks:
+        for offset in range(0, len(data), 16):
+            at = address + offset
+            if at >> 16 != upper:
+                upper = at >> 16
+                lines.append(record(0, 4, struct.pack('>H', upper)))
+            lines.append(record(at & 0xFFFF, 0, data[offset:offset + 16]))
+    lines.append(record(0, 1, b''))
+    with open(path, 'w') as out:
+        out.write('\n'.join(lines) + '\n')
+
+
+def record(address, kind, data):
+    """Returns an Intel hex record."""
+    raw = struct.pack('>BHB', len(data), address, kind) + bytes(data)
+    return ':%s%02X' % (raw.hex().upper(), (-sum(raw)) & 0xFF)
+
+
+def write_cyacd2(path, start, slot, elves, meta, args):
+    """Writes the .cyacd2 image of the slot, every row."""
+    silicon_id, silicon_rev = args.silicon_id, args.silicon_rev
+    if meta is not None and len(meta) >= 8:
+        silicon_id = silicon_id if silicon_id is not None else struct.unpack_from('>I', meta, 2)[0]
+        silicon_rev = silicon_rev if silicon_rev is not None else meta[7]
+    header = struct.pack('>BIBBBI', 1, silicon_id or 0, silicon_rev or 0,
+                         symbol(elves, '__cy_checksum_type', 0), symbol(elves, '__cy_app_id'),
+                         symbol(elves, '__cy_product_id', 0))
+    with open(path, 'w') as out:
+        out.write(header.hex().upper() + '\n')
+        # The length of the metadata, without the signature, as the DFU SDK checks it
+        out.write('@APPINFO:0x%X,0x%X\n' % (start, len(slot) - SIGNATURE_SIZE))
+        for offset in range(0, len(slot), args.row_size):
+            row = struct.pack('<I', start + offset) + slot[offset:offset + args.row_size]
+            out.write(':' + row.hex().upper() + '\n')
+
+
+def write_manifest(path, start, slot, ranges, elves, args):
+    """Writes the JSON manifest of the rows of the slot."""
+    rows = []
+    for offset in range(0, len(slot), args.row_size):
+        address = start + offset
+        loaded = any(low < address + args.row_size and low + length > address for low, length in ranges)
+        if loaded or not args.sparse:
+            rows.append({'address': address,
+                         'crc32c': dfu_packet.crc32c(slot[offset:offset + args.row_size]),
+                         'loaded': loaded})
+    manifest = {
+        'app': symbol(elves, '__cy_app_id'),
+        'start': start,
+        'length': len(slot) - SIGNATURE_SIZE,
+        'row_size': args.row_size,
+        'signature': struct.unpack_from('<I', slot, len(slot) - SIGNATURE_SIZE)[0],
+        'rows': rows,
+    }
+    if args.sparse:
+        manifest['ranges'] = [{'address': address, 'length': length} for address, length in ranges]
+    text = json.dumps(manifest, indent=1).encode() + b'\n'
+    if path.endswith('.gz'):
+        with gzip.open(path, 'wb', compresslevel=6) as out:
+            out.write(text)
+    else:
+        with open(path, 'wb') as out:
+            out.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elves', nargs='+', metavar='elf', help='the ELF files of the cores')
+    parser.add_argument('--hex', help='the merged .hex image to write')
+    parser.add_argument('--cyacd2', help='the .cyacd2 image of the slot to write, implies --sign')
+    parser.add_argument('--sign', action='store_true', help='fill and sign the application slot')
+    parser.add_argument('--manifest', help='the JSON manifest of the rows to write, .gz to compress')
+    parser.add_argument('--sparse', action='store_true', help='only the rows with loaded data in the manifest')
+    parser.add_argument('--row-size', type=int, default=512, help='the flash row size (default 512)')
+    parser.add_argument('--silicon-id', type=lambda v: int(v, 0), help='the silicon ID, instead of .cymeta')
+    parser.add_argument('--silicon-rev', type=lambda v: int(v, 0), help='the silicon revision, instead of .cymeta')
+    args = parser.parse_args()
+
+    if (args.cyacd2 or args.manifest) and not args.sign:
+        args.sign = True
+    try:
+        elves = [Elf(path) for path in args.elves]
+        image = Image(elves)
+        meta = next((elf.meta for elf in elves if elf.meta is not None), None)
+        if args.sign:
+            start, slot, ranges = sign(image, elves)
+        if args.hex:
+            write_hex(args.hex, image, meta)
+        if args.cyacd2:
+            write_cyacd2(args.cyacd2, start, slot, elves, meta, args)
+        if args.manifest:
+            write_manifest(args.manifest, start, slot, ranges, elves, args)
+    except (ValueError, OSError, struct.error) as error:
+        sys.exit('dfu_image: %s' % error)
+
+
+if __name__ == '__main__':
+    main()
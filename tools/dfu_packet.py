@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""DFU packet format and the I2C link of the mtb_dfu_basic host tools.
+
+A packet is SOP (0x01), the command, the data size (16 bits, little endian),
+the data, the checksum (16 bits) and EOP (0x17). The response has the same
+format with the status in place of the command. The checksum is the 2's
+complement of the byte sum, or CRC-16-CCITT when the device is built with
+CY_DFU_OPT_PACKET_CRC.
+
+The I2C link uses the Linux i2c-dev driver, e.g. with the KitProg3
+USB-I2C bridge: the host writes a packet, then reads the response in one
+transfer. App0 answers 0xFF until the response is ready.
+
+The serial and the socket links carry the packets as a byte stream, the
+response is read up to its EOP: a UART transport over a tty, or a device
+simulated on the host over TCP.
+"""
+
+import fcntl
+import os
+import select
+import socket
+import struct
+import termios
+import time
+
+SOP = 0x01
+EOP = 0x17
+OVERHEAD = 7
+
+STATUS = {
+    0x00: 'success',
+    0x02: 'verify error',
+    0x03: 'length error',
+    0x04: 'data error',
+    0x05: 'unknown command',
+    0x08: 'checksum error',
+    0x09: 'row error',
+    0x0A: 'address error',
+    0x0B: 'application error',
+    0x0F: 'unknown error',
+    0x40: 'timeout',
+}
+
+
+class DfuError(Exception):
+    """A transfer failed, or the device answered with an error status."""
+
+
+def checksum(data, crc=False):
+    """Returns the packet checksum of data, as the device computes it."""
+    if crc:
+        value = 0xFFFF
+        for byte in data:
+            value ^= byte
+            for _ in range(8):
+                value = (value >> 1) ^ 0x8408 if value & 1 else value >> 1
+        return ~value & 0xFFFF
+    return (1 + ~sum(data)) & 0xFFFF
+
+
+def _crc32c_table():
+    table = []
+    for index in range(256):
+        value = index
+        for _ in range(8):
+            value = (value >> 1) ^ 0x82F63B78 if value & 1 else value >> 1
+        table.append(value)
+    return table
+
+
+CRC32C_TABLE = _crc32c_table()
+
+
+def crc32c(data, value=0):
+    """Returns the CRC-32C of data, the checksum of the rows and of the
+    application signature; value continues a previous CRC."""
+    value = ~value & 0xFFFFFFFF
+    table = CRC32C_TABLE
+    for byte in data:
+        value = table[(value ^ byte) & 0xFF] ^ (value >> 8)
+    return ~value & 0xFFFFFFFF
+
+
+def build(cmd, data=b'', crc=False):
+    """Returns the packet of a command."""
+    head = struct.pack('<BBH', SOP, cmd, len(data)) + bytes(data)
+    return head + struct.pack('<HB', checksum(head, crc), EOP)
+
+
+def parse(packet, crc=False):
+    """Returns the status and the data of a response packet."""
+    if len(packet) < OVERHEAD or packet[0] != SOP:
+        raise DfuError('no response')
+    size = packet[2] | (packet[3] << 8)
+    if len(packet) < size + OVERHEAD or packet[size + OVERHEAD - 1] != EOP:
+        raise DfuError('truncated response')
+    value = packet[4 + size] | (packet[5 + size] << 8)
+    if value != checksum(packet[:4 + size], crc):
+        raise DfuError('response checksum')
+    return packet[1], bytes(packet[4:4 + size])
+
+
+class I2cLink:
+    """The DFU I2C transport, over /dev/i2c-<bus>."""
+
+    I2C_SLAVE = 0x0703
+
+    def __init__(self, bus, address=0x08, timeout=1.0):
+        self.fd = os.open('/dev/i2c-%d' % bus, os.O_RDWR)
+        fcntl.ioctl(self.fd, self.I2C_SLAVE, address)
+        self.timeout = timeout
+
+    def close(self):
+        os.close(self.fd)
+
+    def write(self, packet):
+        """Writes a packet with no response, e.g. Exit."""
+        os.write(self.fd, packet)
+
+    def transfer(self, packet, size=64):
+        """Writes a packet and returns the response, read in size bytes."""
+        os.write(self.fd, packet)
+        end = time.monotonic() + self.timeout
+        while True:
+            response = os.read(self.fd, size)
+            if response[0] == SOP:
+                return response
+            if time.monotonic() > end:
+                raise DfuError('response timeout')
+            time.sleep(0.001)
+
+
+class StreamLink:
+    """A DFU transport over a byte stream file descriptor."""
+
+    def __init__(self, fd, timeout=1.0):
+        self.fd = fd
+        self.timeout = timeout
+
+    def close(self):
+        os.close(self.fd)
+
+    def write(self, packet):
+        """Writes a packet with no response, e.g. Exit."""
+        view = memoryview(packet)
+        while view:
+            view = view[os.write(self.fd, view):]
+
+    def read(self, size, end):
+        """Returns size bytes of the stream, raises at the end time."""
+        data = b''
+        while len(data) < size:
+            if not select.select([self.fd], [], [], max(0.0, end - time.monotonic()))[0]:
+                raise DfuError('response timeout')
+            chunk = os.read(self.fd, size - len(data))
+            if not chunk:
+                raise DfuError('link closed')
+            data += chunk
+        return data
+
+    def transfer(self, packet, size=0):
+        """Writes a packet and returns the response, size is not used."""
+        self.write(packet)
+        end = time.monotonic() + self.timeout
+        while self.read(1, end)[0] != SOP:
+            pass
+        head = bytes([SOP]) + self.read(3, end)
+        return head + self.read((head[2] | (head[3] << 8)) + OVERHEAD - 4, end)
+
+
+class SerialLink(StreamLink):
+    """The DFU UART transport, over a tty, 8N1 with no flow control."""
+
+    def __init__(self, device, baud=115200, timeout=1.0):
+        fd = os.open(device, os.O_RDWR | os.O_NOCTTY)
+        attrs = termios.tcgetattr(fd)
+        attrs[0] = 0                                        # iflag
+        attrs[1] = 0                                        # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0                                        # lflag
+        attrs[4] = attrs[5] = getattr(termios, 'B%d' % baud)
+        attrs[6][termios.VMIN] = 0
+        attrs[6][termios.VTIME] = 0
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+        termios.tcflush(fd, termios.TCIOFLUSH)
+        super().__init__(fd, timeout)
+
+
+class SocketLink(StreamLink):
+    """A DFU device simulated on the host, over TCP."""
+
+    def __init__(self, host, port, timeout=1.0):
+        self.socket = socket.create_connection((host, port), timeout)
+        self.socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        super().__init__(self.socket.fileno(), timeout)
+
+    def close(self):
+        self.socket.close()
+
+
+def add_link_arguments(parser):
+    """Adds the options of open_link() to an argparse parser."""
+    link = parser.add_mutually_exclusive_group(required=True)
+    link.add_argument('--bus', type=int, help='the /dev/i2c-<bus> number')
+    link.add_argument('--serial', help='a tty of a UART transport, e.g. /dev/ttyACM0')
+    link.add_argument('--socket', help='the host:port of a simulated device')
+    parser.add_argument('--address', type=lambda v: int(v, 0), default=0x08,
+                        help='the I2C address of App0 (default 0x08)')
+    parser.add_argument('--baud', type=int, default=115200, help='the UART baud rate (default 115200)')
+    parser.add_argument('--timeout', type=float, default=1.0,
+                        help='the response timeout in seconds (default 1)')
+
+
+def open_link(args):
+    """Returns the link of the options of add_link_arguments()."""
+    if args.serial:
+        return SerialLink(args.serial, args.baud, args.timeout)
+    if args.socket:
+        host, _, port = args.socket.rpartition(':')
+        return SocketLink(host or 'localhost', int(port), args.timeout)
+    return I2cLink(args.bus, args.address, args.timeout)
+
+
+def command(link, cmd, data=b'', crc=False):
+    """Sends a command and returns the response data, raises on an error."""
+    status, payload = parse(link.transfer(build(cmd, data, crc)), crc)
+    if status != 0:
+        raise DfuError('command 0x%02X: %s' % (cmd, STATUS.get(status, '0x%02X' % status)))
+    return payload
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Reads and renders the DFU phase profile of App0 (DFU_BOOT_PROFILE).
+
+The custom command 0x55 returns the figures of a phase, a
+dfu_profile_stats_t of mtb_dfu_basic_common/dfu_profile.h. Run a download,
+then e.g.:
+
+    python3 tools/dfu_profile.py --bus 1
+    python3 tools/dfu_profile.py --bus 1 --clear --json
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+import dfu_packet
+
+DFU_CMD_PROFILE = 0x55
+
+# The phases, in the order of dfu_profile.h
+PHASES = ['read', 'parse', 'write data', 'read data', 'flash', 'response']
+
+BUCKETS = 16
+BUCKET_SHIFT = 8
+
+# dfu_profile_stats_t: clock, count, min, max, sum and the histogram
+STATS = struct.Struct('<IIIIQ%dH' % BUCKETS)
+
+
+def decode(payload):
+    """Returns the figures of a phase from the response data."""
+    fields = STATS.unpack(payload[:STATS.size])
+    clock, count, low, high, total = fields[:5]
+    us = 1e6 / clock if clock else 0.0
+    return {
+        'clock': clock,
+        'count': count,
+        'min_us': low * us,
+        'mean_us': (total / count) * us if count else 0.0,
+        'max_us': high * us,
+        'total_us': total * us,
+        'histogram': list(fields[5:]),
+    }
+
+
+def bucket_label(index, clock):
+    """Returns the shortest duration of a bucket, in microseconds."""
+    cycles = 1 << (index + BUCKET_SHIFT)
+    return cycles * 1e6 / clock if clock else 0.0
+
+
+def render(profile, out=sys.stdout):
+    """Prints a table of the phases, then their histograms."""
+    out.write('%-11s %8s %10s %10s %10s %12s\n'
+              % ('phase', 'count', 'min us', 'mean us', 'max us', 'total ms'))
+    for name, stats in profile.items():
+        out.write('%-11s %8d %10.1f %10.1f %10.1f %12.1f\n'
+                  % (name, stats['count'], stats['min_us'], stats['mean_us'],
+                     stats['max_us'], stats['total_us'] / 1000.0))
+
+    for name, stats in profile.items():
+        histogram = stats['histogram']
+        if not any(histogram):
+            continue
+        out.write('\n%s\n' % name)
+        peak = max(histogram)
+        first = min(i for i, n in enumerate(histogram) if n)
+        last = max(i for i, n in enumerate(histogram) if n)
+        for index in range(first, last + 1):
+            bar = '#' * ((histogram[index] * 40 + peak - 1) // peak)
+            out.write('  >= %10.1f us %6d %s\n'
+                      % (bucket_label(index, stats['clock']) if index else 0.0,
+                         histogram[index], bar))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--bus', type=int, required=True, help='the /dev/i2c-<bus> number')
+    parser.add_argument('--address', type=lambda v: int(v, 0), default=0x08,
+                        help='the I2C address of App0 (default 0x08)')
+    parser.add_argument('--crc', action='store_true', help='the device uses CY_DFU_OPT_PACKET_CRC')
+    parser.add_argument('--clear', action='store_true', help='clear the figures once read')
+    parser.add_argument('--json', action='store_true', help='print JSON instead of a table')
+    args = parser.parse_args()
+
+    link = dfu_packet.I2cLink(args.bus, args.address)
+    try:
+        profile = {}
+        for phase, name in enumerate(PHASES):
+            data = bytes([phase, 1 if args.clear else 0])
+            profile[name] = decode(dfu_packet.command(link, DFU_CMD_PROFILE, data, args.crc))
+    except dfu_packet.DfuError as error:
+        sys.exit('dfu_profile: %s' % error)
+    finally:
+        link.close()
+
+    if args.json:
+        json.dump(profile, sys.stdout, indent=2)
+        sys.stdout.write('\n')
+    else:
+        render(profile)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+"""Programs a .cyacd2 image with the DFU protocol, the host side of App0.
+
+The image is read line by line, not loaded whole, and a thread builds the
+packets of the next rows while the link transfers the current one, so the
+link does not wait for the host. The sequence is the one of the DFU host
+tool: Enter, Set Application Metadata, Set EI Vector for an encrypted image,
+Send Data and Program Data for each row, Verify Application and Exit.
+
+The report has the image bytes/s and rows/s of the rows, the link bytes/s
+and the latency of each command, e.g.:
+
+    python3 tools/dfu_program.py --bus 1 mtb_dfu_basic_app1.cyacd2
+    python3 tools/dfu_program.py --serial /dev/ttyACM0 --baud 1000000 app.cyacd2
+    python3 tools/dfu_program.py --socket localhost:5000 app.cyacd2 --json
+"""
+
+import argparse
+import json
+import queue
+import struct
+import sys
+import threading
+import time
+
+import dfu_packet
+
+CMD_VERIFY_APP = 0x31
+CMD_SEND_DATA = 0x37
+CMD_ENTER = 0x38
+CMD_EXIT = 0x3B
+CMD_PROGRAM_DATA = 0x49
+CMD_SET_METADATA = 0x4C
+CMD_SET_EIVECTOR = 0x4D
+
+NAMES = {
+    CMD_VERIFY_APP: 'verify app',
+    CMD_SEND_DATA: 'send data',
+    CMD_ENTER: 'enter',
+    CMD_PROGRAM_DATA: 'program data',
+    CMD_SET_METADATA: 'set app metadata',
+    CMD_SET_EIVECTOR: 'set EI vector',
+}
+
+# The address and the CRC-32C of the row, ahead of the data of Program Data
+PROGRAM_HEADER = 8
+
+# The rows built ahead of the link
+AHEAD = 8
+
+
+class Cyacd2:
+    """A .cyacd2 image, read line by line.
+
+    The first line is the header: the file version, the silicon ID, the
+    silicon revision, the packet checksum type, the application and the
+    product ID, big endian. Then @APPINFO has the start and the length of
+    the application, @EIV the initial vector of an encrypted image, and
+    each ':' line the address, little endian, and the data of a row.
+    """
+
+    def __init__(self, path):
+        self.file = open(path, 'r')
+        self.number = 1
+        header = bytes.fromhex(self.file.readline().strip())
+        if len(header) < 12 or header[0] != 1:
+            raise ValueError('%s: not a version 1 .cyacd2 header' % path)
+        self.silicon_id, self.silicon_rev, self.crc, self.app, self.product_id = \
+            struct.unpack_from('>IBBBI', header, 1)
+        self.app_start = None
+        self.app_length = None
+        self.eiv = None
+        self.pending = None
+        # The @ lines come before the rows
+        for line in self.file:
+            self.number += 1
+            line = line.strip()
+            if line.startswith('@APPINFO:'):
+                start, length = line[len('@APPINFO:'):].split(',')
+                self.app_start, self.app_length = int(start, 0), int(length, 0)
+            elif line.startswith('@EIV:'):
+                self.eiv = bytes.fromhex(line[len('@EIV:'):])
+            elif line:
+                self.pending = line
+                break
+        if self.app_start is None:
+            raise ValueError('%s: no @APPINFO' % path)
+
+    def close(self):
+        self.file.close()
+
+    def rows(self):
+        """Yields the address and the data of each row."""
+        line = self.pending
+        while line is not None:
+            if line:
+                if line[0] != ':':
+                    raise ValueError('line %d: not a row' % self.number)
+                row = bytes.fromhex(line[1:])
+                yield struct.unpack_from('<I', row)[0], row[4:]
+            line = self.file.readline()
+            self.number += 1
+            line = line.strip() if line else None
+
+
+def row_packets(address, data, packet_size, crc):
+    """Returns the packets of a row: Send Data for the head of the data, and
+    Program Data with the rest, each up to packet_size bytes."""
+    send_max = packet_size - dfu_packet.OVERHEAD
+    program_max = send_max - PROGRAM_HEADER
+    packets = []
+    offset = 0
+    while len(data) - offset > program_max:
+        size = min(send_max, len(data) - offset - program_max)
+        packets.append((CMD_SEND_DATA, dfu_packet.build(CMD_SEND_DATA, data[offset:offset + size], crc)))
+        offset += size
+    program = struct.pack('<II', address, dfu_packet.crc32c(data)) + data[offset:]
+    packets.append((CMD_PROGRAM_DATA, dfu_packet.build(CMD_PROGRAM_DATA, program, crc)))
+    return packets
+
+
+def builder(image, packet_size, rows):
+    """The thread that builds the packets of the rows ahead of the link."""
+    try:
+        for address, data in image.rows():
+            rows.put((address, len(data), row_packets(address, data, packet_size, image.crc)))
+        rows.put(None)
+    except ValueError as error:
+        rows.put(error)
+
+
+class Programmer:
+    """Sends the commands and keeps their latency."""
+
+    def __init__(self, link, crc, size, clock):
+        self.link = link
+        self.crc = crc
+        self.size = size
+        self.clock = clock
+        self.latency = {}
+        self.link_bytes = 0
+
+    def transfer(self, cmd, packet):
+        """Sends a built packet and returns the response data."""
+        start = self.clock()
+        response = self.link.transfer(packet, self.size)
+        self.latency.setdefault(cmd, []).append(self.clock() - start)
+        status, data = dfu_packet.parse(response, self.crc)
+        self.link_bytes += len(packet) + len(data) + dfu_packet.OVERHEAD
+        if status != 0:
+            raise dfu_packet.DfuError('%s: %s' % (NAMES.get(cmd, '0x%02X' % cmd),
+                                                  dfu_packet.STATUS.get(status, '0x%02X' % status)))
+        return data
+
+    def command(self, cmd, data=b''):
+        return self.transfer(cmd, dfu_packet.build(cmd, data, self.crc))
+
+
+def program(link, image, args, clock=time.perf_counter):
+    """Programs the image, returns the figures of the report. The clock
+    returns the time in seconds, e.g. the simulated time of dfu_bench.py."""
+    prog = Programmer(link, image.crc, args.packet_size, clock)
+    phases = {}
+
+    start = clock()
+    device = prog.command(CMD_ENTER, struct.pack('<I', image.product_id))
+    silicon_id, silicon_rev = struct.unpack_from('<IB', device)
+    if not args.force and (silicon_id, silicon_rev) != (image.silicon_id, image.silicon_rev):
+        raise dfu_packet.DfuError('the device is 0x%08X rev 0x%02X, the image for 0x%08X rev 0x%02X'
+                                  % (silicon_id, silicon_rev, image.silicon_id, image.silicon_rev))
+    prog.command(CMD_SET_METADATA, struct.pack('<BII', image.app, image.app_start, image.app_length))
+    if image.eiv is not None:
+        prog.command(CMD_SET_EIVECTOR, image.eiv)
+    phases['enter'] = clock() - start
+
+    rows = queue.Queue(AHEAD)
+    thread = threading.Thread(target=builder, args=(image, args.packet_size, rows), daemon=True)
+    thread.start()
+    count = 0
+    data_bytes = 0
+    start = clock()
+    while True:
+        row = rows.get()
+        if row is None:
+            break
+        if isinstance(row, ValueError):
+            raise row
+        address, size, packets = row
+        for cmd, packet in packets:
+            try:
+                prog.transfer(cmd, packet)
+            except dfu_packet.DfuError as error:
+                raise dfu_packet.DfuError('row 0x%08X: %s' % (address, error))
+        count += 1
+        data_bytes += size
+        if args.progress:
+            sys.stderr.write('\r%d rows, %d bytes' % (count, data_bytes))
+    if args.progress:
+        sys.stderr.write('\n')
+    phases['rows'] = clock() - start
+
+    start = clock()
+    if prog.command(CMD_VERIFY_APP, bytes([image.app]))[:1] != b'\x01':
+        raise dfu_packet.DfuError('the application %d is not valid' % image.app)
+    link.write(dfu_packet.build(CMD_EXIT, b'', image.crc))
+    phases['verify'] = clock() - start
+
+    seconds = phases['rows']
+    total = sum(phases.values())
+    return {
+        'app': image.app,
+        'rows': count,
+        'bytes': data_bytes,
+        'seconds': total,
+        'phases': phases,
+        'bytes_per_s': data_bytes / seconds if seconds else 0.0,
+        'rows_per_s': count / seconds if seconds else 0.0,
+        'link_bytes_per_s': prog.link_bytes / total if total else 0.0,
+        'latency_ms': {NAMES[cmd]: latency_stats(values) for cmd, values in prog.latency.items()},
+    }
+
+
+def latency_stats(values):
+    """Returns the count, min, mean, p50, p99 and max of the latency, in ms."""
+    ordered = sorted(values)
+    pick = lambda q: ordered[min(len(ordered) - 1, int(q * len(ordered)))] * 1000.0
+    return {
+        'count': len(ordered),
+        'min': ordered[0] * 1000.0,
+        'mean': sum(ordered) / len(ordered) * 1000.0,
+        'p50': pick(0.50),
+        'p99': pick(0.99),
+        'max': ordered[-1] * 1000.0,
+    }
+
+
+def render(report, out=sys.stdout):
+    """Prints the report."""
+    out.write('app %d: %d rows, %d bytes in %.2f s (enter %.3f s, rows %.2f s, verify %.3f s)\n'
+              % (report['app'], report['rows'], report['bytes'], report['seconds'],
+                 report['phases']['enter'], report['phases']['rows'], report['phases']['verify']))
+    out.write('%.0f bytes/s, %.1f rows/s, link %.0f bytes/s\n\n'
+              % (report['bytes_per_s'], report['rows_per_s'], report['link_bytes_per_s']))
+    out.write('%-17s %7s %8s %8s %8s %8s %8s\n' % ('latency ms', 'count', 'min', 'mean', 'p50', 'p99', 'max'))
+    for name, stats in report['latency_ms'].items():
+        out.write('%-17s %7d %8.2f %8.2f %8.2f %8.2f %8.2f\n'
+                  % (name, stats['count'], stats['min'], stats['mean'], stats['p50'], stats['p99'], stats['max']))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('image', help='the .cyacd2 file, e.g. mtb_dfu_basic_app1.cyacd2')
+    dfu_packet.add_link_arguments(parser)
+    parser.add_argument('--packet-size', type=int, default=64,
+                        help='the largest packet of the device (default 64, 128 with DFU_BOOT_SINGLE_BUFFER)')
+    parser.add_argument('--force', action='store_true', help='do not check the silicon ID of the device')
+    parser.add_argument('--progress', action='store_true', help='print the rows sent to stderr')
+    parser.add_argument('--json', action='store_true', help='print JSON instead of a table')
+    args = parser.parse_args()
+
+    if args.packet_size <= dfu_packet.OVERHEAD + PROGRAM_HEADER:
+        parser.error('--packet-size must be more than %d' % (dfu_packet.OVERHEAD + PROGRAM_HEADER))
+
+    try:
+        image = Cyacd2(args.image)
+        try:
+            link = dfu_packet.open_link(args)
+            try:
+                report = program(link, image, args)
+            finally:
+                link.close()
+        finally:
+            image.close()
+    except (dfu_packet.DfuError, ValueError, OSError) as error:
+        sys.exit('dfu_program: %s' % error)
+
+    if args.json:
+        json.dump(report, sys.stdout, indent=2)
+        sys.stdout.write('\n')
+    else:
+        render(report)
+
+
+if __name__ == '__main__':
+    main()
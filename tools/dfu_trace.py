@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Reads and decodes the DFU trace of App0 (DFU_BOOT_TRACE).
+
+The custom command 0x56 returns the events of the ring, see
+mtb_dfu_basic_common/dfu_trace.h. The ring may also be decoded from a RAM
+dump, e.g. after a halt, of the 520 bytes at 0x08000100 (the
+.cy_boot_noinit.trace section):
+
+    python3 tools/dfu_trace.py --bus 1
+    python3 tools/dfu_trace.py --dump trace.bin --json
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+import dfu_packet
+
+DFU_CMD_TRACE = 0x56
+
+EVENTS = 64
+MAGIC = 0x54524345
+
+# dfu_trace_t: magic and next, then the events
+HEADER = struct.Struct('<II')
+
+# dfu_trace_event_t: time, event, arg and code
+EVENT = struct.Struct('<IBBH')
+
+STATES = {0: 'none', 1: 'updating', 2: 'finished', 3: 'failed'}
+
+TIMERS = {0: 'session', 1: 'idle'}
+
+COMMANDS = {
+    0x31: 'verify app',
+    0x35: 'sync',
+    0x37: 'send data',
+    0x38: 'enter',
+    0x3B: 'exit',
+    0x3C: 'get metadata',
+    0x44: 'erase data',
+    0x47: 'send data no response',
+    0x49: 'program data',
+    0x4A: 'verify data',
+    0x4C: 'set app metadata',
+    0x4D: 'set EI vector',
+}
+
+RESETS = {
+    0x0001: 'WDT',
+    0x0002: 'active fault',
+    0x0004: 'DeepSleep fault',
+    0x0010: 'software',
+    0x0020: 'MCWDT0',
+    0x0040: 'MCWDT1',
+    0x0080: 'MCWDT2',
+    0x0100: 'MCWDT3',
+}
+
+
+def status_name(code):
+    """Returns the name of the status byte of a status code."""
+    if code == 0:
+        return 'success'
+    return dfu_packet.STATUS.get(code & 0xFF, '0x%04X' % code)
+
+
+def describe(event, arg, code):
+    """Returns the name and the details of an event."""
+    if event == 1:
+        resets = [name for bit, name in RESETS.items() if code & bit]
+        return 'start', 'app %d, reset %s' % (arg, ', '.join(resets) or 'power up')
+    if event == 2:
+        return 'state', '%s, %s' % (STATES.get(arg, arg), status_name(code))
+    if event == 3:
+        return 'command', '%s (0x%02X), %s' % (COMMANDS.get(arg, 'custom'), arg, status_name(code))
+    if event == 4:
+        return 'timeout', TIMERS.get(arg, str(arg))
+    if event == 5:
+        return 'restart', 'in %s, %s' % (STATES.get(arg, arg), status_name(code))
+    if event == 6:
+        return 'halt', 'in %s, %s' % (STATES.get(arg, arg), status_name(code))
+    if event == 7:
+        return 'execute', 'app %d' % arg
+    return 'event %d' % event, 'arg 0x%02X, code 0x%04X' % (arg, code)
+
+
+def decode(number, raw):
+    """Returns an event from its 8 bytes."""
+    time, event, arg, code = EVENT.unpack(raw)
+    name, details = describe(event, arg, code)
+    return {'number': number, 'time_ms': time, 'event': name, 'details': details,
+            'raw': {'event': event, 'arg': arg, 'code': code}}
+
+
+def read_device(link, crc):
+    """Returns the events of the ring, read with DFU_CMD_TRACE."""
+    events = []
+    first = 0
+    while True:
+        data = dfu_packet.command(link, DFU_CMD_TRACE, struct.pack('<I', first), crc)
+        last, first = HEADER.unpack(data[:HEADER.size])
+        body = data[HEADER.size:]
+        for index in range(len(body) // EVENT.size):
+            events.append(decode(first + index, body[index * EVENT.size:(index + 1) * EVENT.size]))
+        first += len(body) // EVENT.size
+        if first == last or not body:
+            return events
+
+
+def read_dump(data):
+    """Returns the events of the ring, from a dump of dfu_trace_t."""
+    if len(data) < HEADER.size + EVENTS * EVENT.size:
+        raise ValueError('the dump is %d bytes, the ring %d'
+                         % (len(data), HEADER.size + EVENTS * EVENT.size))
+    magic, last = HEADER.unpack(data[:HEADER.size])
+    if magic != MAGIC:
+        raise ValueError('no trace in the dump, magic 0x%08X' % magic)
+    events = []
+    for number in range(max(0, last - EVENTS), last):
+        offset = HEADER.size + (number % EVENTS) * EVENT.size
+        events.append(decode(number, data[offset:offset + EVENT.size]))
+    return events
+
+
+def render(events, out=sys.stdout):
+    """Prints the events, oldest first."""
+    out.write('%8s %10s  %-8s %s\n' % ('#', 'time ms', 'event', 'details'))
+    for event in events:
+        if event['event'] == 'start':
+            out.write('\n')
+        out.write('%8d %10d  %-8s %s\n'
+                  % (event['number'], event['time_ms'], event['event'], event['details']))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--bus', type=int, help='the /dev/i2c-<bus> number')
+    source.add_argument('--dump', help='a binary dump of the ring, from 0x08000100')
+    parser.add_argument('--address', type=lambda v: int(v, 0), default=0x08,
+                        help='the I2C address of App0 (default 0x08)')
+    parser.add_argument('--crc', action='store_true', help='the device uses CY_DFU_OPT_PACKET_CRC')
+    parser.add_argument('--json', action='store_true', help='print JSON instead of a table')
+    args = parser.parse_args()
+
+    try:
+        if args.dump:
+            with open(args.dump, 'rb') as dump:
+                events = read_dump(dump.read())
+        else:
+            link = dfu_packet.I2cLink(args.bus, args.address)
+            try:
+                events = read_device(link, args.crc)
+            finally:
+                link.close()
+    except (dfu_packet.DfuError, ValueError, OSError) as error:
+        sys.exit('dfu_trace: %s' % error)
+
+    if args.json:
+        json.dump(events, sys.stdout, indent=2)
+        sys.stdout.write('\n')
+    else:
+        render(events)
+
+
+if __name__ == '__main__':
+    main()
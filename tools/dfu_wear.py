@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Reads the flash wear counters of App0 (DFU_BOOT_WEAR).
+
+The custom command 0x57 returns the counters of a region, a
+dfu_wear_counters_t of mtb_dfu_basic_common/dfu_wear.h, and the number of
+commits of the counters. E.g.:
+
+    python3 tools/dfu_wear.py --bus 1
+    python3 tools/dfu_wear.py --bus 1 --json
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+import dfu_packet
+
+DFU_CMD_WEAR = 0x57
+
+ROW_SIZE = 512
+
+# The regions, in the order of dfu_wear.h, with their size in the linker
+# scripts, None when the region is not one range
+REGIONS = [
+    ('app1 core0', 0x10000),
+    ('app1 core1', 0x10000),
+    ('app2 core0', 0x10000),
+    ('app2 core1', 0x10000),
+    ('metadata', 0xE00),
+    ('eeprom', 0x8000),
+    ('other', None),
+]
+
+# dfu_wear_counters_t: writes, erases, skipped, failures and busyUs, then commits
+COUNTERS = struct.Struct('<IIIIQI')
+
+
+def decode(payload, size):
+    """Returns the counters of a region from the response data."""
+    writes, erases, skipped, failures, busy_us, commits = COUNTERS.unpack(payload[:COUNTERS.size])
+    return {
+        'writes': writes,
+        'erases': erases,
+        'skipped': skipped,
+        'failures': failures,
+        'busy_ms': busy_us / 1000.0,
+        'mean_write_ms': busy_us / 1000.0 / writes if writes else 0.0,
+        'writes_per_row': writes / (size // ROW_SIZE) if size else None,
+        'commits': commits,
+    }
+
+
+def render(wear, out=sys.stdout):
+    """Prints a table of the regions."""
+    out.write('%-11s %9s %8s %8s %8s %11s %9s %9s\n'
+              % ('region', 'writes', 'erases', 'skipped', 'failed', 'busy ms', 'ms/write', 'per row'))
+    for name, counters in wear.items():
+        per_row = counters['writes_per_row']
+        out.write('%-11s %9d %8d %8d %8d %11.1f %9.2f %9s\n'
+                  % (name, counters['writes'], counters['erases'], counters['skipped'],
+                     counters['failures'], counters['busy_ms'], counters['mean_write_ms'],
+                     '-' if per_row is None else '%.2f' % per_row))
+    commits = next(iter(wear.values()))['commits'] if wear else 0
+    out.write('\n%d commits\n' % commits)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--bus', type=int, required=True, help='the /dev/i2c-<bus> number')
+    parser.add_argument('--address', type=lambda v: int(v, 0), default=0x08,
+                        help='the I2C address of App0 (default 0x08)')
+    parser.add_argument('--crc', action='store_true', help='the device uses CY_DFU_OPT_PACKET_CRC')
+    parser.add_argument('--json', action='store_true', help='print JSON instead of a table')
+    args = parser.parse_args()
+
+    link = dfu_packet.I2cLink(args.bus, args.address)
+    try:
+        wear = {}
+        for region, (name, size) in enumerate(REGIONS):
+            wear[name] = decode(dfu_packet.command(link, DFU_CMD_WEAR, bytes([region]), args.crc), size)
+    except dfu_packet.DfuError as error:
+        sys.exit('dfu_wear: %s' % error)
+    finally:
+        link.close()
+
+    if args.json:
+        json.dump(wear, sys.stdout, indent=2)
+        sys.stdout.write('\n')
+    else:
+        render(wear)
+
+
+if __name__ == '__main__':
+    main()